@@ -54,6 +54,8 @@ public:
     QQmlEngine *m_qmlEngine = nullptr;
     DockWidgetFactoryFunc m_dockWidgetFactoryFunc = nullptr;
     MainWindowFactoryFunc m_mainWindowFactoryFunc = nullptr;
+    GuestHibernateFunc m_guestHibernateFunc = nullptr;
+    GuestFactoryFunc m_guestFactoryFunc = nullptr;
     TabbingAllowedFunc m_tabbingAllowedFunc = nullptr;
     DropIndicatorAllowedFunc m_dropIndicatorAllowedFunc = nullptr;
     FrameworkWidgetFactory *m_frameworkWidgetFactory = nullptr;
@@ -62,9 +64,21 @@ public:
     CustomizableWidgets m_disabledPaintEvents = CustomizableWidget_None;
     qreal m_draggedWindowOpacity = Q_QNAN;
     int m_mdiPopupThreshold = 250;
+    int m_maxPlaceholdersPerDockWidget = 0;
+    int m_maxPlaceholderAge = 0;
+    int m_guestHibernationIdleTime = 0;
+    int m_maxAwakeGuests = 0;
+    int m_coalescedLayoutResizeTolerance = 0;
+#ifdef DOCKS_DEVELOPER_MODE
+    int m_layoutSanityCheckInterval = 1;
+#else
+    int m_layoutSanityCheckInterval = 0;
+#endif
     bool m_dropIndicatorsInhibited = false;
+    bool m_coalescedLayoutResize = false;
 #ifdef KDDOCKWIDGETS_QTQUICK
     QtQuickHelpers m_qquickHelpers;
+    bool m_asyncFrameIncubation = false;
 #endif
 };
 
@@ -262,6 +276,16 @@ QQmlEngine *Config::qmlEngine() const
 
     return d->m_qmlEngine;
 }
+
+void Config::setAsyncFrameIncubation(bool async)
+{
+    d->m_asyncFrameIncubation = async;
+}
+
+bool Config::asyncFrameIncubation() const
+{
+    return d->m_asyncFrameIncubation;
+}
 #endif
 
 void Config::Private::fixFlags()
@@ -298,6 +322,11 @@ void Config::Private::fixFlags()
     }
 #endif
 
+#ifdef KDDOCKWIDGETS_QTQUICK
+    // QtQuick separators are always QQuickItems
+    m_flags = m_flags & ~Flag_VirtualSeparators;
+#endif
+
 #if (!defined(Q_OS_WIN) && !defined(Q_OS_MACOS))
     // QtQuick doesn't support AeroSnap yet. Some problem with the native events not being received...
     m_flags = m_flags & ~Flag_AeroSnapWithClientDecos;
@@ -356,4 +385,81 @@ bool Config::dropIndicatorsInhibited() const
     return d->m_dropIndicatorsInhibited;
 }
 
+void Config::setPlaceholderCompactionPolicy(int maxPerDockWidget, int maxAgeMSecs)
+{
+    d->m_maxPlaceholdersPerDockWidget = qMax(0, maxPerDockWidget);
+    d->m_maxPlaceholderAge = qMax(0, maxAgeMSecs);
+    DockRegistry::self()->updatePlaceholderCompactionTimer();
+}
+
+int Config::maxPlaceholdersPerDockWidget() const
+{
+    return d->m_maxPlaceholdersPerDockWidget;
+}
+
+int Config::maxPlaceholderAge() const
+{
+    return d->m_maxPlaceholderAge;
+}
+
+void Config::setLayoutSanityCheckInterval(int interval)
+{
+    d->m_layoutSanityCheckInterval = qMax(0, interval);
+}
+
+int Config::layoutSanityCheckInterval() const
+{
+    return d->m_layoutSanityCheckInterval;
+}
+
+void Config::setCoalescedLayoutResize(bool enabled, int guestTolerance)
+{
+    d->m_coalescedLayoutResize = enabled;
+    d->m_coalescedLayoutResizeTolerance = qMax(0, guestTolerance);
+}
+
+bool Config::coalescedLayoutResize() const
+{
+    return d->m_coalescedLayoutResize;
+}
+
+int Config::coalescedLayoutResizeTolerance() const
+{
+    return d->m_coalescedLayoutResizeTolerance;
+}
+
+void Config::setGuestHibernationFuncs(GuestHibernateFunc hibernate, GuestFactoryFunc factory)
+{
+    d->m_guestHibernateFunc = hibernate;
+    d->m_guestFactoryFunc = factory;
+    DockRegistry::self()->updateGuestHibernationTimer();
+}
+
+GuestHibernateFunc Config::guestHibernateFunc() const
+{
+    return d->m_guestHibernateFunc;
+}
+
+GuestFactoryFunc Config::guestFactoryFunc() const
+{
+    return d->m_guestFactoryFunc;
+}
+
+void Config::setGuestHibernationPolicy(int idleMSecs, int maxAwakeGuests)
+{
+    d->m_guestHibernationIdleTime = qMax(0, idleMSecs);
+    d->m_maxAwakeGuests = qMax(0, maxAwakeGuests);
+    DockRegistry::self()->updateGuestHibernationTimer();
+}
+
+int Config::guestHibernationIdleTime() const
+{
+    return d->m_guestHibernationIdleTime;
+}
+
+int Config::maxAwakeGuests() const
+{
+    return d->m_maxAwakeGuests;
+}
+
 }
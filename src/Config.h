@@ -27,6 +27,7 @@
 QT_BEGIN_NAMESPACE
 class QQmlEngine;
 class QSize;
+class QVariant;
 QT_END_NAMESPACE
 
 namespace KDDockWidgets {
@@ -39,6 +40,17 @@ class DropArea;
 typedef KDDockWidgets::DockWidgetBase *(*DockWidgetFactoryFunc)(const QString &name);
 typedef KDDockWidgets::MainWindowBase *(*MainWindowFactoryFunc)(const QString &name);
 
+/// @brief Function called before a hibernated guest widget is deleted. See Config::setGuestHibernationFuncs()
+/// @param dockWidget the dock widget whose guest is about to be deleted
+/// @return Whatever state is needed to recreate the guest later. It's handed back to GuestFactoryFunc.
+typedef QVariant (*GuestHibernateFunc)(KDDockWidgets::DockWidgetBase *dockWidget);
+
+/// @brief Function called to recreate a hibernated guest widget. See Config::setGuestHibernationFuncs()
+/// It should create the guest and pass it to DockWidgetBase::setWidget().
+/// @param dockWidget the dock widget which is becoming visible again
+/// @param state the value GuestHibernateFunc returned
+typedef void (*GuestFactoryFunc)(KDDockWidgets::DockWidgetBase *dockWidget, const QVariant &state);
+
 /// @brief Function to allow more granularity to disallow where widgets are dropped
 ///
 /// By default, widgets can be dropped to the outer and inner left/right/top/bottom
@@ -106,6 +118,7 @@ public:
         Flag_CloseOnlyCurrentTab = 0x20000, ///< The TitleBar's close button will only close the current tab, instead of all of them
         Flag_ShowButtonsOnTabBarIfTitleBarHidden = 0x40000, ///< When using Flag_HideTitleBarWhenTabsVisible the close/float buttons disappear with the title bar. With Flag_ShowButtonsOnTabBarIfHidden they'll be shown in the tab bar.
         Flag_AllowSwitchingTabsViaMenu = 0x80000, ///< Allow switching tabs via a context menu when right clicking on the tab area
+        Flag_VirtualSeparators = 0x100000, ///< QtWidgets only. Separators aren't widgets, they're painted and hit-tested by the layout itself. Reduces overhead for layouts with very many separators.
         Flag_Default = Flag_AeroSnapWithClientDecos ///< The defaults
     };
     Q_DECLARE_FLAGS(Flags, Flag)
@@ -317,10 +330,66 @@ public:
     void setMDIPopupThreshold(int);
     int mdiPopupThreshold() const;
 
+    /// @brief Sets the policy for pruning placeholders of closed dock widgets.
+    /// A placeholder remembers where a closed dock widget was, so it can be restored there. In
+    /// long running sessions they can pile up, making the layout slower.
+    /// @param maxPerDockWidget The maximum number of placeholders each dock widget keeps. The least recently occupied are pruned first.
+    /// @param maxAgeMSecs Placeholders which weren't occupied for this long are pruned.
+    /// 0 means no limit, which is the default for both. Pruning runs periodically while a limit is set.
+    /// @sa DockRegistry::compactPlaceholders()
+    void setPlaceholderCompactionPolicy(int maxPerDockWidget, int maxAgeMSecs);
+    int maxPlaceholdersPerDockWidget() const;
+    int maxPlaceholderAge() const;
+
+    /// @brief Sets how often saving a layout runs the structural sanity check over all main windows.
+    /// 0 disables it, 1 checks on every save and N checks on every Nth save. A successful check is
+    /// cached until the layout changes. Dock widget and main window name clashes are always detected.
+    /// The default is 1 in developer builds and 0 otherwise.
+    void setLayoutSanityCheckInterval(int);
+    int layoutSanityCheckInterval() const;
+
+    /// @brief Sets whether resizing a layout, typically when the user resizes the main window,
+    /// relayouts at most once per display frame instead of once per resize event.
+    /// @param enabled false by default
+    /// @param guestTolerance In the intermediate passes, dock widgets which would move by less than
+    /// this many pixels keep their old geometry. 0 by default.
+    /// The final size is always applied exactly, once the resize settles.
+    void setCoalescedLayoutResize(bool enabled, int guestTolerance = 0);
+    bool coalescedLayoutResize() const;
+    int coalescedLayoutResizeTolerance() const;
+
+    /// @brief Registers the functions used to hibernate and wake up guest widgets.
+    ///
+    /// Apps with many dock widgets usually only have a few of them visible. A hibernated dock widget
+    /// keeps its tab, title and position but its guest widget is deleted, to save memory. It's
+    /// recreated with @p factory once the dock widget becomes visible again.
+    /// Both are nullptr by default, which disables hibernation. See setGuestHibernationPolicy().
+    void setGuestHibernationFuncs(GuestHibernateFunc hibernate, GuestFactoryFunc factory);
+    GuestHibernateFunc guestHibernateFunc() const;
+    GuestFactoryFunc guestFactoryFunc() const;
+
+    /// @brief Sets when guests of dock widgets the user can't see get hibernated.
+    /// Only guests in background tabs, side bars or closed dock widgets are hibernated.
+    /// @param idleMSecs Guests hidden for this long are hibernated.
+    /// @param maxAwakeGuests If more guests than this are alive, the ones hidden for longest are hibernated.
+    /// 0 means no limit, which is the default for both. The policy is applied periodically while a limit is set.
+    /// @sa DockRegistry::hibernateGuests(), DockWidgetBase::isHibernated()
+    void setGuestHibernationPolicy(int idleMSecs, int maxAwakeGuests);
+    int guestHibernationIdleTime() const;
+    int maxAwakeGuests() const;
+
 #ifdef KDDOCKWIDGETS_QTQUICK
     ///@brief Sets the QQmlEngine to use. Applicable only when using QtQuick.
     void setQmlEngine(QQmlEngine *);
     QQmlEngine *qmlEngine() const;
+
+    ///@brief Sets whether the QML of each Frame is instantiated asynchronously, with QQmlIncubator.
+    /// Keeps the GUI thread responsive when creating many frames, for example when restoring a big layout.
+    /// Frames are usable right away, but only appear once their QML is ready.
+    /// Requires the QML engine to have an incubation controller, which QQuickWindow provides,
+    /// otherwise creation stays synchronous. By default this is false.
+    void setAsyncFrameIncubation(bool);
+    bool asyncFrameIncubation() const;
 #endif
 
 private:
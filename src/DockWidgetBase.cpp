@@ -22,6 +22,7 @@
 #include "private/Utils_p.h"
 #include "private/WindowBeingDragged_p.h"
 #include "private/Position_p.h"
+#include "private/multisplitter/PerfCounters_p.h"
 
 #include "Config.h"
 #include "FrameworkWidgetFactory.h"
@@ -72,7 +73,7 @@ void DockWidgetBase::addDockWidgetAsTab(DockWidgetBase *other, InitialOption opt
         return;
     }
 
-    if (!DockRegistry::self()->affinitiesMatch(other->affinities(), d->affinities)) {
+    if (!other->d->affinitySet.matches(d->affinitySet)) {
         qWarning() << Q_FUNC_INFO << "Refusing to dock widget with incompatible affinity."
                    << other->affinities() << affinities();
         return;
@@ -124,7 +125,7 @@ void DockWidgetBase::addDockWidgetToContainingWindow(DockWidgetBase *other,
         return;
     }
 
-    if (!DockRegistry::self()->affinitiesMatch(other->affinities(), d->affinities)) {
+    if (!other->d->affinitySet.matches(d->affinitySet)) {
         qWarning() << Q_FUNC_INFO << "Refusing to dock widget with incompatible affinity."
                    << other->affinities() << affinities();
         return;
@@ -156,9 +157,14 @@ void DockWidgetBase::setWidget(QWidgetOrQuick *w)
     }
 
     d->widget = w;
-    if (w)
+    if (w) {
         setSizePolicy(w->sizePolicy());
 
+        // A new guest, from the factory or from the app, supersedes the hibernated one
+        d->m_isHibernated = false;
+        d->m_hibernatedState.clear();
+    }
+
     Q_EMIT widgetChanged(w);
 }
 
@@ -409,8 +415,8 @@ void DockWidgetBase::raise()
         fw->raise();
         fw->activateWindow();
     } else if (Frame *frame = d->frame()) {
-        if (frame->isMDI())
-            frame->raise();
+        if (MDILayoutWidget *mdi = frame->mdiLayoutWidget())
+            mdi->raiseDockWidget(frame);
     }
 }
 
@@ -456,6 +462,7 @@ void DockWidgetBase::setAffinities(const QStringList &affinityNames)
     }
 
     d->affinities = affinities;
+    d->affinitySet = AffinitySet(affinities);
 }
 
 void DockWidgetBase::moveToSideBar()
@@ -482,6 +489,16 @@ bool DockWidgetBase::isInSideBar() const
     return sideBarLocation() != SideBarLocation::None;
 }
 
+DockWidgetBase::RenderVisibility DockWidgetBase::renderVisibility() const
+{
+    return d->m_renderVisibility;
+}
+
+bool DockWidgetBase::isHibernated() const
+{
+    return d->m_isHibernated;
+}
+
 bool DockWidgetBase::hasPreviousDockedLocation() const
 {
     return d->m_lastPosition->isValid();
@@ -798,6 +815,105 @@ void DockWidgetBase::Private::maybeRestoreToPreviousPosition()
     restoreToPreviousPosition();
 }
 
+DockWidgetBase::RenderVisibility DockWidgetBase::Private::computeRenderVisibility() const
+{
+    if (!q->isOverlayed() && q->isInSideBar())
+        return RenderVisibility::SideBarHidden;
+
+    if (!q->isOpen())
+        return RenderVisibility::Closed;
+
+    if (Frame *frame = this->frame()) {
+        if (frame->currentDockWidget() != q)
+            return RenderVisibility::TabHidden;
+    }
+
+    if (KDDockWidgets::Private::isMinimized(q))
+        return RenderVisibility::Minimized;
+
+    if (!q->isVisible()) // For example, its window is hidden
+        return RenderVisibility::Closed;
+
+    // Docked widgets are only covered by floating windows, which we can't tell apart from merely
+    // intersecting. Only consider floating ones, otherwise any floating window would pause them.
+    DockRegistry *registry = DockRegistry::self();
+    QWindow *window = KDDockWidgets::Private::windowForWidget(q);
+    if (window && !registry->mainWindowForHandle(window)
+        && registry->isProbablyObscured(window, static_cast<FloatingWindow *>(nullptr)))
+        return RenderVisibility::ProbablyObscured;
+
+    return RenderVisibility::Visible;
+}
+
+void DockWidgetBase::Private::updateRenderVisibility()
+{
+    const RenderVisibility visibility = computeRenderVisibility();
+    if (visibility != m_renderVisibility) {
+        m_renderVisibility = visibility;
+
+        switch (visibility) {
+        case RenderVisibility::Closed:
+        case RenderVisibility::TabHidden:
+        case RenderVisibility::SideBarHidden:
+            if (!m_hiddenTimer.isValid())
+                m_hiddenTimer.start();
+            break;
+        case RenderVisibility::Visible:
+        case RenderVisibility::Minimized:
+        case RenderVisibility::ProbablyObscured:
+            m_hiddenTimer.invalidate();
+            wakeUp(); // Before emitting, so the app already sees the guest
+            break;
+        }
+
+        Q_EMIT q->renderVisibilityChanged(visibility);
+    }
+}
+
+bool DockWidgetBase::Private::canHibernate() const
+{
+    return widget && !m_isHibernated && m_hiddenTimer.isValid() && !m_isPersistentCentralDockWidget
+        && !isMDIWrapper();
+}
+
+qint64 DockWidgetBase::Private::hiddenTime() const
+{
+    return m_hiddenTimer.isValid() ? m_hiddenTimer.elapsed() : 0;
+}
+
+bool DockWidgetBase::Private::hibernate()
+{
+    const GuestHibernateFunc hibernateFunc = Config::self().guestHibernateFunc();
+    if (!hibernateFunc || !Config::self().guestFactoryFunc() || !canHibernate())
+        return false;
+
+    const QVariant state = hibernateFunc(q);
+    QWidgetOrQuick *guest = widget;
+    q->setWidget(nullptr);
+    delete guest;
+
+    m_hibernatedState = state;
+    m_isHibernated = true;
+    return true;
+}
+
+void DockWidgetBase::Private::wakeUp()
+{
+    if (!m_isHibernated)
+        return;
+
+    const QVariant state = m_hibernatedState;
+    m_hibernatedState.clear();
+    m_isHibernated = false;
+
+    if (const GuestFactoryFunc factory = Config::self().guestFactoryFunc()) {
+        factory(q, state);
+        Layouting::PerfCounters::increment(Layouting::PerfCounters::Counter_GuestsWokenUp);
+    } else {
+        qWarning() << Q_FUNC_INFO << "No GuestFactoryFunc to recreate the guest of" << name;
+    }
+}
+
 int DockWidgetBase::Private::currentTabIndex() const
 {
     Frame *frame = this->frame();
@@ -832,6 +948,7 @@ void DockWidgetBase::onShown(bool spontaneous)
 {
     d->onDockWidgetShown();
     Q_EMIT shown();
+    d->updateRenderVisibility();
 
     if (Frame *f = d->frame()) {
         if (!spontaneous) {
@@ -849,6 +966,7 @@ void DockWidgetBase::onHidden(bool spontaneous)
 {
     d->onDockWidgetHidden();
     Q_EMIT hidden();
+    d->updateRenderVisibility();
 
     if (Frame *f = d->frame()) {
         if (!spontaneous) {
@@ -893,6 +1011,7 @@ DockWidgetBase *DockWidgetBase::deserialize(const LayoutSaver::DockWidget::Ptr &
             qWarning() << Q_FUNC_INFO << "Affinity name changed from" << dw->affinities()
                        << "; to" << saved->affinities;
             dw->d->affinities = saved->affinities;
+            dw->d->affinitySet = AffinitySet(saved->affinities);
         }
     }
 
@@ -1005,6 +1124,11 @@ DockWidgetBase::Private::Private(const QString &dockName, DockWidgetBase::Option
         }
     });
 
+    q->connect(q, &DockWidgetBase::isOverlayedChanged, this, &Private::updateRenderVisibility);
+    q->connect(q, &DockWidgetBase::removedFromSideBar, this, &Private::updateRenderVisibility);
+
+    m_hiddenTimer.start(); // We start closed
+
     toggleAction->setCheckable(true);
     floatAction->setCheckable(true);
 
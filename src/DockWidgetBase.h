@@ -67,6 +67,8 @@ class DOCKS_EXPORT DockWidgetBase : public QWidget
     Q_PROPERTY(QObject *widget READ widget NOTIFY widgetChanged)
     Q_PROPERTY(KDDockWidgets::DockWidgetBase::Options options READ options WRITE setOptions NOTIFY
                    optionsChanged)
+    Q_PROPERTY(KDDockWidgets::DockWidgetBase::RenderVisibility renderVisibility READ renderVisibility NOTIFY
+                   renderVisibilityChanged)
 public:
     typedef QVector<DockWidgetBase *> List;
 
@@ -99,6 +101,17 @@ public:
     Q_ENUM(IconPlace)
     Q_DECLARE_FLAGS(IconPlaces, IconPlace)
 
+    /// @brief Whether the user can actually see the guest widget. See renderVisibility().
+    enum class RenderVisibility {
+        Visible = 0, ///< Shown, and as far as we know not covered by other windows
+        Closed, ///< The dock widget isn't open
+        TabHidden, ///< It's in a tab group, but another tab is current
+        SideBarHidden, ///< It's in a side bar, and not overlayed
+        Minimized, ///< The window it's in is minimized
+        ProbablyObscured ///< It's floating and might be covered by another window. See DockRegistry::isProbablyObscured()
+    };
+    Q_ENUM(RenderVisibility)
+
     /**
      * @brief constructs a new DockWidget
      * @param uniqueName the name of the dockwidget, should be unique. Use title for user visible text.
@@ -412,6 +425,21 @@ public:
     /// Similar to sideBarLocation(), but returns a bool
     bool isInSideBar() const;
 
+    /// @brief Returns whether the user can actually see the guest widget, and if not, why.
+    ///
+    /// Guests doing expensive rendering (charts, video, 3D) can pause while this isn't
+    /// RenderVisibility::Visible. It's kept up to date by the framework, as tabs change, dock widgets
+    /// move into side bars, or windows get minimized, moved or raised.
+    /// Obscuring is only an approximation, as we can't query the window manager's stacking order.
+    ///
+    /// @sa renderVisibilityChanged()
+    RenderVisibility renderVisibility() const;
+
+    /// @brief Returns whether the guest widget was deleted to save memory while not visible.
+    /// widget() is nullptr while hibernated. The guest is recreated once the dock widget is visible again.
+    /// @sa Config::setGuestHibernationFuncs(), Config::setGuestHibernationPolicy()
+    bool isHibernated() const;
+
     /// @brief Returns whether this floating dock widget knows its previous docked location
     /// Result only makes sense if it's floating.
     ///
@@ -516,6 +544,9 @@ Q_SIGNALS:
     /// @brief Emitted when this dock widget is about to be deleted due to Option_DeleteOnClose
     void aboutToDeleteOnClose();
 
+    ///@brief Emitted when renderVisibility() changes
+    void renderVisibilityChanged(KDDockWidgets::DockWidgetBase::RenderVisibility);
+
 protected:
     void onParentChanged();
     void onShown(bool spontaneous);
@@ -23,25 +23,17 @@
 #include "private/Frame_p.h"
 #include "private/DockRegistry_p.h"
 
-#include <QObject>
-#include <QGuiApplication>
 #include <QPointer>
 
 using namespace KDDockWidgets;
 
-// Our Private inherits from QObject since FocusScope can't (Since Frame is already QObject)
-class FocusScope::Private : public QObject // clazy:exclude=missing-qobject-macro (breaks unity build with earlier cmake due to including .moc here.)
+class FocusScope::Private
 {
 public:
     Private(FocusScope *qq, QWidgetAdapter *thisWidget)
         : q(qq)
         , m_thisWidget(thisWidget)
     {
-        connect(qApp, &QGuiApplication::focusObjectChanged,
-                this, &Private::onFocusObjectChanged);
-
-        onFocusObjectChanged(qApp->focusObject());
-        m_inCtor = false;
     }
 
     /// @brief Returns whether the last focused widget is the tab widget itself
@@ -60,11 +52,9 @@ public:
         return false;
     }
 
-    ~Private() override;
+    ~Private();
 
     void setIsFocused(bool);
-    void onFocusObjectChanged(QObject *);
-    bool isInFocusScope(WidgetType *) const;
 
     FocusScope *const q;
     QWidgetAdapter *const m_thisWidget;
@@ -80,10 +70,14 @@ FocusScope::Private::~Private()
 FocusScope::FocusScope(QWidgetAdapter *thisWidget)
     : d(new Private(this, thisWidget))
 {
+    // Focus changes are tracked centrally, so we don't pay a parent walk per scope
+    DockRegistry::self()->registerFocusScope(this, thisWidget);
+    d->m_inCtor = false;
 }
 
 FocusScope::~FocusScope()
 {
+    DockRegistry::self()->unregisterFocusScope(this, d->m_thisWidget);
     delete d;
 }
 
@@ -129,33 +123,19 @@ void FocusScope::Private::setIsFocused(bool is)
     }
 }
 
-void FocusScope::Private::onFocusObjectChanged(QObject *obj)
+void FocusScope::onFocusObjectEntered(WidgetType *widget)
 {
-    auto widget = qobject_cast<WidgetType *>(obj);
-    if (!widget) {
-        setIsFocused(false);
-        return;
-    }
-
-    const bool is = isInFocusScope(widget);
-    if (is && m_lastFocusedInScope != widget && !qobject_cast<TitleBar *>(obj)) {
-        m_lastFocusedInScope = widget;
-        setIsFocused(is);
-        /* Q_EMIT */ q->focusedWidgetChangedCallback();
+    if (d->m_lastFocusedInScope != widget && !qobject_cast<TitleBar *>(widget)) {
+        d->m_lastFocusedInScope = widget;
+        d->setIsFocused(true);
+        if (!d->m_inCtor)
+            /* Q_EMIT */ focusedWidgetChangedCallback();
     } else {
-        setIsFocused(is);
+        d->setIsFocused(true);
     }
 }
 
-bool FocusScope::Private::isInFocusScope(WidgetType *widget) const
+void FocusScope::onFocusObjectLeft()
 {
-    WidgetType *p = widget;
-    while (p) {
-        if (p == m_thisWidget)
-            return true;
-
-        p = KDDockWidgets::Private::parentWidget(p);
-    }
-
-    return false;
+    d->setIsFocused(false);
 }
@@ -54,6 +54,12 @@ protected:
     virtual void focusedWidgetChangedCallback() = 0;
 
 private:
+    friend class DockRegistry;
+    ///@brief Called by DockRegistry when @p widget, which is inside this scope, got focus
+    void onFocusObjectEntered(WidgetType *widget);
+    ///@brief Called by DockRegistry when focus moved out of this scope
+    void onFocusObjectLeft();
+
     class Private;
     Private *const d;
 };
@@ -28,6 +28,7 @@
 #include "private/widgets/SideBarWidget_p.h"
 #include "private/widgets/TabWidgetWidget_p.h"
 #include "private/multisplitter/Separator_qwidget.h"
+#include "private/multisplitter/VirtualSeparator_qwidget.h"
 #include "private/widgets/FloatingWindowWidget_p.h"
 #include "private/indicators/SegmentedIndicators_p.h"
 
@@ -82,6 +83,9 @@ TabWidget *DefaultWidgetFactory::createTabWidget(Frame *parent, TabWidgetOptions
 
 Layouting::Separator *DefaultWidgetFactory::createSeparator(Layouting::Widget *parent) const
 {
+    if (Config::self().flags() & Config::Flag_VirtualSeparators)
+        return new Layouting::VirtualSeparator(parent);
+
     return new Layouting::SeparatorWidget(parent);
 }
 
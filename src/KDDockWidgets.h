@@ -180,6 +180,30 @@ private:
     DefaultSizeMode sizeMode = DefaultSizeMode::Fair;
 };
 
+/**
+ * @brief RAII class to add or move many dock widgets at once
+ *
+ * While a ChromeUpdateBatch is alive, title bars, float actions, window titles and icons aren't
+ * updated each time a dock widget is added or removed. Each affected window is updated once, when
+ * the outermost batch is destroyed.
+ *
+ * Example:
+ *     {
+ *         ChromeUpdateBatch batch;
+ *         for (DockWidgetBase *dw : docks)
+ *             dock1->addDockWidgetAsTab(dw);
+ *     } // Title bars are updated here
+ */
+class DOCKS_EXPORT ChromeUpdateBatch
+{
+public:
+    ChromeUpdateBatch();
+    ~ChromeUpdateBatch();
+
+private:
+    Q_DISABLE_COPY(ChromeUpdateBatch)
+};
+
 enum RestoreOption {
     RestoreOption_None = 0,
     RestoreOption_RelativeToMainWindow = 1, ///< Skips restoring the main window geometry and the restored dock widgets will use relative sizing.
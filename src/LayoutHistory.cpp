@@ -0,0 +1,672 @@
+/*
+  This file is part of KDDockWidgets.
+
+  SPDX-FileCopyrightText: 2020-2022 Klarälvdalens Datakonsult AB, a KDAB Group company <info@kdab.com>
+  Author: Sérgio Martins <sergio.martins@kdab.com>
+
+  SPDX-License-Identifier: GPL-2.0-only OR GPL-3.0-only
+
+  Contact KDAB at <info@kdab.com> for commercial licensing options.
+*/
+
+/**
+ * @file
+ * @brief Class to undo and redo changes to the dock widget layout.
+ *
+ * @author Sérgio Martins \<sergio.martins@kdab.com\>
+ */
+
+#include "LayoutHistory.h"
+#include "LayoutSaver.h"
+
+#include "private/DockRegistry_p.h"
+#include "private/LayoutSaver_p.h"
+
+#include <QDebug>
+#include <QSet>
+
+#include <algorithm>
+#include <memory>
+
+/**
+ * Some implementation details:
+ *
+ * A snapshot is the same intermediate representation LayoutSaver uses, minus the JSON. Each
+ * window, and each dock widget's last position, is held by a shared_ptr to a const record. When
+ * taking a snapshot, records equal to the ones of the previous snapshot are replaced by those, so
+ * an operation that only touched one floating window costs just that window's record.
+ *
+ * That sharing is also what makes partial restores cheap: before restoring a snapshot we capture
+ * the current state sharing with the snapshot being restored, and any window whose record ends up
+ * being the same pointer doesn't need to be touched.
+ */
+using namespace KDDockWidgets;
+
+namespace {
+
+struct DockWidgetState
+{
+    QString name;
+    std::shared_ptr<const LayoutSaver::Position> lastPosition;
+
+    bool operator==(const DockWidgetState &other) const
+    {
+        return name == other.name && lastPosition == other.lastPosition;
+    }
+};
+
+struct Snapshot
+{
+    QVector<std::shared_ptr<const LayoutSaver::MainWindow>> mainWindows;
+    QVector<std::shared_ptr<const LayoutSaver::FloatingWindow>> floatingWindows;
+    QStringList closedDockWidgets;
+    QVector<DockWidgetState> dockWidgets;
+
+    ///@brief Returns true if both snapshots share all their records
+    bool sharesAllWith(const Snapshot &other) const
+    {
+        return mainWindows == other.mainWindows && floatingWindows == other.floatingWindows
+            && closedDockWidgets == other.closedDockWidgets && dockWidgets == other.dockWidgets;
+    }
+};
+
+template<typename T>
+std::shared_ptr<const T> shareIfEqual(const T &record, const std::shared_ptr<const T> &candidate)
+{
+    if (candidate && *candidate == record)
+        return candidate;
+
+    return std::make_shared<T>(record);
+}
+
+qint64 cost(const QString &str)
+{
+    return qint64(str.size()) * qint64(sizeof(QChar));
+}
+
+qint64 cost(const QStringList &strs)
+{
+    qint64 result = qint64(strs.size()) * qint64(sizeof(QString));
+    for (const QString &str : strs)
+        result += cost(str);
+
+    return result;
+}
+
+qint64 cost(const Layouting::ItemRecord &record)
+{
+    qint64 result = qint64(sizeof(Layouting::ItemRecord)) + cost(record.objectName) + cost(record.guestId);
+    for (const Layouting::ItemRecord &child : record.children)
+        result += cost(child);
+
+    return result;
+}
+
+qint64 cost(const LayoutSaver::MultiSplitter &multiSplitter)
+{
+    qint64 result = cost(multiSplitter.layout);
+    for (const LayoutSaver::Frame &frame : multiSplitter.frames) {
+        result += qint64(sizeof(LayoutSaver::Frame)) + cost(frame.objectName) + cost(frame.id)
+            + cost(frame.mainWindowUniqueName)
+            + qint64(frame.dockWidgets.size()) * qint64(sizeof(LayoutSaver::DockWidget::Ptr));
+    }
+
+    return result;
+}
+
+qint64 cost(const LayoutSaver::MainWindow &mainWindow)
+{
+    qint64 result = qint64(sizeof(LayoutSaver::MainWindow)) + cost(mainWindow.multiSplitterLayout)
+        + cost(mainWindow.uniqueName) + cost(mainWindow.affinities);
+    for (const QStringList &sideBar : mainWindow.dockWidgetsPerSideBar)
+        result += cost(sideBar);
+
+    return result;
+}
+
+qint64 cost(const LayoutSaver::FloatingWindow &floatingWindow)
+{
+    return qint64(sizeof(LayoutSaver::FloatingWindow)) + cost(floatingWindow.multiSplitterLayout)
+        + cost(floatingWindow.affinities);
+}
+
+qint64 cost(const LayoutSaver::Position &position)
+{
+    qint64 result = qint64(sizeof(LayoutSaver::Position))
+        + qint64(position.placeholders.size()) * qint64(sizeof(LayoutSaver::Placeholder))
+        + qint64(position.lastOverlayedGeometries.size()) * qint64(sizeof(SideBarLocation) + sizeof(QRect));
+    for (const LayoutSaver::Placeholder &placeholder : position.placeholders)
+        result += cost(placeholder.mainWindowUniqueName);
+
+    return result;
+}
+
+/// Memory used by a set of snapshots. Records shared between snapshots are only counted once, and
+/// only stop being counted when the last snapshot referencing them is removed.
+class MemoryAccounting
+{
+public:
+    void add(const Snapshot &snapshot)
+    {
+        m_usage += ownCost(snapshot);
+        for (const auto &mw : snapshot.mainWindows)
+            addRecord(mw);
+        for (const auto &fw : snapshot.floatingWindows)
+            addRecord(fw);
+        for (const DockWidgetState &dw : snapshot.dockWidgets)
+            addRecord(dw.lastPosition);
+    }
+
+    void remove(const Snapshot &snapshot)
+    {
+        m_usage -= ownCost(snapshot);
+        for (const auto &mw : snapshot.mainWindows)
+            removeRecord(mw.get());
+        for (const auto &fw : snapshot.floatingWindows)
+            removeRecord(fw.get());
+        for (const DockWidgetState &dw : snapshot.dockWidgets)
+            removeRecord(dw.lastPosition.get());
+    }
+
+    qint64 usage() const
+    {
+        return m_usage;
+    }
+
+private:
+    struct RecordUsage
+    {
+        qint64 cost;
+        int refCount;
+    };
+
+    /// What the snapshot holds by value, not shared with other snapshots
+    static qint64 ownCost(const Snapshot &snapshot)
+    {
+        qint64 result = qint64(sizeof(Snapshot)) + cost(snapshot.closedDockWidgets)
+            + qint64(snapshot.dockWidgets.size()) * qint64(sizeof(DockWidgetState));
+        for (const DockWidgetState &dw : snapshot.dockWidgets)
+            result += cost(dw.name);
+
+        return result;
+    }
+
+    template<typename T>
+    void addRecord(const std::shared_ptr<const T> &record)
+    {
+        auto it = m_records.find(record.get());
+        if (it == m_records.end()) {
+            const qint64 recordCost = cost(*record);
+            m_records.insert(record.get(), { recordCost, 1 });
+            m_usage += recordCost;
+        } else {
+            it->refCount++;
+        }
+    }
+
+    void removeRecord(const void *record)
+    {
+        auto it = m_records.find(record);
+        if (it == m_records.end())
+            return;
+
+        if (--it->refCount == 0) {
+            m_usage -= it->cost;
+            m_records.erase(it);
+        }
+    }
+
+    QHash<const void *, RecordUsage> m_records;
+    qint64 m_usage = 0;
+};
+
+/// Records which windows and dock widgets reference each other, in one snapshot.
+/// Windows are identified by a key, see mainWindowKey() and floatingWindowKey().
+struct References
+{
+    QHash<QString, QString> containerOf; // dock widget -> window it's in, if any
+    QHash<QString, QStringList> placeholdersOf; // dock widget -> window of each of its placeholders
+};
+
+QString mainWindowKey(const QString &uniqueName)
+{
+    return QLatin1String("mw:") + uniqueName;
+}
+
+QString floatingWindowKey(int index)
+{
+    return QStringLiteral("fw:%1").arg(index);
+}
+
+void addContainedDockWidgets(const LayoutSaver::MultiSplitter &multiSplitter, const QString &key,
+                             References &references)
+{
+    for (const LayoutSaver::Frame &frame : multiSplitter.frames) {
+        for (const LayoutSaver::DockWidget::Ptr &dw : frame.dockWidgets)
+            references.containerOf.insert(dw->uniqueName, key);
+    }
+}
+
+///@brief Collects the references of @p snapshot. @p floatingKeys maps its floating windows to keys.
+References collectReferences(const Snapshot &snapshot, const QVector<QString> &floatingKeys)
+{
+    References references;
+    for (const auto &mw : snapshot.mainWindows) {
+        const QString key = mainWindowKey(mw->uniqueName);
+        addContainedDockWidgets(mw->multiSplitterLayout, key, references);
+        for (const QStringList &sideBar : mw->dockWidgetsPerSideBar) {
+            for (const QString &name : sideBar)
+                references.containerOf.insert(name, key);
+        }
+    }
+
+    for (int i = 0; i < snapshot.floatingWindows.size(); ++i)
+        addContainedDockWidgets(snapshot.floatingWindows.at(i)->multiSplitterLayout, floatingKeys.at(i), references);
+
+    for (const DockWidgetState &dw : snapshot.dockWidgets) {
+        QStringList &windows = references.placeholdersOf[dw.name];
+        for (const LayoutSaver::Placeholder &placeholder : dw.lastPosition->placeholders) {
+            if (!placeholder.isFloatingWindow) {
+                windows.push_back(mainWindowKey(placeholder.mainWindowUniqueName));
+            } else if (placeholder.indexOfFloatingWindow >= 0 && placeholder.indexOfFloatingWindow < floatingKeys.size()) {
+                windows.push_back(floatingKeys.at(placeholder.indexOfFloatingWindow));
+            } else {
+                windows.push_back(QString());
+            }
+        }
+    }
+
+    return references;
+}
+
+}
+
+class LayoutHistory::Private
+{
+public:
+    ///@brief Captures the current layout into @p snapshot, sharing records with @p previous
+    bool capture(Snapshot &snapshot, const Snapshot *previous) const;
+
+    ///@brief Restores the snapshot at @p index, only touching what changed
+    bool restore(int index);
+
+    ///@brief Returns what doesn't need restoring when going from @p current to @p target
+    /// @p current must have been captured sharing records with @p target.
+    LayoutSaver::Private::Unchanged unchangedParts(const Snapshot &target, const Snapshot &current,
+                                                   const QVector<KDDockWidgets::FloatingWindow *> &currentFloatingWindows) const;
+
+    ///@brief If the layout changed since the current snapshot, records it as a new step after it
+    /// Discards what could be redone, like snapshot(). Returns false if the layout can't be captured.
+    bool recordPendingChanges();
+
+    qint64 memoryUsage() const;
+    void enforceMemoryBudget();
+
+    QVector<Snapshot> m_snapshots;
+    int m_current = -1;
+    qint64 m_memoryBudget = 1024 * 1024;
+};
+
+LayoutHistory::LayoutHistory()
+    : d(new Private())
+{
+}
+
+LayoutHistory::~LayoutHistory()
+{
+    delete d;
+}
+
+void LayoutHistory::snapshot()
+{
+    if (LayoutSaver::restoreInProgress()) {
+        // For example, called from a signal emitted while we're undoing
+        return;
+    }
+
+    const Snapshot *previous = d->m_current == -1 ? nullptr : &d->m_snapshots.at(d->m_current);
+
+    Snapshot snapshot;
+    if (!d->capture(snapshot, previous))
+        return;
+
+    if (previous && snapshot.sharesAllWith(*previous)) {
+        // Nothing changed, don't add a step which undoes nothing
+        return;
+    }
+
+    // Discard what could be redone
+    d->m_snapshots.resize(d->m_current + 1);
+    d->m_snapshots.push_back(snapshot);
+    d->m_current = int(d->m_snapshots.size()) - 1;
+    d->enforceMemoryBudget();
+}
+
+bool LayoutHistory::undo()
+{
+    // Changes made since the last snapshot() become the step to redo, instead of being lost
+    if (d->m_current == -1 || !d->recordPendingChanges())
+        return false;
+
+    if (!canUndo())
+        return false;
+
+    return d->restore(d->m_current - 1);
+}
+
+bool LayoutHistory::redo()
+{
+    // If the layout changed since undo(), that change is kept and replaces what could be redone
+    if (d->m_current == -1 || !d->recordPendingChanges())
+        return false;
+
+    if (!canRedo())
+        return false;
+
+    return d->restore(d->m_current + 1);
+}
+
+bool LayoutHistory::canUndo() const
+{
+    return d->m_current > 0;
+}
+
+bool LayoutHistory::canRedo() const
+{
+    return d->m_current + 1 < d->m_snapshots.size();
+}
+
+int LayoutHistory::count() const
+{
+    return int(d->m_snapshots.size());
+}
+
+void LayoutHistory::clear()
+{
+    d->m_snapshots.clear();
+    d->m_current = -1;
+}
+
+void LayoutHistory::setMemoryBudget(qint64 bytes)
+{
+    d->m_memoryBudget = bytes;
+    d->enforceMemoryBudget();
+}
+
+qint64 LayoutHistory::memoryBudget() const
+{
+    return d->m_memoryBudget;
+}
+
+qint64 LayoutHistory::memoryUsage() const
+{
+    return d->memoryUsage();
+}
+
+bool LayoutHistory::Private::capture(Snapshot &snapshot, const Snapshot *previous) const
+{
+    if (!DockRegistry::self()->isSane()) {
+        qWarning() << Q_FUNC_INFO << "Refusing to snapshot this layout. Check previous warnings.";
+        return false;
+    }
+
+    LayoutSaver saver;
+    LayoutSaver::Layout layout;
+    saver.dptr()->serialize(layout);
+
+    snapshot.mainWindows.reserve(layout.mainWindows.size());
+    for (const LayoutSaver::MainWindow &mw : qAsConst(layout.mainWindows)) {
+        std::shared_ptr<const LayoutSaver::MainWindow> candidate;
+        if (previous) {
+            for (const auto &previousMw : previous->mainWindows) {
+                if (previousMw->uniqueName == mw.uniqueName) {
+                    candidate = previousMw;
+                    break;
+                }
+            }
+        }
+
+        snapshot.mainWindows.push_back(shareIfEqual(mw, candidate));
+    }
+
+    // Floating windows have no identity, share with any equal one, but only once
+    QVector<bool> used(previous ? previous->floatingWindows.size() : 0, false);
+    snapshot.floatingWindows.reserve(layout.floatingWindows.size());
+    for (const LayoutSaver::FloatingWindow &fw : qAsConst(layout.floatingWindows)) {
+        std::shared_ptr<const LayoutSaver::FloatingWindow> candidate;
+        for (int i = 0; i < used.size(); ++i) {
+            if (!used.at(i) && *previous->floatingWindows.at(i) == fw) {
+                used[i] = true;
+                candidate = previous->floatingWindows.at(i);
+                break;
+            }
+        }
+
+        snapshot.floatingWindows.push_back(shareIfEqual(fw, candidate));
+    }
+
+    snapshot.closedDockWidgets.reserve(layout.closedDockWidgets.size());
+    for (const auto &dw : qAsConst(layout.closedDockWidgets))
+        snapshot.closedDockWidgets.push_back(dw->uniqueName);
+
+    QHash<QString, std::shared_ptr<const LayoutSaver::Position>> previousPositions;
+    if (previous) {
+        for (const DockWidgetState &dw : previous->dockWidgets)
+            previousPositions.insert(dw.name, dw.lastPosition);
+    }
+
+    snapshot.dockWidgets.reserve(layout.allDockWidgets.size());
+    for (const auto &dw : qAsConst(layout.allDockWidgets)) {
+        // Copy the position out, the LayoutSaver::DockWidget instances are shared and reused
+        DockWidgetState state;
+        state.name = dw->uniqueName;
+        state.lastPosition = shareIfEqual(dw->lastPosition, previousPositions.value(dw->uniqueName));
+        snapshot.dockWidgets.push_back(state);
+    }
+
+    return true;
+}
+
+bool LayoutHistory::Private::recordPendingChanges()
+{
+    Snapshot live;
+    if (!capture(live, &m_snapshots.at(m_current)))
+        return false;
+
+    if (!live.sharesAllWith(m_snapshots.at(m_current))) {
+        m_snapshots.resize(m_current + 1);
+        m_snapshots.push_back(live);
+        m_current++;
+        enforceMemoryBudget();
+    }
+
+    return true;
+}
+
+bool LayoutHistory::Private::restore(int index)
+{
+    Snapshot current;
+    if (!capture(current, &m_snapshots.at(index)))
+        return false;
+
+    // In the same order as the floating windows in the snapshot, see LayoutSaver::Private::serialize()
+    const QVector<KDDockWidgets::FloatingWindow *> currentFloatingWindows = DockRegistry::self()->floatingWindows();
+    if (currentFloatingWindows.size() != current.floatingWindows.size()) {
+        qWarning() << Q_FUNC_INFO << "Unexpected floating window count";
+        return false;
+    }
+
+    const Snapshot &target = m_snapshots.at(index);
+    const LayoutSaver::Private::Unchanged unchanged = unchangedParts(target, current, currentFloatingWindows);
+
+    {
+        LayoutSaver saver;
+        LayoutSaver::Layout layout;
+        layout.mainWindows.reserve(target.mainWindows.size());
+        for (const auto &mw : target.mainWindows)
+            layout.mainWindows.push_back(*mw);
+
+        layout.floatingWindows.reserve(target.floatingWindows.size());
+        for (const auto &fw : target.floatingWindows)
+            layout.floatingWindows.push_back(*fw);
+
+        for (const QString &name : target.closedDockWidgets)
+            layout.closedDockWidgets.push_back(LayoutSaver::DockWidget::dockWidgetForName(name));
+
+        for (const DockWidgetState &state : target.dockWidgets) {
+            auto dw = LayoutSaver::DockWidget::dockWidgetForName(state.name);
+            dw->lastPosition = *state.lastPosition;
+            layout.allDockWidgets.push_back(dw);
+        }
+
+        if (!layout.isValid() || !saver.dptr()->restore(layout, unchanged))
+            return false;
+    }
+
+    m_current = index;
+
+    // Windows which were restored got new frames, with new ids. Recapture, so the snapshot matches
+    // what's on screen and a snapshot() without further changes is recognized as a no-op.
+    Snapshot restored;
+    if (capture(restored, &target))
+        m_snapshots[index] = restored;
+
+    return true;
+}
+
+LayoutSaver::Private::Unchanged
+LayoutHistory::Private::unchangedParts(const Snapshot &target, const Snapshot &current,
+                                       const QVector<KDDockWidgets::FloatingWindow *> &currentFloatingWindows) const
+{
+    // Windows whose record is shared are candidates for being left alone
+    QSet<QString> keptWindows;
+    for (const auto &mw : target.mainWindows) {
+        if (current.mainWindows.contains(mw))
+            keptWindows.insert(mainWindowKey(mw->uniqueName));
+    }
+
+    QVector<QString> targetFloatingKeys;
+    QVector<QString> currentFloatingKeys;
+    QHash<int, int> currentIndexForTarget;
+    for (int i = 0; i < target.floatingWindows.size(); ++i)
+        targetFloatingKeys.push_back(floatingWindowKey(i));
+
+    for (int i = 0; i < current.floatingWindows.size(); ++i) {
+        // Unmatched windows get a key that's not in the target
+        currentFloatingKeys.push_back(QStringLiteral("fw-current:%1").arg(i));
+    }
+
+    QVector<bool> matched(current.floatingWindows.size(), false);
+    for (int targetIndex = 0; targetIndex < target.floatingWindows.size(); ++targetIndex) {
+        for (int i = 0; i < current.floatingWindows.size(); ++i) {
+            if (!matched.at(i) && current.floatingWindows.at(i) == target.floatingWindows.at(targetIndex)) {
+                matched[i] = true;
+                currentIndexForTarget.insert(targetIndex, i);
+                currentFloatingKeys[i] = targetFloatingKeys.at(targetIndex);
+                keptWindows.insert(targetFloatingKeys.at(targetIndex));
+                break;
+            }
+        }
+    }
+
+    const References targetReferences = collectReferences(target, targetFloatingKeys);
+    const References currentReferences = collectReferences(current, currentFloatingKeys);
+
+    // Dock widgets which are in the same window, with the same placeholders, in both snapshots.
+    // Equal positions aren't enough, as floating windows are referenced by index.
+    QStringList stableDockWidgets;
+    for (const DockWidgetState &dw : target.dockWidgets) {
+        if (current.dockWidgets.contains(dw)
+            && targetReferences.containerOf.value(dw.name) == currentReferences.containerOf.value(dw.name)
+            && targetReferences.placeholdersOf.value(dw.name) == currentReferences.placeholdersOf.value(dw.name))
+            stableDockWidgets.push_back(dw.name);
+    }
+
+    // Which dock widgets each window depends on, through either containing them or their placeholders
+    QHash<QString, QSet<QString>> dockWidgetsReferencing;
+    for (const References *references : { &targetReferences, &currentReferences }) {
+        for (auto it = references->containerOf.cbegin(), end = references->containerOf.cend(); it != end; ++it)
+            dockWidgetsReferencing[it.value()].insert(it.key());
+
+        for (auto it = references->placeholdersOf.cbegin(), end = references->placeholdersOf.cend(); it != end; ++it) {
+            for (const QString &window : it.value())
+                dockWidgetsReferencing[window].insert(it.key());
+        }
+    }
+
+    // A window can only be left alone if every dock widget referencing it is too, otherwise restoring
+    // that dock widget would modify the window. And vice-versa. Iterate until both sets agree.
+    QSet<QString> keptDockWidgets;
+    bool changed = true;
+    while (changed) {
+        changed = false;
+
+        keptDockWidgets.clear();
+        for (const QString &name : qAsConst(stableDockWidgets)) {
+            const QString container = targetReferences.containerOf.value(name);
+            if (!container.isEmpty() && !keptWindows.contains(container))
+                continue;
+
+            const QStringList windows = targetReferences.placeholdersOf.value(name);
+            if (std::all_of(windows.cbegin(), windows.cend(), [&keptWindows](const QString &window) {
+                    return keptWindows.contains(window);
+                }))
+                keptDockWidgets.insert(name);
+        }
+
+        const QSet<QString> windows = keptWindows;
+        for (const QString &window : windows) {
+            const QSet<QString> names = dockWidgetsReferencing.value(window);
+            for (const QString &name : names) {
+                if (!keptDockWidgets.contains(name)) {
+                    keptWindows.remove(window);
+                    changed = true;
+                    break;
+                }
+            }
+        }
+    }
+
+    LayoutSaver::Private::Unchanged unchanged;
+    for (const auto &mw : target.mainWindows) {
+        if (keptWindows.contains(mainWindowKey(mw->uniqueName)))
+            unchanged.mainWindows.push_back(mw->uniqueName);
+    }
+
+    for (auto it = currentIndexForTarget.cbegin(), end = currentIndexForTarget.cend(); it != end; ++it) {
+        if (keptWindows.contains(targetFloatingKeys.at(it.key())))
+            unchanged.floatingWindows.insert(it.key(), currentFloatingWindows.at(it.value()));
+    }
+
+    unchanged.dockWidgets = keptDockWidgets.values();
+
+    return unchanged;
+}
+
+qint64 LayoutHistory::Private::memoryUsage() const
+{
+    MemoryAccounting accounting;
+    for (const Snapshot &snapshot : m_snapshots)
+        accounting.add(snapshot);
+
+    return accounting.usage();
+}
+
+void LayoutHistory::Private::enforceMemoryBudget()
+{
+    MemoryAccounting accounting;
+    for (const Snapshot &snapshot : qAsConst(m_snapshots))
+        accounting.add(snapshot);
+
+    // The oldest snapshots go first, then the ones which could be redone. The current one always stays.
+    while (m_current > 0 && accounting.usage() > m_memoryBudget) {
+        accounting.remove(m_snapshots.constFirst());
+        m_snapshots.removeFirst();
+        --m_current;
+    }
+
+    while (m_snapshots.size() > m_current + 1 && accounting.usage() > m_memoryBudget) {
+        accounting.remove(m_snapshots.constLast());
+        m_snapshots.removeLast();
+    }
+}
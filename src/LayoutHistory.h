@@ -0,0 +1,104 @@
+/*
+  This file is part of KDDockWidgets.
+
+  SPDX-FileCopyrightText: 2020-2022 Klarälvdalens Datakonsult AB, a KDAB Group company <info@kdab.com>
+  Author: Sérgio Martins <sergio.martins@kdab.com>
+
+  SPDX-License-Identifier: GPL-2.0-only OR GPL-3.0-only
+
+  Contact KDAB at <info@kdab.com> for commercial licensing options.
+*/
+
+#ifndef KD_LAYOUTHISTORY_H
+#define KD_LAYOUTHISTORY_H
+
+/**
+ * @file
+ * @brief Class to undo and redo changes to the dock widget layout.
+ *
+ * @author Sérgio Martins \<sergio.martins@kdab.com\>
+ */
+
+#include "docks_export.h"
+
+#include "KDDockWidgets.h"
+
+namespace KDDockWidgets {
+
+/**
+ * @brief LayoutHistory keeps in-memory snapshots of the layout, to undo and redo docking operations.
+ *
+ * Call snapshot() after each operation which should be undoable, for example when the user
+ * finishes dragging a dock widget. undo() and redo() then move through the snapshots.
+ *
+ * Snapshots don't go through JSON. Windows and dock widget positions which didn't change between
+ * consecutive snapshots are shared instead of copied, and undo() and redo() only restore the
+ * windows and dock widgets which differ from what's currently on screen.
+ *
+ * The oldest snapshots are dropped when the history exceeds its memory budget, see setMemoryBudget().
+ *
+ * Example:
+ *     LayoutHistory history;
+ *     history.snapshot(); // Initial state
+ *
+ *     // ... user docks something ...
+ *     history.snapshot();
+ *
+ *     history.undo(); // Back to the initial state
+ */
+class DOCKS_EXPORT LayoutHistory
+{
+public:
+    ///@brief Constructor. The history starts empty.
+    LayoutHistory();
+
+    ///@brief Destructor.
+    ~LayoutHistory();
+
+    ///@brief Records the current layout
+    /// Snapshots which could be redone are discarded.
+    void snapshot();
+
+    ///@brief Restores the previous snapshot
+    /// If the layout changed since the last snapshot(), that change is recorded first, so redo()
+    /// can bring it back.
+    /// @return true on success
+    bool undo();
+
+    ///@brief Restores the next snapshot, undone by undo()
+    /// If the layout changed since then, that change is recorded instead and there's nothing left
+    /// to redo.
+    /// @return true on success
+    bool redo();
+
+    ///@brief Returns whether there's a snapshot before the current one
+    bool canUndo() const;
+
+    ///@brief Returns whether there's a snapshot after the current one
+    bool canRedo() const;
+
+    ///@brief Returns the number of snapshots in the history
+    int count() const;
+
+    ///@brief Discards all snapshots
+    void clear();
+
+    ///@brief Sets the maximum memory the snapshots may use, in bytes. 1 MiB by default.
+    /// The current snapshot is always kept, even if it's bigger than the budget.
+    void setMemoryBudget(qint64 bytes);
+
+    ///@brief Returns the memory budget set with setMemoryBudget()
+    qint64 memoryBudget() const;
+
+    ///@brief Returns an estimate of the memory used by the snapshots, in bytes
+    /// Data shared between snapshots is only counted once.
+    qint64 memoryUsage() const;
+
+private:
+    Q_DISABLE_COPY(LayoutHistory)
+    class Private;
+    Private *const d;
+};
+}
+
+#endif
@@ -23,11 +23,14 @@
 #include "FrameworkWidgetFactory.h"
 
 #include "private/multisplitter/Item_p.h"
+#include "private/multisplitter/JsonStreamReader_p.h"
+#include "private/multisplitter/PerfCounters_p.h"
 #include "private/LayoutSaver_p.h"
 #include "private/DockRegistry_p.h"
 #include "private/DockWidgetBase_p.h"
 #include "private/FloatingWindow_p.h"
 #include "private/Frame_p.h"
+#include "private/LayoutLibrary_p.h"
 #include "private/LayoutWidget_p.h"
 #include "private/Logging_p.h"
 #include "private/Position_p.h"
@@ -35,6 +38,7 @@
 
 #include <qmath.h>
 #include <QDebug>
+#include <QElapsedTimer>
 #include <QFile>
 
 /**
@@ -58,6 +62,7 @@
  * FloatingWindow::serialize()/deserialize()
  */
 using namespace KDDockWidgets;
+using Layouting::JsonStreamReader;
 
 QHash<QString, LayoutSaver::DockWidget::Ptr> LayoutSaver::DockWidget::s_dockWidgets;
 LayoutSaver::Layout *LayoutSaver::Layout::s_currentLayoutBeingRestored = nullptr;
@@ -88,14 +93,19 @@ static QVariantList stringListToVariant(const QStringList &strs)
     return variantList;
 }
 
-static QStringList variantToStringList(const QVariantList &variantList)
-{
-    QStringList stringList;
-    stringList.reserve(variantList.size());
-    for (const QVariant &variant : variantList)
-        stringList.push_back(variant.toString());
+template<typename T>
+static typename T::List fromJsonStreamList(JsonStreamReader &reader)
+{
+    typename T::List result;
+    if (reader.beginArray()) {
+        while (reader.nextElement()) {
+            T t;
+            t.fromJsonStream(reader);
+            result.push_back(t);
+        }
+    }
 
-    return stringList;
+    return result;
 }
 
 LayoutSaver::LayoutSaver(RestoreOptions options)
@@ -136,6 +146,64 @@ bool LayoutSaver::restoreFromFile(const QString &jsonFilename)
     return result;
 }
 
+bool LayoutSaver::saveToLibrary(const QString &libraryFilename, const QString &layoutName)
+{
+    const QByteArray data = serializeLayout();
+    if (data.isEmpty())
+        return false;
+
+    LayoutLibrary library(libraryFilename);
+    if (!library.open() || !library.insert(layoutName, data, KDDOCKWIDGETS_SERIALIZATION_VERSION)) {
+        qWarning() << Q_FUNC_INFO << "Failed to save" << layoutName << "to" << libraryFilename
+                   << library.errorString();
+        return false;
+    }
+
+    return true;
+}
+
+bool LayoutSaver::restoreFromLibrary(const QString &libraryFilename, const QString &layoutName)
+{
+    LayoutLibrary library(libraryFilename);
+    if (!library.open()) {
+        qWarning() << Q_FUNC_INFO << "Failed to open" << libraryFilename << library.errorString();
+        return false;
+    }
+
+    // Only this layout is copied out of the mapped file, the others aren't read
+    const QByteArray data = library.layout(layoutName);
+    if (data.isEmpty()) {
+        qWarning() << Q_FUNC_INFO << "Failed to read" << layoutName << "from" << libraryFilename
+                   << library.errorString();
+        return false;
+    }
+
+    return restoreLayout(data);
+}
+
+QStringList LayoutSaver::libraryLayoutNames(const QString &libraryFilename)
+{
+    LayoutLibrary library(libraryFilename);
+    if (!library.open()) {
+        qWarning() << Q_FUNC_INFO << "Failed to open" << libraryFilename << library.errorString();
+        return {};
+    }
+
+    return library.names();
+}
+
+bool LayoutSaver::removeFromLibrary(const QString &libraryFilename, const QString &layoutName)
+{
+    LayoutLibrary library(libraryFilename);
+    if (!library.open() || !library.remove(layoutName)) {
+        qWarning() << Q_FUNC_INFO << "Failed to remove" << layoutName << "from" << libraryFilename
+                   << library.errorString();
+        return false;
+    }
+
+    return true;
+}
+
 QByteArray LayoutSaver::serializeLayout() const
 {
     if (!d->m_dockRegistry->isSane()) {
@@ -144,97 +212,136 @@ QByteArray LayoutSaver::serializeLayout() const
     }
 
     LayoutSaver::Layout layout;
+    d->serialize(layout);
+
+    return layout.toJson();
+}
+
+bool LayoutSaver::restoreLayout(const QByteArray &data)
+{
+    d->clearRestoredProperty();
+    if (data.isEmpty())
+        return true;
+
+    struct RestoreTimer
+    {
+        RestoreTimer()
+        {
+            m_timer.start();
+        }
+
+        ~RestoreTimer()
+        {
+            Layouting::PerfCounters::increment(Layouting::PerfCounters::Counter_Restores);
+            Layouting::PerfCounters::increment(Layouting::PerfCounters::Counter_RestoreMSecs,
+                                               quint64(m_timer.elapsed()));
+        }
 
+        QElapsedTimer m_timer;
+    };
+
+    RestoreTimer restoreTimer;
+    LayoutSaver::Layout layout;
+    if (!layout.fromJson(data)) {
+        qWarning() << Q_FUNC_INFO << "Failed to parse json data";
+        return false;
+    }
+
+    if (!layout.isValid()) {
+        return false;
+    }
+
+    layout.scaleSizes(d->m_restoreOptions);
+
+    return d->restore(layout);
+}
+
+void LayoutSaver::Private::serialize(LayoutSaver::Layout &layout) const
+{
     // Just a simplification. One less type of windows to handle.
-    d->m_dockRegistry->ensureAllFloatingWidgetsAreMorphed();
+    m_dockRegistry->ensureAllFloatingWidgetsAreMorphed();
 
-    const MainWindowBase::List mainWindows = d->m_dockRegistry->mainwindows();
+    const MainWindowBase::List mainWindows = m_dockRegistry->mainwindows();
     layout.mainWindows.reserve(mainWindows.size());
     for (MainWindowBase *mainWindow : mainWindows) {
-        if (d->matchesAffinity(mainWindow->affinities()))
+        if (matchesAffinity(mainWindow->affinitySet()))
             layout.mainWindows.push_back(mainWindow->serialize());
     }
 
-    const QVector<KDDockWidgets::FloatingWindow *> floatingWindows = d->m_dockRegistry->floatingWindows();
+    const QVector<KDDockWidgets::FloatingWindow *> floatingWindows = m_dockRegistry->floatingWindows();
     layout.floatingWindows.reserve(floatingWindows.size());
     for (KDDockWidgets::FloatingWindow *floatingWindow : floatingWindows) {
-        if (d->matchesAffinity(floatingWindow->affinities()))
+        if (matchesAffinity(floatingWindow->affinitySet()))
             layout.floatingWindows.push_back(floatingWindow->serialize());
     }
 
     // Closed dock widgets also have interesting things to save, like geometry and placeholder info
-    const DockWidgetBase::List closedDockWidgets = d->m_dockRegistry->closedDockwidgets();
+    const DockWidgetBase::List closedDockWidgets = m_dockRegistry->closedDockwidgets();
     layout.closedDockWidgets.reserve(closedDockWidgets.size());
     for (DockWidgetBase *dockWidget : closedDockWidgets) {
-        if (d->matchesAffinity(dockWidget->affinities()))
+        if (matchesAffinity(dockWidget->d->affinitySet))
             layout.closedDockWidgets.push_back(dockWidget->d->serialize());
     }
 
     // Save the placeholder info. We do it last, as we also restore it last, since we need all items to be created
     // before restoring the placeholders
 
-    const DockWidgetBase::List dockWidgets = d->m_dockRegistry->dockwidgets();
+    const DockWidgetBase::List dockWidgets = m_dockRegistry->dockwidgets();
     layout.allDockWidgets.reserve(dockWidgets.size());
     for (DockWidgetBase *dockWidget : dockWidgets) {
-        if (d->matchesAffinity(dockWidget->affinities())) {
+        if (matchesAffinity(dockWidget->d->affinitySet)) {
             auto dw = dockWidget->d->serialize();
             dw->lastPosition = dockWidget->d->lastPosition()->serialize();
             layout.allDockWidgets.push_back(dw);
         }
     }
-
-    return layout.toJson();
 }
 
-bool LayoutSaver::restoreLayout(const QByteArray &data)
+bool LayoutSaver::Private::restore(LayoutSaver::Layout &layout, const Unchanged &unchanged)
 {
-    d->clearRestoredProperty();
-    if (data.isEmpty())
-        return true;
-
     struct FrameCleanup
     {
-        FrameCleanup(LayoutSaver *saver)
+        FrameCleanup(LayoutSaver::Private *saver)
             : m_saver(saver)
         {
         }
 
         ~FrameCleanup()
         {
-            m_saver->d->deleteEmptyFrames();
+            m_saver->deleteEmptyFrames();
         }
 
-        LayoutSaver *const m_saver;
+        LayoutSaver::Private *const m_saver;
     };
 
     FrameCleanup cleanup(this);
-    LayoutSaver::Layout layout;
-    if (!layout.fromJson(data)) {
-        qWarning() << Q_FUNC_INFO << "Failed to parse json data";
-        return false;
-    }
-
-    if (!layout.isValid()) {
-        return false;
-    }
 
-    layout.scaleSizes(d->m_restoreOptions);
+    QStringList mainWindowNames = layout.mainWindowNames();
+    for (const QString &name : unchanged.mainWindows)
+        mainWindowNames.removeOne(name);
 
-    d->floatWidgetsWhichSkipRestore(layout.mainWindowNames());
-    d->floatUnknownWidgets(layout);
+    floatWidgetsWhichSkipRestore(mainWindowNames);
+    floatUnknownWidgets(layout, mainWindowNames);
 
     Private::RAIIIsRestoring isRestoring;
 
     // Hide all dockwidgets and unparent them from any layout before starting restore
     // We only close the stuff that the loaded JSON knows about. Unknown widgets might be newer.
 
-    d->m_dockRegistry->clear(d->m_dockRegistry->dockWidgets(layout.dockWidgetsToClose()),
-                             d->m_dockRegistry->mainWindows(layout.mainWindowNames()),
-                             d->m_affinityNames);
+    QStringList dockWidgetsToClose = layout.dockWidgetsToClose();
+    for (const QString &name : unchanged.dockWidgets)
+        dockWidgetsToClose.removeOne(name);
+
+    m_dockRegistry->clear(m_dockRegistry->dockWidgets(dockWidgetsToClose),
+                          m_dockRegistry->mainWindows(mainWindowNames),
+                          m_affinityNames);
 
     // 1. Restore main windows
     for (const LayoutSaver::MainWindow &mw : qAsConst(layout.mainWindows)) {
-        MainWindowBase *mainWindow = d->m_dockRegistry->mainWindowByName(mw.uniqueName);
+        if (unchanged.mainWindows.contains(mw.uniqueName))
+            continue;
+
+        MainWindowBase *mainWindow = m_dockRegistry->mainWindowByName(mw.uniqueName);
         if (!mainWindow) {
             if (auto mwFunc = Config::self().mainWindowFactoryFunc()) {
                 mainWindow = mwFunc(mw.uniqueName);
@@ -244,11 +351,11 @@ bool LayoutSaver::restoreLayout(const QByteArray &data)
             }
         }
 
-        if (!d->matchesAffinity(mainWindow->affinities()))
+        if (!matchesAffinity(mainWindow->affinitySet()))
             continue;
 
-        if (!(d->m_restoreOptions & InternalRestoreOption::SkipMainWindowGeometry)) {
-            d->deserializeWindowGeometry(mw, mainWindow->window()); // window(), as the MainWindow can be embedded
+        if (!(m_restoreOptions & InternalRestoreOption::SkipMainWindowGeometry)) {
+            deserializeWindowGeometry(mw, mainWindow->window()); // window(), as the MainWindow can be embedded
             if (mw.windowState != Qt::WindowNoState) {
                 if (auto w = mainWindow->windowHandle()) {
                     w->setWindowState(mw.windowState);
@@ -261,8 +368,15 @@ bool LayoutSaver::restoreLayout(const QByteArray &data)
     }
 
     // 2. Restore FloatingWindows
-    for (LayoutSaver::FloatingWindow &fw : layout.floatingWindows) {
-        if (!d->matchesAffinity(fw.affinities) || fw.skipsRestore())
+    for (int i = 0; i < layout.floatingWindows.size(); ++i) {
+        LayoutSaver::FloatingWindow &fw = layout.floatingWindows[i];
+        if (KDDockWidgets::FloatingWindow *existing = unchanged.floatingWindows.value(i)) {
+            // Placeholders can still refer to it
+            fw.floatingWindowInstance = existing;
+            continue;
+        }
+
+        if (!matchesAffinity(fw.affinities) || fw.skipsRestore())
             continue;
 
         MainWindowBase *parent = fw.parentIndex == -1 ? nullptr
@@ -270,7 +384,7 @@ bool LayoutSaver::restoreLayout(const QByteArray &data)
 
         auto floatingWindow = Config::self().frameworkWidgetFactory()->createFloatingWindow(parent);
         fw.floatingWindowInstance = floatingWindow;
-        d->deserializeWindowGeometry(fw, floatingWindow);
+        deserializeWindowGeometry(fw, floatingWindow);
         if (!floatingWindow->deserialize(fw)) {
             qWarning() << Q_FUNC_INFO << "Failed to deserialize floating window";
             return false;
@@ -279,18 +393,18 @@ bool LayoutSaver::restoreLayout(const QByteArray &data)
 
     // 3. Restore closed dock widgets. They remain closed but acquire geometry and placeholder properties
     for (const auto &dw : qAsConst(layout.closedDockWidgets)) {
-        if (d->matchesAffinity(dw->affinities)) {
+        if (matchesAffinity(dw->affinities) && !unchanged.dockWidgets.contains(dw->uniqueName)) {
             DockWidgetBase::deserialize(dw);
         }
     }
 
     // 4. Restore the placeholder info, now that the Items have been created
     for (const auto &dw : qAsConst(layout.allDockWidgets)) {
-        if (!d->matchesAffinity(dw->affinities))
+        if (!matchesAffinity(dw->affinities) || unchanged.dockWidgets.contains(dw->uniqueName))
             continue;
 
         if (DockWidgetBase *dockWidget =
-                d->m_dockRegistry->dockByName(dw->uniqueName, DockRegistry::DockByNameFlag::ConsultRemapping)) {
+                m_dockRegistry->dockByName(dw->uniqueName, DockRegistry::DockByNameFlag::ConsultRemapping)) {
             dockWidget->d->lastPosition()->deserialize(dw->lastPosition);
         } else {
             qWarning() << Q_FUNC_INFO << "Couldn't find dock widget" << dw->uniqueName;
@@ -307,6 +421,8 @@ void LayoutSaver::setAffinityNames(const QStringList &affinityNames)
         // Any window with empty affinity will also be subject to save/restore
         d->m_affinityNames << QString();
     }
+
+    d->m_affinitySet = AffinitySet(d->m_affinityNames);
 }
 
 LayoutSaver::Private *LayoutSaver::dptr() const
@@ -368,7 +484,13 @@ LayoutSaver::Private::Private(RestoreOptions options)
 bool LayoutSaver::Private::matchesAffinity(const QStringList &affinities) const
 {
     return m_affinityNames.isEmpty() || affinities.isEmpty()
-        || DockRegistry::self()->affinitiesMatch(m_affinityNames, affinities);
+        || m_affinitySet.matches(AffinitySet(affinities));
+}
+
+bool LayoutSaver::Private::matchesAffinity(const AffinitySet &affinities) const
+{
+    return m_affinityNames.isEmpty() || affinities.isEmpty()
+        || m_affinitySet.matches(affinities);
 }
 
 void LayoutSaver::Private::floatWidgetsWhichSkipRestore(const QStringList &mainWindowNames)
@@ -388,13 +510,14 @@ void LayoutSaver::Private::floatWidgetsWhichSkipRestore(const QStringList &mainW
     }
 }
 
-void LayoutSaver::Private::floatUnknownWidgets(const LayoutSaver::Layout &layout)
+void LayoutSaver::Private::floatUnknownWidgets(const LayoutSaver::Layout &layout,
+                                               const QStringList &mainWindowNames)
 {
     // An old *.json layout file might have not know about existing dock widgets
     // When restoring such a file, we need to float any visible dock widgets which it doesn't know about
     // so we can restore the MainWindow layout properly
 
-    for (MainWindowBase *mw : DockRegistry::self()->mainWindows(layout.mainWindowNames())) {
+    for (MainWindowBase *mw : DockRegistry::self()->mainWindows(mainWindowNames)) {
         const KDDockWidgets::DockWidgetBase::List docks = mw->layoutWidget()->dockWidgets();
         for (DockWidgetBase *dw : docks) {
             if (!layout.containsDockWidget(dw->uniqueName())) {
@@ -463,14 +586,56 @@ QByteArray LayoutSaver::Layout::toJson() const
 
 bool LayoutSaver::Layout::fromJson(const QByteArray &jsonData)
 {
-    QJsonParseError error;
-    QJsonDocument doc = QJsonDocument::fromJson(jsonData, &error);
-    if (error.error == QJsonParseError::NoError) {
-        fromVariantMap(doc.toVariant().toMap());
-        return true;
+    // The JSON is parsed in a single pass, straight into our structs, without building a
+    // QJsonDocument or QVariantMap first
+    JsonStreamReader reader(jsonData);
+
+    serializationVersion = 0;
+    mainWindows.clear();
+    floatingWindows.clear();
+    closedDockWidgets.clear();
+    allDockWidgets.clear();
+    screenInfo.clear();
+
+    if (reader.beginObject()) {
+        while (reader.nextKey()) {
+            switch (reader.keyHash()) {
+            case JsonStreamReader::hashKey("serializationVersion"):
+                serializationVersion = reader.readInt();
+                break;
+            case JsonStreamReader::hashKey("mainWindows"):
+                mainWindows = fromJsonStreamList<LayoutSaver::MainWindow>(reader);
+                break;
+            case JsonStreamReader::hashKey("floatingWindows"):
+                floatingWindows = fromJsonStreamList<LayoutSaver::FloatingWindow>(reader);
+                break;
+            case JsonStreamReader::hashKey("closedDockWidgets"):
+                if (reader.beginArray()) {
+                    while (reader.nextElement())
+                        closedDockWidgets.push_back(LayoutSaver::DockWidget::dockWidgetForName(reader.readString()));
+                }
+                break;
+            case JsonStreamReader::hashKey("allDockWidgets"):
+                if (reader.beginArray()) {
+                    while (reader.nextElement())
+                        allDockWidgets.push_back(LayoutSaver::DockWidget::fromJsonStream(reader));
+                }
+                break;
+            case JsonStreamReader::hashKey("screenInfo"):
+                screenInfo = fromJsonStreamList<LayoutSaver::ScreenInfo>(reader);
+                break;
+            default:
+                reader.skipValue();
+            }
+        }
     }
 
-    return false;
+    if (!reader.atEnd()) {
+        qWarning() << Q_FUNC_INFO << "Invalid JSON:" << reader.errorString();
+        return false;
+    }
+
+    return true;
 }
 
 QVariantMap LayoutSaver::Layout::toVariantMap() const
@@ -486,31 +651,6 @@ QVariantMap LayoutSaver::Layout::toVariantMap() const
     return map;
 }
 
-void LayoutSaver::Layout::fromVariantMap(const QVariantMap &map)
-{
-    allDockWidgets.clear();
-    const QVariantList dockWidgetsV = map.value(QStringLiteral("allDockWidgets")).toList();
-    for (const QVariant &v : dockWidgetsV) {
-        const QVariantMap dwV = v.toMap();
-        const QString name = dwV.value(QStringLiteral("uniqueName")).toString();
-        auto dw = LayoutSaver::DockWidget::dockWidgetForName(name);
-        dw->fromVariantMap(dwV);
-        allDockWidgets.push_back(dw);
-    }
-
-    closedDockWidgets.clear();
-    const QVariantList closedDockWidgetsV = map.value(QStringLiteral("closedDockWidgets")).toList();
-    closedDockWidgets.reserve(closedDockWidgetsV.size());
-    for (const QVariant &v : closedDockWidgetsV) {
-        closedDockWidgets.push_back(LayoutSaver::DockWidget::dockWidgetForName(v.toString()));
-    }
-
-    serializationVersion = map.value(QStringLiteral("serializationVersion")).toInt();
-    mainWindows = fromVariantList<LayoutSaver::MainWindow>(map.value(QStringLiteral("mainWindows")).toList());
-    floatingWindows = fromVariantList<LayoutSaver::FloatingWindow>(map.value(QStringLiteral("floatingWindows")).toList());
-    screenInfo = fromVariantList<LayoutSaver::ScreenInfo>(map.value(QStringLiteral("screenInfo")).toList());
-}
-
 void LayoutSaver::Layout::scaleSizes(InternalRestoreOptions options)
 {
     if (mainWindows.isEmpty())
@@ -523,6 +663,11 @@ void LayoutSaver::Layout::scaleSizes(InternalRestoreOptions options)
         return;
     }
 
+    if (environmentUnchanged()) {
+        // Same screens and same main window sizes, the scaling factors would all be 1
+        return;
+    }
+
     // We won't restore MainWindow's geometry, we use whatever the user has now, meaning
     // we need to scale all dock widgets inside the layout, as the layout might not have
     // the same size as specified in the saved JSON layout
@@ -554,6 +699,20 @@ void LayoutSaver::Layout::scaleSizes(InternalRestoreOptions options)
     }
 }
 
+bool LayoutSaver::Layout::environmentUnchanged() const
+{
+    if (screenInfo != ScreenInfo::current())
+        return false;
+
+    for (const auto &mw : mainWindows) {
+        MainWindowBase *mainWindow = DockRegistry::self()->mainWindowByName(mw.uniqueName);
+        if (!mainWindow || mainWindow->window()->geometry() != mw.geometry)
+            return false;
+    }
+
+    return true;
+}
+
 LayoutSaver::MainWindow LayoutSaver::Layout::mainWindowForIndex(int index) const
 {
     if (index < 0 || index >= mainWindows.size())
@@ -679,6 +838,25 @@ LayoutSaver::DockWidget::Ptr LayoutSaver::Frame::singleDockWidget() const
     return dockWidgets.first();
 }
 
+bool LayoutSaver::Frame::operator==(const Frame &other) const
+{
+    if (isNull || other.isNull)
+        return isNull == other.isNull;
+
+    if (objectName != other.objectName || geometry != other.geometry || options != other.options
+        || currentTabIndex != other.currentTabIndex || id != other.id
+        || mainWindowUniqueName != other.mainWindowUniqueName
+        || dockWidgets.size() != other.dockWidgets.size())
+        return false;
+
+    for (int i = 0; i < dockWidgets.size(); ++i) {
+        if (dockWidgets.at(i)->uniqueName != other.dockWidgets.at(i)->uniqueName)
+            return false;
+    }
+
+    return true;
+}
+
 QVariantMap LayoutSaver::Frame::toVariantMap() const
 {
     QVariantMap map;
@@ -694,30 +872,59 @@ QVariantMap LayoutSaver::Frame::toVariantMap() const
     return map;
 }
 
-void LayoutSaver::Frame::fromVariantMap(const QVariantMap &map)
+void LayoutSaver::Frame::fromJsonStream(JsonStreamReader &reader)
 {
-    if (map.isEmpty()) {
-        isNull = true;
-        dockWidgets.clear();
-        return;
-    }
-
-    id = map.value(QStringLiteral("id")).toString();
-    isNull = map.value(QStringLiteral("isNull")).toBool();
-    objectName = map.value(QStringLiteral("objectName")).toString();
-    mainWindowUniqueName = map.value(QStringLiteral("mainWindowUniqueName")).toString();
-    geometry = Layouting::mapToRect(map.value(QStringLiteral("geometry")).toMap());
-    options = static_cast<QFlags<FrameOption>::Int>(map.value(QStringLiteral("options")).toUInt());
-    currentTabIndex = map.value(QStringLiteral("currentTabIndex")).toInt();
+    isNull = true;
+    id.clear();
+    objectName.clear();
+    mainWindowUniqueName.clear();
+    geometry = QRect();
+    options = 0;
+    currentTabIndex = 0;
+    dockWidgets.clear();
 
-    const QVariantList dockWidgetsV = map.value(QStringLiteral("dockWidgets")).toList();
+    if (!reader.beginObject())
+        return;
 
-    dockWidgets.clear();
-    dockWidgets.reserve(dockWidgetsV.size());
-    for (const auto &variant : dockWidgetsV) {
-        DockWidget::Ptr dw = DockWidget::dockWidgetForName(variant.toString());
-        dockWidgets.push_back(dw);
+    // An empty object is a null frame
+    bool isEmpty = true;
+    bool nullValue = false;
+    while (reader.nextKey()) {
+        isEmpty = false;
+        switch (reader.keyHash()) {
+        case JsonStreamReader::hashKey("id"):
+            id = reader.readString();
+            break;
+        case JsonStreamReader::hashKey("isNull"):
+            nullValue = reader.readBool();
+            break;
+        case JsonStreamReader::hashKey("objectName"):
+            objectName = reader.readString();
+            break;
+        case JsonStreamReader::hashKey("mainWindowUniqueName"):
+            mainWindowUniqueName = reader.readString();
+            break;
+        case JsonStreamReader::hashKey("geometry"):
+            geometry = reader.readRect();
+            break;
+        case JsonStreamReader::hashKey("options"):
+            options = static_cast<QFlags<FrameOption>::Int>(reader.readInt());
+            break;
+        case JsonStreamReader::hashKey("currentTabIndex"):
+            currentTabIndex = reader.readInt();
+            break;
+        case JsonStreamReader::hashKey("dockWidgets"):
+            if (reader.beginArray()) {
+                while (reader.nextElement())
+                    dockWidgets.push_back(DockWidget::dockWidgetForName(reader.readString()));
+            }
+            break;
+        default:
+            reader.skipValue();
+        }
     }
+
+    isNull = isEmpty || nullValue;
 }
 
 bool LayoutSaver::DockWidget::isValid() const
@@ -749,18 +956,45 @@ QVariantMap LayoutSaver::DockWidget::toVariantMap() const
     return map;
 }
 
-void LayoutSaver::DockWidget::fromVariantMap(const QVariantMap &map)
-{
-    affinities = variantToStringList(map.value(QStringLiteral("affinities")).toList());
+LayoutSaver::DockWidget::Ptr LayoutSaver::DockWidget::fromJsonStream(JsonStreamReader &reader)
+{
+    // The instance is shared by name, but the name isn't necessarily the first key
+    QString name;
+    QStringList affinityList;
+    QString affinityName;
+    LayoutSaver::Position position;
+
+    if (reader.beginObject()) {
+        while (reader.nextKey()) {
+            switch (reader.keyHash()) {
+            case JsonStreamReader::hashKey("uniqueName"):
+                name = reader.readString();
+                break;
+            case JsonStreamReader::hashKey("affinities"):
+                affinityList = reader.readStringList();
+                break;
+            case JsonStreamReader::hashKey("affinityName"):
+                affinityName = reader.readString();
+                break;
+            case JsonStreamReader::hashKey("lastPosition"):
+                position.fromJsonStream(reader);
+                break;
+            default:
+                reader.skipValue();
+            }
+        }
+    }
 
     // Compatibility hack. Old json format had a single "affinityName" instead of an "affinities" list:
-    const QString affinityName = map.value(QStringLiteral("affinityName")).toString();
-    if (!affinityName.isEmpty() && !affinities.contains(affinityName)) {
-        affinities.push_back(affinityName);
+    if (!affinityName.isEmpty() && !affinityList.contains(affinityName)) {
+        affinityList.push_back(affinityName);
     }
 
-    uniqueName = map.value(QStringLiteral("uniqueName")).toString();
-    lastPosition.fromVariantMap(map.value(QStringLiteral("lastPosition")).toMap());
+    Ptr dw = dockWidgetForName(name);
+    dw->affinities = affinityList;
+    dw->lastPosition = position;
+
+    return dw;
 }
 
 bool LayoutSaver::FloatingWindow::isValid() const
@@ -796,6 +1030,15 @@ void LayoutSaver::FloatingWindow::scaleSizes(const ScalingInfo &scalingInfo)
     scalingInfo.applyFactorsTo(/*by-ref*/ geometry);
 }
 
+bool LayoutSaver::FloatingWindow::operator==(const FloatingWindow &other) const
+{
+    return multiSplitterLayout == other.multiSplitterLayout && affinities == other.affinities
+        && parentIndex == other.parentIndex && geometry == other.geometry
+        && normalGeometry == other.normalGeometry && screenIndex == other.screenIndex
+        && screenSize == other.screenSize && isVisible == other.isVisible
+        && windowState == other.windowState;
+}
+
 QVariantMap LayoutSaver::FloatingWindow::toVariantMap() const
 {
     QVariantMap map;
@@ -814,20 +1057,60 @@ QVariantMap LayoutSaver::FloatingWindow::toVariantMap() const
     return map;
 }
 
-void LayoutSaver::FloatingWindow::fromVariantMap(const QVariantMap &map)
+void LayoutSaver::FloatingWindow::fromJsonStream(JsonStreamReader &reader)
 {
-    multiSplitterLayout.fromVariantMap(map.value(QStringLiteral("multiSplitterLayout")).toMap());
-    parentIndex = map.value(QStringLiteral("parentIndex")).toInt();
-    geometry = Layouting::mapToRect(map.value(QStringLiteral("geometry")).toMap());
-    normalGeometry = Layouting::mapToRect(map.value(QStringLiteral("normalGeometry")).toMap());
-    screenIndex = map.value(QStringLiteral("screenIndex")).toInt();
-    screenSize = Layouting::mapToSize(map.value(QStringLiteral("screenSize")).toMap());
-    isVisible = map.value(QStringLiteral("isVisible")).toBool();
-    affinities = variantToStringList(map.value(QStringLiteral("affinities")).toList());
-    windowState = Qt::WindowState(map.value(QStringLiteral("windowState"), Qt::WindowNoState).toInt());
+    multiSplitterLayout = LayoutSaver::MultiSplitter();
+    parentIndex = 0;
+    geometry = QRect();
+    normalGeometry = QRect();
+    screenIndex = 0;
+    screenSize = QSize();
+    isVisible = false;
+    affinities.clear();
+    windowState = Qt::WindowNoState;
+
+    if (!reader.beginObject())
+        return;
+
+    QString affinityName;
+    while (reader.nextKey()) {
+        switch (reader.keyHash()) {
+        case JsonStreamReader::hashKey("multiSplitterLayout"):
+            multiSplitterLayout.fromJsonStream(reader);
+            break;
+        case JsonStreamReader::hashKey("parentIndex"):
+            parentIndex = reader.readInt();
+            break;
+        case JsonStreamReader::hashKey("geometry"):
+            geometry = reader.readRect();
+            break;
+        case JsonStreamReader::hashKey("normalGeometry"):
+            normalGeometry = reader.readRect();
+            break;
+        case JsonStreamReader::hashKey("screenIndex"):
+            screenIndex = reader.readInt();
+            break;
+        case JsonStreamReader::hashKey("screenSize"):
+            screenSize = reader.readSize();
+            break;
+        case JsonStreamReader::hashKey("isVisible"):
+            isVisible = reader.readBool();
+            break;
+        case JsonStreamReader::hashKey("affinities"):
+            affinities = reader.readStringList();
+            break;
+        case JsonStreamReader::hashKey("affinityName"):
+            affinityName = reader.readString();
+            break;
+        case JsonStreamReader::hashKey("windowState"):
+            windowState = Qt::WindowState(reader.readInt(Qt::WindowNoState));
+            break;
+        default:
+            reader.skipValue();
+        }
+    }
 
     // Compatibility hack. Old json format had a single "affinityName" instead of an "affinities" list:
-    const QString affinityName = map.value(QStringLiteral("affinityName")).toString();
     if (!affinityName.isEmpty() && !affinities.contains(affinityName)) {
         affinities.push_back(affinityName);
     }
@@ -852,6 +1135,16 @@ void LayoutSaver::MainWindow::scaleSizes()
     scalingInfo = ScalingInfo(uniqueName, geometry, screenIndex);
 }
 
+bool LayoutSaver::MainWindow::operator==(const MainWindow &other) const
+{
+    return uniqueName == other.uniqueName && multiSplitterLayout == other.multiSplitterLayout
+        && dockWidgetsPerSideBar == other.dockWidgetsPerSideBar && options == other.options
+        && affinities == other.affinities && geometry == other.geometry
+        && normalGeometry == other.normalGeometry && screenIndex == other.screenIndex
+        && screenSize == other.screenSize && isVisible == other.isVisible
+        && windowState == other.windowState;
+}
+
 QVariantMap LayoutSaver::MainWindow::toVariantMap() const
 {
     QVariantMap map;
@@ -875,37 +1168,85 @@ QVariantMap LayoutSaver::MainWindow::toVariantMap() const
     return map;
 }
 
-void LayoutSaver::MainWindow::fromVariantMap(const QVariantMap &map)
+void LayoutSaver::MainWindow::fromJsonStream(JsonStreamReader &reader)
 {
-    options = KDDockWidgets::MainWindowOptions(map.value(QStringLiteral("options")).toInt());
-    multiSplitterLayout.fromVariantMap(map.value(QStringLiteral("multiSplitterLayout")).toMap());
-    uniqueName = map.value(QStringLiteral("uniqueName")).toString();
-    geometry = Layouting::mapToRect(map.value(QStringLiteral("geometry")).toMap());
-    normalGeometry = Layouting::mapToRect(map.value(QStringLiteral("normalGeometry")).toMap());
-    screenIndex = map.value(QStringLiteral("screenIndex")).toInt();
-    screenSize = Layouting::mapToSize(map.value(QStringLiteral("screenSize")).toMap());
-    isVisible = map.value(QStringLiteral("isVisible")).toBool();
-    affinities = variantToStringList(map.value(QStringLiteral("affinities")).toList());
-    windowState = Qt::WindowState(map.value(QStringLiteral("windowState"), Qt::WindowNoState).toInt());
+    options = {};
+    multiSplitterLayout = LayoutSaver::MultiSplitter();
+    uniqueName.clear();
+    geometry = QRect();
+    normalGeometry = QRect();
+    screenIndex = 0;
+    screenSize = QSize();
+    isVisible = false;
+    affinities.clear();
+    windowState = Qt::WindowNoState;
+    dockWidgetsPerSideBar.clear();
+
+    if (!reader.beginObject())
+        return;
+
+    QString affinityName;
+    while (reader.nextKey()) {
+        switch (reader.keyHash()) {
+        case JsonStreamReader::hashKey("options"):
+            options = KDDockWidgets::MainWindowOptions(reader.readInt());
+            break;
+        case JsonStreamReader::hashKey("multiSplitterLayout"):
+            multiSplitterLayout.fromJsonStream(reader);
+            break;
+        case JsonStreamReader::hashKey("uniqueName"):
+            uniqueName = reader.readString();
+            break;
+        case JsonStreamReader::hashKey("geometry"):
+            geometry = reader.readRect();
+            break;
+        case JsonStreamReader::hashKey("normalGeometry"):
+            normalGeometry = reader.readRect();
+            break;
+        case JsonStreamReader::hashKey("screenIndex"):
+            screenIndex = reader.readInt();
+            break;
+        case JsonStreamReader::hashKey("screenSize"):
+            screenSize = reader.readSize();
+            break;
+        case JsonStreamReader::hashKey("isVisible"):
+            isVisible = reader.readBool();
+            break;
+        case JsonStreamReader::hashKey("affinities"):
+            affinities = reader.readStringList();
+            break;
+        case JsonStreamReader::hashKey("affinityName"):
+            affinityName = reader.readString();
+            break;
+        case JsonStreamReader::hashKey("windowState"):
+            windowState = Qt::WindowState(reader.readInt(Qt::WindowNoState));
+            break;
+        default: {
+            // The SideBars, saved as "sidebar-<SideBarLocation>"
+            const QString key = reader.key();
+            const QLatin1String prefix("sidebar-");
+            bool ok = false;
+            const int loc = key.startsWith(prefix) ? key.mid(prefix.size()).toInt(&ok) : 0;
+            if (ok && loc >= int(SideBarLocation::North) && loc <= int(SideBarLocation::South)) {
+                const QStringList dockWidgets = reader.readStringList();
+                if (!dockWidgets.isEmpty())
+                    dockWidgetsPerSideBar.insert(SideBarLocation(loc), dockWidgets);
+            } else {
+                reader.skipValue();
+            }
+        }
+        }
+    }
 
     // Compatibility hack. Old json format had a single "affinityName" instead of an "affinities" list:
-    const QString affinityName = map.value(QStringLiteral("affinityName")).toString();
     if (!affinityName.isEmpty() && !affinities.contains(affinityName)) {
         affinities.push_back(affinityName);
     }
-
-    // Load the SideBars:
-    dockWidgetsPerSideBar.clear();
-    for (SideBarLocation loc : { SideBarLocation::North, SideBarLocation::East, SideBarLocation::West, SideBarLocation::South }) {
-        const QVariantList dockWidgets = map.value(QStringLiteral("sidebar-%1").arg(int(loc))).toList();
-        if (!dockWidgets.isEmpty())
-            dockWidgetsPerSideBar.insert(loc, variantToStringList(dockWidgets));
-    }
 }
 
 bool LayoutSaver::MultiSplitter::isValid() const
 {
-    if (layout.isEmpty())
+    if (layout.isNull)
         return false;
 
     /*if (!size.isValid()) {
@@ -936,10 +1277,15 @@ bool LayoutSaver::MultiSplitter::skipsRestore() const
     });
 }
 
+bool LayoutSaver::MultiSplitter::operator==(const MultiSplitter &other) const
+{
+    return layout == other.layout && frames == other.frames;
+}
+
 QVariantMap LayoutSaver::MultiSplitter::toVariantMap() const
 {
     QVariantMap result;
-    result.insert(QStringLiteral("layout"), layout);
+    result.insert(QStringLiteral("layout"), layout.toVariantMap());
 
     QVariantMap framesV;
     for (auto &frame : frames)
@@ -949,15 +1295,32 @@ QVariantMap LayoutSaver::MultiSplitter::toVariantMap() const
     return result;
 }
 
-void LayoutSaver::MultiSplitter::fromVariantMap(const QVariantMap &map)
+void LayoutSaver::MultiSplitter::fromJsonStream(JsonStreamReader &reader)
 {
-    layout = map.value(QStringLiteral("layout")).toMap();
-    const QVariantMap framesV = map.value(QStringLiteral("frames")).toMap();
+    layout = Layouting::ItemRecord();
     frames.clear();
-    for (const QVariant &frameV : framesV) {
-        LayoutSaver::Frame frame;
-        frame.fromVariantMap(frameV.toMap());
-        frames.insert(frame.id, frame);
+
+    if (!reader.beginObject())
+        return;
+
+    while (reader.nextKey()) {
+        switch (reader.keyHash()) {
+        case JsonStreamReader::hashKey("layout"):
+            layout.fromJsonStream(reader);
+            break;
+        case JsonStreamReader::hashKey("frames"):
+            // Keyed by frame id, which is also inside each frame
+            if (reader.beginObject()) {
+                while (reader.nextKey()) {
+                    LayoutSaver::Frame frame;
+                    frame.fromJsonStream(reader);
+                    frames.insert(frame.id, frame);
+                }
+            }
+            break;
+        default:
+            reader.skipValue();
+        }
     }
 }
 
@@ -966,6 +1329,13 @@ void LayoutSaver::Position::scaleSizes(const ScalingInfo &scalingInfo)
     scalingInfo.applyFactorsTo(/*by-ref*/ lastFloatingGeometry);
 }
 
+bool LayoutSaver::Position::operator==(const Position &other) const
+{
+    return lastFloatingGeometry == other.lastFloatingGeometry && tabIndex == other.tabIndex
+        && wasFloating == other.wasFloating && placeholders == other.placeholders
+        && lastOverlayedGeometries == other.lastOverlayedGeometries;
+}
+
 QVariantMap LayoutSaver::Position::toVariantMap() const
 {
     QVariantMap map;
@@ -977,12 +1347,34 @@ QVariantMap LayoutSaver::Position::toVariantMap() const
     return map;
 }
 
-void LayoutSaver::Position::fromVariantMap(const QVariantMap &map)
+void LayoutSaver::Position::fromJsonStream(JsonStreamReader &reader)
 {
-    lastFloatingGeometry = Layouting::mapToRect(map.value(QStringLiteral("lastFloatingGeometry")).toMap());
-    tabIndex = map.value(QStringLiteral("tabIndex")).toInt();
-    wasFloating = map.value(QStringLiteral("wasFloating")).toBool();
-    placeholders = fromVariantList<LayoutSaver::Placeholder>(map.value(QStringLiteral("placeholders")).toList());
+    lastFloatingGeometry = QRect();
+    tabIndex = 0;
+    wasFloating = false;
+    placeholders.clear();
+
+    if (!reader.beginObject())
+        return;
+
+    while (reader.nextKey()) {
+        switch (reader.keyHash()) {
+        case JsonStreamReader::hashKey("lastFloatingGeometry"):
+            lastFloatingGeometry = reader.readRect();
+            break;
+        case JsonStreamReader::hashKey("tabIndex"):
+            tabIndex = reader.readInt();
+            break;
+        case JsonStreamReader::hashKey("wasFloating"):
+            wasFloating = reader.readBool();
+            break;
+        case JsonStreamReader::hashKey("placeholders"):
+            placeholders = fromJsonStreamList<LayoutSaver::Placeholder>(reader);
+            break;
+        default:
+            reader.skipValue();
+        }
+    }
 }
 
 QVariantMap LayoutSaver::ScreenInfo::toVariantMap() const
@@ -996,12 +1388,63 @@ QVariantMap LayoutSaver::ScreenInfo::toVariantMap() const
     return map;
 }
 
-void LayoutSaver::ScreenInfo::fromVariantMap(const QVariantMap &map)
+LayoutSaver::ScreenInfo::List LayoutSaver::ScreenInfo::current()
+{
+    const QList<QScreen *> screens = qApp->screens();
+    const int numScreens = int(screens.size());
+
+    List result;
+    result.reserve(numScreens);
+    for (int i = 0; i < numScreens; ++i) {
+        ScreenInfo info;
+        info.index = i;
+        info.geometry = screens[i]->geometry();
+        info.name = screens[i]->name();
+        info.devicePixelRatio = screens[i]->devicePixelRatio();
+        result.push_back(info);
+    }
+
+    return result;
+}
+
+void LayoutSaver::ScreenInfo::fromJsonStream(JsonStreamReader &reader)
+{
+    index = 0;
+    geometry = QRect();
+    name.clear();
+    devicePixelRatio = 0;
+
+    if (!reader.beginObject())
+        return;
+
+    while (reader.nextKey()) {
+        switch (reader.keyHash()) {
+        case JsonStreamReader::hashKey("index"):
+            index = reader.readInt();
+            break;
+        case JsonStreamReader::hashKey("geometry"):
+            geometry = reader.readRect();
+            break;
+        case JsonStreamReader::hashKey("name"):
+            name = reader.readString();
+            break;
+        case JsonStreamReader::hashKey("devicePixelRatio"):
+            devicePixelRatio = reader.readDouble();
+            break;
+        default:
+            reader.skipValue();
+        }
+    }
+}
+
+bool LayoutSaver::Placeholder::operator==(const Placeholder &other) const
 {
-    index = map.value(QStringLiteral("index")).toInt();
-    geometry = Layouting::mapToRect(map.value(QStringLiteral("geometry")).toMap());
-    name = map.value(QStringLiteral("name")).toString();
-    devicePixelRatio = map.value(QStringLiteral("devicePixelRatio")).toDouble();
+    if (isFloatingWindow != other.isFloatingWindow || itemIndex != other.itemIndex)
+        return false;
+
+    // Only one of them is set
+    return isFloatingWindow ? indexOfFloatingWindow == other.indexOfFloatingWindow
+                            : mainWindowUniqueName == other.mainWindowUniqueName;
 }
 
 QVariantMap LayoutSaver::Placeholder::toVariantMap() const
@@ -1018,12 +1461,34 @@ QVariantMap LayoutSaver::Placeholder::toVariantMap() const
     return map;
 }
 
-void LayoutSaver::Placeholder::fromVariantMap(const QVariantMap &map)
+void LayoutSaver::Placeholder::fromJsonStream(JsonStreamReader &reader)
 {
-    isFloatingWindow = map.value(QStringLiteral("isFloatingWindow")).toBool();
-    indexOfFloatingWindow = map.value(QStringLiteral("indexOfFloatingWindow"), -1).toInt();
-    itemIndex = map.value(QStringLiteral("itemIndex")).toInt();
-    mainWindowUniqueName = map.value(QStringLiteral("mainWindowUniqueName")).toString();
+    isFloatingWindow = false;
+    indexOfFloatingWindow = -1;
+    itemIndex = 0;
+    mainWindowUniqueName.clear();
+
+    if (!reader.beginObject())
+        return;
+
+    while (reader.nextKey()) {
+        switch (reader.keyHash()) {
+        case JsonStreamReader::hashKey("isFloatingWindow"):
+            isFloatingWindow = reader.readBool();
+            break;
+        case JsonStreamReader::hashKey("indexOfFloatingWindow"):
+            indexOfFloatingWindow = reader.readInt(-1);
+            break;
+        case JsonStreamReader::hashKey("itemIndex"):
+            itemIndex = reader.readInt();
+            break;
+        case JsonStreamReader::hashKey("mainWindowUniqueName"):
+            mainWindowUniqueName = reader.readString();
+            break;
+        default:
+            reader.skipValue();
+        }
+    }
 }
 
 static QScreen *screenForMainWindow(MainWindowBase *mw)
@@ -1120,9 +1585,13 @@ void LayoutSaver::ScalingInfo::applyFactorsTo(QRect &rect) const
 LayoutSaver::Private::RAIIIsRestoring::RAIIIsRestoring()
 {
     LayoutSaver::Private::s_restoreInProgress = true;
+
+    // Title bars and float actions are resolved once, after everything is restored
+    DockRegistry::self()->beginChromeUpdateBatch();
 }
 
 LayoutSaver::Private::RAIIIsRestoring::~RAIIIsRestoring()
 {
     LayoutSaver::Private::s_restoreInProgress = false;
+    DockRegistry::self()->endChromeUpdateBatch();
 }
@@ -50,6 +50,9 @@ class DockWidgetBase;
  *
  * You can also save to a QByteArray instead, with serializeLayout().
  * The counterpart of serializeLayout() is restoreLayout();
+ *
+ * Applications with many saved layouts can keep them all in a single file, with saveToLibrary()
+ * and restoreFromLibrary().
  */
 class DOCKS_EXPORT LayoutSaver
 {
@@ -77,6 +80,41 @@ public:
      */
     bool restoreFromFile(const QString &jsonFilename);
 
+    /**
+     * @brief saves the layout into a layout library, under the name @p layoutName
+     *
+     * A layout library is a single file holding many named layouts, for example one per
+     * perspective. If the library already has a layout called @p layoutName it's replaced.
+     * The file is replaced atomically, a crash while saving leaves the previous library intact.
+     *
+     * @param libraryFilename the library file, created if it doesn't exist
+     * @param layoutName the name of the layout inside the library
+     * @return true on success
+     */
+    bool saveToLibrary(const QString &libraryFilename, const QString &layoutName);
+
+    /**
+     * @brief restores the layout called @p layoutName from a layout library
+     *
+     * Only the library's index and the chosen layout are read from disk.
+     *
+     * @sa saveToLibrary()
+     * @return true on success
+     */
+    bool restoreFromLibrary(const QString &libraryFilename, const QString &layoutName);
+
+    /**
+     * @brief returns the names of the layouts saved in a layout library
+     * Returns an empty list if the library doesn't exist or can't be read.
+     */
+    static QStringList libraryLayoutNames(const QString &libraryFilename);
+
+    /**
+     * @brief removes the layout called @p layoutName from a layout library
+     * @return true on success
+     */
+    static bool removeFromLibrary(const QString &libraryFilename, const QString &layoutName);
+
     /**
      * @brief saves the layout into a byte array
      */
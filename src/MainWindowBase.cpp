@@ -18,6 +18,7 @@
  */
 
 #include "MainWindowBase.h"
+#include "private/AffinitySet_p.h"
 #include "private/DockRegistry_p.h"
 #include "private/MDILayoutWidget_p.h"
 #include "private/DropArea_p.h"
@@ -108,9 +109,11 @@ public:
 
     QString name;
     QStringList affinities;
+    AffinitySet affinitySet; ///< affinities, interned. Kept in sync with it.
     const MainWindowOptions m_options;
     MainWindowBase *const q;
     QPointer<DockWidgetBase> m_overlayedDockWidget;
+    QPointer<Frame> m_overlayFrame; // Kept hidden between overlays, so it can be reused
     LayoutWidget *const m_layoutWidget;
     DockWidgetBase *const m_persistentCentralDockWidget;
     int m_overlayMargin = 1;
@@ -138,7 +141,7 @@ void MainWindowBase::addDockWidgetAsTab(DockWidgetBase *widget)
     Q_ASSERT(widget);
     qCDebug(addwidget) << Q_FUNC_INFO << widget;
 
-    if (!DockRegistry::self()->affinitiesMatch(d->affinities, widget->affinities())) {
+    if (!d->affinitySet.matches(widget->dptr()->affinitySet)) {
         qWarning() << Q_FUNC_INFO << "Refusing to dock widget with incompatible affinity."
                    << widget->affinities() << affinities();
         return;
@@ -228,6 +231,7 @@ void MainWindowBase::setAffinities(const QStringList &affinityNames)
     }
 
     d->affinities = affinities;
+    d->affinitySet = AffinitySet(affinities);
 }
 
 QStringList MainWindowBase::affinities() const
@@ -235,6 +239,11 @@ QStringList MainWindowBase::affinities() const
     return d->affinities;
 }
 
+const AffinitySet &MainWindowBase::affinitySet() const
+{
+    return d->affinitySet;
+}
+
 void MainWindowBase::layoutEqually()
 {
     dropArea()->layoutEqually();
@@ -549,7 +558,12 @@ void MainWindowBase::overlayOnSideBar(DockWidgetBase *dw)
     // We only support one overlay at a time, remove any existing overlay
     clearSideBarOverlay();
 
-    auto frame = Config::self().frameworkWidgetFactory()->createFrame(this, FrameOption_IsOverlayed);
+    Frame *frame = d->m_overlayFrame;
+    if (!frame || frame->beingDeletedLater()) {
+        frame = Config::self().frameworkWidgetFactory()->createFrame(this, FrameOption_IsOverlayed);
+        d->m_overlayFrame = frame;
+    }
+
     d->m_overlayedDockWidget = dw;
     frame->addWidget(dw);
     d->updateOverlayGeometry(dw->d->lastPosition()->lastOverlayedGeometry(sb->location()).size());
@@ -584,16 +598,18 @@ void MainWindowBase::clearSideBarOverlay(bool deleteFrame)
     d->m_overlayedDockWidget->d->lastPosition()->setLastOverlayedGeometry(
         loc, frame->QWidgetAdapter::geometry());
 
-    frame->unoverlay();
-
     if (deleteFrame) {
+        // The frame stays overlayed and hidden, ready for the next overlayOnSideBar()
+        frame->QWidgetAdapter::setVisible(false);
         d->m_overlayedDockWidget->setParent(nullptr);
         Q_EMIT d->m_overlayedDockWidget->isOverlayedChanged(false);
         d->m_overlayedDockWidget = nullptr;
-        delete frame;
     } else {
         // No cleanup, just unset. When we drag the overlay it becomes a normal floating window
-        // meaning we reuse Frame. Don't delete it.
+        // meaning we reuse Frame. It's no longer ours to reuse.
+        frame->unoverlay();
+        if (frame == d->m_overlayFrame)
+            d->m_overlayFrame = nullptr;
         Q_EMIT d->m_overlayedDockWidget->isOverlayedChanged(false);
         d->m_overlayedDockWidget = nullptr;
     }
@@ -32,6 +32,7 @@ class TestDocks;
 
 namespace KDDockWidgets {
 
+class AffinitySet;
 class DockWidgetBase;
 class Frame;
 class DropArea;
@@ -189,6 +190,8 @@ public:
     Q_INVOKABLE void toggleOverlayOnSideBar(KDDockWidgets::DockWidgetBase *);
 
     /// @brief closes any overlayed dock widget. The sidebar still displays them as button.
+    /// @param deleteFrame If true the overlay frame is hidden and kept for reuse by the next overlay.
+    /// If false it's handed over to the dock widget, for example when the overlay is dragged away.
     Q_INVOKABLE void clearSideBarOverlay(bool deleteFrame = true);
 
     /// @brief Returns the sidebar this dockwidget is in. nullptr if not in any.
@@ -263,6 +266,12 @@ private:
 
     friend class ::TestDocks;
     friend class LayoutSaver;
+    friend class DockRegistry;
+    friend class DropArea;
+    friend class Frame;
+
+    ///@brief Returns affinities() interned, for fast matching
+    const AffinitySet &affinitySet() const;
     bool deserialize(const LayoutSaver::MainWindow &);
     LayoutSaver::MainWindow serialize() const;
 };
@@ -12,6 +12,8 @@
 #include "MainWindowMDI.h"
 #include "private/MDILayoutWidget_p.h"
 
+#include <QDebug>
+
 using namespace KDDockWidgets;
 
 MainWindowMDI::MainWindowMDI(const QString &uniqueName, WidgetType *parent, Qt::WindowFlags flags)
@@ -33,3 +35,29 @@ void MainWindowMDI::addDockWidget(DockWidgetBase *dockWidget, QPointF localPos,
 {
     MainWindowMDI::addDockWidget(dockWidget, localPos.toPoint(), addingOption);
 }
+
+void MainWindowMDI::setGeometries(const QVector<DockWidgetGeometry> &geometries)
+{
+    QVector<MDILayoutWidget::FrameGeometry> frameGeometries;
+    frameGeometries.reserve(geometries.size());
+    for (const DockWidgetGeometry &g : geometries) {
+        if (Frame *frame = MDILayoutWidget::frameForDockWidget(g.dockWidget)) {
+            frameGeometries.push_back({ frame, g.geometry, g.z });
+        } else {
+            qWarning() << Q_FUNC_INFO << "Dock widget isn't in a MDI area" << g.dockWidget;
+        }
+    }
+
+    auto layout = static_cast<MDILayoutWidget *>(this->layoutWidget());
+    layout->setDockWidgetGeometries(frameGeometries);
+}
+
+void MainWindowMDI::tileDockWidgets()
+{
+    static_cast<MDILayoutWidget *>(this->layoutWidget())->tileDockWidgets();
+}
+
+void MainWindowMDI::cascadeDockWidgets()
+{
+    static_cast<MDILayoutWidget *>(this->layoutWidget())->cascadeDockWidgets();
+}
@@ -25,6 +25,9 @@
 #include "private/quick/MainWindowQuick_p.h"
 #endif
 
+#include <QRect>
+#include <QVector>
+
 namespace KDDockWidgets {
 
 /// @brief MainWindow sub-class which uses MDI as a layout
@@ -45,6 +48,34 @@ public:
 
     ///@brief Convenience overload
     void addDockWidget(DockWidgetBase *dockWidget, QPointF localPos, InitialOption addingOption = {});
+
+    ///@brief The geometry and stacking to apply to a dock widget, see setGeometries()
+    struct DockWidgetGeometry
+    {
+        DockWidgetGeometry() = default;
+        DockWidgetGeometry(DockWidgetBase *dw, QRect geo, int zOrder = -1)
+            : dockWidget(dw)
+            , geometry(geo)
+            , z(zOrder)
+        {
+        }
+
+        DockWidgetBase *dockWidget = nullptr;
+        QRect geometry; ///< In this main window's MDI area coordinates
+        int z = -1; ///< Dock widgets with z >= 0 are raised in increasing z order. -1 keeps the current stacking
+    };
+
+    ///@brief Sets the geometry and stacking of many dock widgets at once
+    /// Much cheaper than moving and resizing them one by one. With QtWidgets the MDI area is only
+    /// repainted once. With QtQuick the items are moved one by one, the scene graph renders them in a
+    /// single frame anyway.
+    void setGeometries(const QVector<DockWidgetGeometry> &geometries);
+
+    ///@brief Arranges the visible dock widgets in a grid filling the MDI area
+    void tileDockWidgets();
+
+    ///@brief Arranges the visible dock widgets diagonally, overlapping, keeping their stacking order
+    void cascadeDockWidgets();
 };
 
 }
@@ -19,6 +19,8 @@
 #include "MainWindow.h"
 #endif
 
+#include "private/LayoutLibrary_p.h"
+
 #include <QApplication>
 #include <QDebug>
 #include <QString>
@@ -38,8 +40,29 @@ static bool lint(const QString &filename)
     KDDockWidgets::Config::self().setDockWidgetFactoryFunc(dwFunc);
     KDDockWidgets::Config::self().setMainWindowFactoryFunc(mwFunc);
 
-    LayoutSaver restorer;
-    return restorer.restoreFromFile(filename);
+    if (!LayoutLibrary::isLibrary(filename)) {
+        LayoutSaver restorer;
+        return restorer.restoreFromFile(filename);
+    }
+
+    // A layout library. Check the index and every checksum first, then restore each layout
+    LayoutLibrary library(filename);
+    if (!library.open() || !library.validate()) {
+        qWarning() << "Invalid layout library" << filename << library.errorString();
+        return false;
+    }
+
+    bool success = true;
+    const QStringList names = library.names();
+    for (const QString &name : names) {
+        LayoutSaver restorer;
+        if (!restorer.restoreLayout(library.layout(name))) {
+            qWarning() << "Failed to restore layout" << name;
+            success = false;
+        }
+    }
+
+    return success;
 }
 
 int main(int argc, char *argv[])
@@ -47,7 +70,7 @@ int main(int argc, char *argv[])
     QApplication app(argc, argv);
 
     if (app.arguments().size() != 2) {
-        qDebug() << "Usage: kddockwidgets_linter <layout json file>";
+        qDebug() << "Usage: kddockwidgets_linter <layout json file or layout library>";
         return 1;
     }
 
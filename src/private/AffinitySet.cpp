@@ -0,0 +1,74 @@
+/*
+  This file is part of KDDockWidgets.
+
+  SPDX-FileCopyrightText: 2020-2022 Klarälvdalens Datakonsult AB, a KDAB Group company <info@kdab.com>
+  Author: Sérgio Martins <sergio.martins@kdab.com>
+
+  SPDX-License-Identifier: GPL-2.0-only OR GPL-3.0-only
+
+  Contact KDAB at <info@kdab.com> for commercial licensing options.
+*/
+
+#include "AffinitySet_p.h"
+
+#include <QHash>
+
+#include <algorithm>
+
+using namespace KDDockWidgets;
+
+/// @brief The interning table. Process wide, since ids are held by objects which can outlive
+/// the DockRegistry. There's only a handful of affinity names in practice, so it's never pruned.
+static QHash<QString, int> &internedNames()
+{
+    static QHash<QString, int> s_names;
+    return s_names;
+}
+
+AffinitySet::AffinitySet(const QStringList &affinities)
+{
+    for (const QString &name : affinities) {
+        const int id = idForName(name);
+        if (id < 64) {
+            m_bits |= quint64(1) << id;
+        } else {
+            auto it = std::lower_bound(m_overflowIds.begin(), m_overflowIds.end(), id);
+            if (it == m_overflowIds.end() || *it != id)
+                m_overflowIds.insert(it, id);
+        }
+    }
+}
+
+int AffinitySet::idForName(const QString &name)
+{
+    QHash<QString, int> &names = internedNames();
+    auto it = names.constFind(name);
+    if (it != names.cend())
+        return it.value();
+
+    const int id = int(names.size());
+    names.insert(name, id);
+    return id;
+}
+
+int AffinitySet::numInternedNames()
+{
+    return int(internedNames().size());
+}
+
+bool AffinitySet::overflowIntersects(const AffinitySet &other) const
+{
+    // Both are sorted
+    auto it1 = m_overflowIds.cbegin();
+    auto it2 = other.m_overflowIds.cbegin();
+    while (it1 != m_overflowIds.cend() && it2 != other.m_overflowIds.cend()) {
+        if (*it1 == *it2)
+            return true;
+        if (*it1 < *it2)
+            ++it1;
+        else
+            ++it2;
+    }
+
+    return false;
+}
@@ -0,0 +1,80 @@
+/*
+  This file is part of KDDockWidgets.
+
+  SPDX-FileCopyrightText: 2020-2022 Klarälvdalens Datakonsult AB, a KDAB Group company <info@kdab.com>
+  Author: Sérgio Martins <sergio.martins@kdab.com>
+
+  SPDX-License-Identifier: GPL-2.0-only OR GPL-3.0-only
+
+  Contact KDAB at <info@kdab.com> for commercial licensing options.
+*/
+
+/**
+ * @file
+ * @brief Affinity names interned into a bitset, for cheap matching.
+ *
+ * @author Sérgio Martins \<sergio.martins@kdab.com\>
+ */
+
+#ifndef KDDOCKWIDGETS_AFFINITYSET_P_H
+#define KDDOCKWIDGETS_AFFINITYSET_P_H
+
+#include "kddockwidgets/docks_export.h"
+
+#include <QStringList>
+#include <QVector>
+
+namespace KDDockWidgets {
+
+///@brief A set of affinities, where each name is interned into a process wide id.
+/// Matching two sets is a bitwise AND, instead of comparing every pair of strings.
+/// The first 64 distinct names go into the bitmask, any further ones into a small sorted vector.
+class DOCKS_EXPORT_FOR_UNIT_TESTS AffinitySet
+{
+public:
+    AffinitySet() = default;
+    explicit AffinitySet(const QStringList &affinities);
+
+    bool isEmpty() const
+    {
+        return m_bits == 0 && m_overflowIds.isEmpty();
+    }
+
+    ///@brief Returns whether there's at least one affinity in common, or if both are empty.
+    /// Same semantics as DockRegistry::affinitiesMatch(), which takes string lists.
+    bool matches(const AffinitySet &other) const
+    {
+        if ((m_bits & other.m_bits) != 0)
+            return true;
+
+        if (m_overflowIds.isEmpty() || other.m_overflowIds.isEmpty())
+            return isEmpty() && other.isEmpty();
+
+        return overflowIntersects(other);
+    }
+
+    bool operator==(const AffinitySet &other) const
+    {
+        return m_bits == other.m_bits && m_overflowIds == other.m_overflowIds;
+    }
+
+    bool operator!=(const AffinitySet &other) const
+    {
+        return !(*this == other);
+    }
+
+    ///@brief Returns the id of @p name, interning it if it's new. Ids are never reused.
+    static int idForName(const QString &name);
+
+    ///@brief Returns how many distinct names were interned so far
+    static int numInternedNames();
+
+private:
+    bool overflowIntersects(const AffinitySet &other) const;
+    quint64 m_bits = 0; ///< ids 0 to 63
+    QVector<int> m_overflowIds; ///< sorted ids >= 64
+};
+
+}
+
+#endif
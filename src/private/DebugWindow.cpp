@@ -24,9 +24,13 @@
 #include "MainWindow.h"
 #include "ObjectViewer_p.h"
 #include "Qt5Qt6Compat_p.h"
+#include "multisplitter/PerfCounters_p.h"
 
 #include <QVBoxLayout>
 #include <QHBoxLayout>
+#include <QGridLayout>
+#include <QGroupBox>
+#include <QLabel>
 #include <QPushButton>
 #include <QLineEdit>
 #include <QSpinBox>
@@ -262,9 +266,91 @@ DebugWindow::DebugWindow(QWidget *parent)
     connect(button, &QPushButton::clicked, this, &DebugWindow::dumpWindows);
 #endif
 
+    setupPerfCountersPanel(layout);
+
     resize(800, 800);
 }
 
+void DebugWindow::setupPerfCountersPanel(QVBoxLayout *layout)
+{
+    using Layouting::PerfCounters;
+
+    auto group = new QGroupBox(QStringLiteral("Performance counters"), this);
+    auto grid = new QGridLayout(group);
+    grid->addWidget(new QLabel(QStringLiteral("<b>Counter</b>"), group), 0, 0);
+    grid->addWidget(new QLabel(QStringLiteral("<b>Total</b>"), group), 0, 1);
+    grid->addWidget(new QLabel(QStringLiteral("<b>Per second</b>"), group), 0, 2);
+
+    for (int i = 0; i < PerfCounters::Counter_Count; ++i) {
+        const auto counter = PerfCounters::Counter(i);
+        auto totalLabel = new QLabel(group);
+        auto rateLabel = new QLabel(group);
+        grid->addWidget(new QLabel(QString::fromLatin1(PerfCounters::name(counter)), group), i + 1, 0);
+        grid->addWidget(totalLabel, i + 1, 1);
+        grid->addWidget(rateLabel, i + 1, 2);
+        m_counterTotalLabels.push_back(totalLabel);
+        m_counterRateLabels.push_back(rateLabel);
+        m_lastCounterValues.push_back(PerfCounters::value(counter));
+    }
+
+    m_placeholdersLabel = new QLabel(group);
+    m_placeholdersLabel->setWordWrap(true);
+    grid->addWidget(m_placeholdersLabel, PerfCounters::Counter_Count + 1, 0, 1, 3);
+
+    auto button = new QPushButton(QStringLiteral("Reset counters"), group);
+    grid->addWidget(button, PerfCounters::Counter_Count + 2, 0, 1, 3);
+    connect(button, &QPushButton::clicked, this, &DebugWindow::resetPerfCounters);
+
+    button = new QPushButton(QStringLiteral("Compact placeholders"), group);
+    grid->addWidget(button, PerfCounters::Counter_Count + 3, 0, 1, 3);
+    connect(button, &QPushButton::clicked, this, [this] {
+        DockRegistry::self()->compactPlaceholders();
+        updatePerfCounters();
+    });
+
+    layout->addWidget(group);
+
+    auto timer = new QTimer(this);
+    connect(timer, &QTimer::timeout, this, &DebugWindow::updatePerfCounters);
+    timer->start(1000);
+    m_perfCountersTimer.start();
+    updatePerfCounters();
+}
+
+void DebugWindow::updatePerfCounters()
+{
+    using Layouting::PerfCounters;
+
+    const qint64 elapsed = m_perfCountersTimer.restart();
+    for (int i = 0; i < PerfCounters::Counter_Count; ++i) {
+        const quint64 value = PerfCounters::value(PerfCounters::Counter(i));
+        const quint64 delta = value - m_lastCounterValues.at(i);
+        const double rate = elapsed > 0 ? double(delta) * 1000.0 / double(elapsed) : 0.0;
+
+        m_counterTotalLabels.at(i)->setText(QString::number(value));
+        m_counterRateLabels.at(i)->setText(QString::number(rate, 'f', 1));
+        m_lastCounterValues[i] = value;
+    }
+
+    QStringList placeholderCounts;
+    const auto layouts = DockRegistry::self()->layouts();
+    for (LayoutWidget *layout : layouts) {
+        const QString name = layout->objectName().isEmpty() ? QString::fromLatin1(layout->metaObject()->className())
+                                                            : layout->objectName();
+        placeholderCounts << QStringLiteral("%1: %2").arg(name).arg(layout->placeholderCount());
+    }
+
+    m_placeholdersLabel->setText(QStringLiteral("Placeholders per layout: ") + placeholderCounts.join(QStringLiteral(", ")));
+}
+
+void DebugWindow::resetPerfCounters()
+{
+    Layouting::PerfCounters::reset();
+    m_lastCounterValues.fill(0);
+    m_perfCountersTimer.restart();
+    updatePerfCounters();
+}
+
 #ifdef Q_OS_WIN
 void DebugWindow::dumpWindow(QWidget *w)
 {
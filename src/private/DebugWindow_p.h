@@ -20,9 +20,13 @@
 
 #include "ObjectViewer_p.h"
 #include <QWidget>
+#include <QElapsedTimer>
+#include <QVector>
 
 QT_BEGIN_NAMESPACE
 class QEventLoop;
+class QLabel;
+class QVBoxLayout;
 QT_END_NAMESPACE
 
 namespace KDDockWidgets {
@@ -43,8 +47,19 @@ private:
     void repaintWidgetRecursive(QWidget *);
 
     void dumpDockWidgetInfo();
+
+    ///@brief Adds the panel showing Layouting::PerfCounters totals and rates per second
+    void setupPerfCountersPanel(QVBoxLayout *);
+    void updatePerfCounters();
+    void resetPerfCounters();
+
     ObjectViewer m_objectViewer;
     QEventLoop *m_isPickingWidget = nullptr;
+    QVector<QLabel *> m_counterTotalLabels;
+    QVector<QLabel *> m_counterRateLabels;
+    QVector<quint64> m_lastCounterValues;
+    QElapsedTimer m_perfCountersTimer;
+    QLabel *m_placeholdersLabel = nullptr;
 
 protected:
     void mousePressEvent(QMouseEvent *event) override;
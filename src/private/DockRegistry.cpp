@@ -14,9 +14,12 @@
 #include "DockWidgetBase.h"
 #include "DockWidgetBase_p.h"
 #include "FloatingWindow_p.h"
+#include "FocusScope.h"
 #include "LayoutWidget_p.h"
 #include "Logging_p.h"
+#include "MDILayoutWidget_p.h"
 #include "MainWindowMDI.h"
+#include "MultiSplitter_p.h"
 #include "Position_p.h"
 #include "QWidgetAdapter.h"
 #include "SideBar_p.h"
@@ -24,20 +27,84 @@
 #include "WidgetResizeHandler_p.h"
 #include "WindowBeingDragged_p.h"
 #include "multisplitter/Item_p.h"
+#include "multisplitter/PerfCounters_p.h"
 
 #include <QPointer>
 #include <QDebug>
+#include <QScopedValueRollback>
 #include <QGuiApplication>
 #include <QWindow>
 
+#include <algorithm>
+
 #ifdef KDDOCKWIDGETS_QTWIDGETS
 #include "DebugWindow_p.h"
 #else
 #include "quick/QmlTypes.h"
+
+#include <QQuickWindow>
 #endif
 
 using namespace KDDockWidgets;
 
+/// @brief Returns whether @p window is the window of a FloatingWindow, without a linear search
+static bool isFloatingWindowHandle(QWindow *window)
+{
+#ifdef KDDOCKWIDGETS_QTWIDGETS
+    if (!window->handle())
+        return false; // No native window yet, so it has no winId to look up
+    return qobject_cast<FloatingWindow *>(QWidget::find(window->winId())) != nullptr;
+#else
+    // A floating window is the root item of its QQuickWindow
+    if (auto quickWindow = qobject_cast<QQuickWindow *>(window)) {
+        const QList<QQuickItem *> children = quickWindow->contentItem()->childItems();
+        for (QQuickItem *item : children) {
+            if (qobject_cast<FloatingWindow *>(item))
+                return true;
+        }
+    }
+
+    return false;
+#endif
+}
+
+template<typename T>
+static void registerName(QHash<QString, T *> &byName, int &numClashes, T *obj)
+{
+    const QString name = obj->uniqueName();
+    if (name.isEmpty() || byName.contains(name)) {
+        numClashes++;
+    } else {
+        byName.insert(name, obj);
+    }
+}
+
+/// @brief Reverts registerName(). @p remaining is the list of instances without @p obj
+template<typename T>
+static void unregisterName(QHash<QString, T *> &byName, int &numClashes,
+                           const QVector<T *> &remaining, T *obj)
+{
+    const QString name = obj->uniqueName();
+    auto it = byName.find(name);
+    if (it == byName.end() || it.value() != obj) {
+        // It was empty or a duplicate
+        numClashes--;
+        return;
+    }
+
+    byName.erase(it);
+    if (numClashes > 0) {
+        // Promote the next duplicate, if any
+        for (T *other : remaining) {
+            if (other->uniqueName() == name) {
+                byName.insert(name, other);
+                numClashes--;
+                break;
+            }
+        }
+    }
+}
+
 static void initKDDockWidgetResources()
 {
 #if defined(KDDOCKWIDGETS_STATICLIB) || defined(QT_STATIC)
@@ -70,6 +137,17 @@ DockRegistry::DockRegistry(QObject *parent)
     connect(qApp, &QGuiApplication::focusObjectChanged,
             this, &DockRegistry::onFocusObjectChanged);
 
+    connect(&m_placeholderCompactionTimer, &QTimer::timeout,
+            this, &DockRegistry::compactPlaceholders);
+
+    connect(&m_guestHibernationTimer, &QTimer::timeout,
+            this, &DockRegistry::hibernateGuests);
+
+    m_renderVisibilityTimer.setSingleShot(true);
+    m_renderVisibilityTimer.setInterval(0);
+    connect(&m_renderVisibilityTimer, &QTimer::timeout,
+            this, &DockRegistry::updateRenderVisibilities);
+
     initKDDockWidgetResources();
 }
 
@@ -85,27 +163,80 @@ void DockRegistry::maybeDelete()
 
 void DockRegistry::onFocusObjectChanged(QObject *obj)
 {
-    auto p = qobject_cast<WidgetType *>(obj);
-    while (p) {
-        if (auto frame = qobject_cast<Frame *>(p)) {
-            // Special case: The focused widget is inside the frame but not inside the dockwidget.
-            // For example, it's a line edit in the QTabBar. We still need to send the signal for
-            // the current dw in the tab group
-            if (auto dw = frame->currentDockWidget()) {
-                setFocusedDockWidget(dw);
+    // Walk up from the focus object only once. It tells us both which dock widget is focused
+    // and which FocusScopes contain the focus.
+    auto widget = qobject_cast<WidgetType *>(obj);
+    DockWidgetBase *focusedDw = nullptr;
+    bool foundDockWidget = false;
+    QVector<FocusScope *> focusedScopes;
+
+    for (WidgetType *p = widget; p; p = KDDockWidgets::Private::parentWidget(p)) {
+        if (!foundDockWidget) {
+            if (auto frame = qobject_cast<Frame *>(p)) {
+                // Special case: The focused widget is inside the frame but not inside the dockwidget.
+                // For example, it's a line edit in the QTabBar. We still need to send the signal for
+                // the current dw in the tab group
+                focusedDw = frame->currentDockWidget();
+                foundDockWidget = true;
+            } else if (auto dw = qobject_cast<DockWidgetBase *>(p)) {
+                focusedDw = dw;
+                foundDockWidget = true;
             }
-
-            return;
         }
 
-        if (auto dw = qobject_cast<DockWidgetBase *>(p)) {
-            DockRegistry::self()->setFocusedDockWidget(dw);
-            return;
+        if (FocusScope *scope = m_focusScopes.value(p))
+            focusedScopes.push_back(scope);
+    }
+
+    // Until they're notified, both the scopes which lost focus and the ones which got it are kept
+    // in m_focusedScopes. Any callback can delete a scope, which unregisters it from there, so
+    // each one is looked up again right before being notified.
+    const QVector<FocusScope *> previouslyFocused = m_focusedScopes;
+    for (FocusScope *scope : qAsConst(focusedScopes)) {
+        if (!m_focusedScopes.contains(scope))
+            m_focusedScopes.push_back(scope);
+    }
+
+    // The focused dock widget is updated first, so scopes already see it when notified.
+    // A frame without current dock widget leaves it untouched.
+    if (foundDockWidget) {
+        if (focusedDw)
+            setFocusedDockWidget(focusedDw);
+    } else {
+        setFocusedDockWidget(nullptr);
+    }
+
+    // Only the scopes that lost or got focus are notified
+    for (FocusScope *scope : previouslyFocused) {
+        if (!focusedScopes.contains(scope) && m_focusedScopes.removeOne(scope))
+            scope->onFocusObjectLeft();
+    }
+
+    for (FocusScope *scope : qAsConst(focusedScopes)) {
+        if (m_focusedScopes.contains(scope))
+            scope->onFocusObjectEntered(widget);
+    }
+}
+
+void DockRegistry::registerFocusScope(FocusScope *scope, QObject *scopeWidget)
+{
+    m_focusScopes.insert(scopeWidget, scope);
+
+    // Initial state, in case the new scope already contains the focus object
+    auto widget = qobject_cast<WidgetType *>(qApp->focusObject());
+    for (WidgetType *p = widget; p; p = KDDockWidgets::Private::parentWidget(p)) {
+        if (p == scopeWidget) {
+            m_focusedScopes.push_back(scope);
+            scope->onFocusObjectEntered(widget);
+            break;
         }
-        p = KDDockWidgets::Private::parentWidget(p);
     }
+}
 
-    setFocusedDockWidget(nullptr);
+void DockRegistry::unregisterFocusScope(FocusScope *scope, QObject *scopeWidget)
+{
+    m_focusScopes.remove(scopeWidget);
+    m_focusedScopes.removeOne(scope);
 }
 
 void DockRegistry::setFocusedDockWidget(DockWidgetBase *dw)
@@ -186,14 +317,16 @@ bool DockRegistry::isProbablyObscured(QWindow *window, FloatingWindow *exclude)
         return false;
 
     const QRect geo = window->geometry();
-    for (FloatingWindow *fw : m_floatingWindows) {
-        QWindow *fwWindow = fw->QWidgetAdapter::windowHandle();
-        if (fw == exclude || fwWindow == window)
-            continue;
+    if (floatingWindowsBoundingRect(exclude).intersects(geo)) {
+        for (FloatingWindow *fw : m_floatingWindows) {
+            QWindow *fwWindow = fw->QWidgetAdapter::windowHandle();
+            if (fw == exclude || !fwWindow || fwWindow == window)
+                continue;
 
-        if (fwWindow->geometry().intersects(geo)) {
-            // fw might be below, but we don't have a way to check. So be conservative and return true.
-            return true;
+            if (fwWindow->geometry().intersects(geo)) {
+                // fw might be below, but we don't have a way to check. So be conservative and return true.
+                return true;
+            }
         }
     }
 
@@ -240,31 +373,35 @@ SideBar *DockRegistry::sideBarForDockWidget(const DockWidgetBase *dw) const
 
 Frame *DockRegistry::frameInMDIResize() const
 {
-    for (auto mw : m_mainWindows) {
-        if (!mw->isMDI())
-            continue;
-
-        LayoutWidget *layout = mw->layoutWidget();
-        const QList<Frame *> frames = layout->frames();
-        for (Frame *frame : frames) {
-            if (WidgetResizeHandler *wrh = frame->resizeHandler()) {
-                if (wrh->isResizing())
-                    return frame;
-            }
+    // The handler can stop resizing without telling us, if the button is released elsewhere
+    if (m_frameInMDIResize) {
+        if (WidgetResizeHandler *wrh = m_frameInMDIResize->resizeHandler()) {
+            if (wrh->isResizing())
+                return m_frameInMDIResize;
         }
     }
 
     return nullptr;
 }
 
+void DockRegistry::setFrameInMDIResize(Frame *frame, bool resizing)
+{
+    if (resizing)
+        m_frameInMDIResize = frame;
+    else if (m_frameInMDIResize == frame)
+        m_frameInMDIResize = nullptr;
+
+    Q_EMIT frameInMDIResizeChanged();
+}
+
 MainWindowBase::List DockRegistry::mainWindowsWithAffinity(const QStringList &affinities) const
 {
     MainWindowBase::List result;
     result.reserve(m_mainWindows.size());
 
+    const AffinitySet affinitySet(affinities);
     for (auto mw : m_mainWindows) {
-        const QStringList mwAffinities = mw->affinities();
-        if (affinitiesMatch(mwAffinities, affinities))
+        if (mw->affinitySet().matches(affinitySet))
             result << mw;
     }
 
@@ -311,6 +448,7 @@ void DockRegistry::registerDockWidget(DockWidgetBase *dock)
     }
 
     m_dockWidgets << dock;
+    registerName(m_dockWidgetsByName, m_numDockWidgetNameClashes, dock);
 }
 
 void DockRegistry::unregisterDockWidget(DockWidgetBase *dock)
@@ -318,7 +456,8 @@ void DockRegistry::unregisterDockWidget(DockWidgetBase *dock)
     if (m_focusedDockWidget == dock)
         m_focusedDockWidget = nullptr;
 
-    m_dockWidgets.removeOne(dock);
+    if (m_dockWidgets.removeOne(dock))
+        unregisterName(m_dockWidgetsByName, m_numDockWidgetNameClashes, m_dockWidgets, dock);
     maybeDelete();
 }
 
@@ -331,25 +470,130 @@ void DockRegistry::registerMainWindow(MainWindowBase *mainWindow)
     }
 
     m_mainWindows << mainWindow;
+    registerName(m_mainWindowsByName, m_numMainWindowNameClashes, mainWindow);
 }
 
 void DockRegistry::unregisterMainWindow(MainWindowBase *mainWindow)
 {
-    m_mainWindows.removeOne(mainWindow);
+    if (m_mainWindows.removeOne(mainWindow))
+        unregisterName(m_mainWindowsByName, m_numMainWindowNameClashes, m_mainWindows, mainWindow);
     maybeDelete();
 }
 
 void DockRegistry::registerFloatingWindow(FloatingWindow *window)
 {
     m_floatingWindows << window;
+    linkFloatingWindowOnTop(window);
+    m_floatingWindowHandlesDirty = true;
+    invalidateFloatingWindowsBoundingRects();
+
+#ifdef KDDOCKWIDGETS_QTQUICK
+    // QtQuick doesn't send WinIdChange, the item moves to another QQuickWindow instead
+    connect(window, &QQuickItem::windowChanged, this, [this] {
+        m_floatingWindowHandlesDirty = true;
+        invalidateFloatingWindowsBoundingRects();
+    });
+#endif
 }
 
 void DockRegistry::unregisterFloatingWindow(FloatingWindow *window)
 {
     m_floatingWindows.removeOne(window);
+    unlinkFloatingWindow(window);
+    m_floatingWindowHandlesDirty = true;
+    invalidateFloatingWindowsBoundingRects();
+    m_floatingWindowsWithDirtyChrome.remove(window);
     maybeDelete();
 }
 
+void DockRegistry::raiseFloatingWindow(FloatingWindow *window)
+{
+    if (window == m_topFloatingWindow)
+        return;
+
+    unlinkFloatingWindow(window);
+    linkFloatingWindowOnTop(window);
+}
+
+void DockRegistry::linkFloatingWindowOnTop(FloatingWindow *window)
+{
+    window->m_windowBelow = m_topFloatingWindow;
+    window->m_windowAbove = nullptr;
+    if (m_topFloatingWindow)
+        m_topFloatingWindow->m_windowAbove = window;
+    else
+        m_bottomFloatingWindow = window;
+    m_topFloatingWindow = window;
+}
+
+void DockRegistry::unlinkFloatingWindow(FloatingWindow *window)
+{
+    if (window->m_windowBelow)
+        window->m_windowBelow->m_windowAbove = window->m_windowAbove;
+    else if (m_bottomFloatingWindow == window)
+        m_bottomFloatingWindow = window->m_windowAbove;
+
+    if (window->m_windowAbove)
+        window->m_windowAbove->m_windowBelow = window->m_windowBelow;
+    else if (m_topFloatingWindow == window)
+        m_topFloatingWindow = window->m_windowBelow;
+
+    window->m_windowBelow = nullptr;
+    window->m_windowAbove = nullptr;
+}
+
+void DockRegistry::rebuildFloatingWindowHandles() const
+{
+    m_floatingWindowsByHandle.clear();
+    m_floatingWindowsByHandle.reserve(m_floatingWindows.size());
+
+    // Windows without a handle yet get one later (when shown, or when QtQuick reparents them), so keep rebuilding until they have it
+    bool missingHandles = false;
+    for (FloatingWindow *fw : m_floatingWindows) {
+        if (QWindow *window = fw->windowHandle())
+            m_floatingWindowsByHandle.insert(window, fw);
+        else
+            missingHandles = true;
+    }
+
+    m_floatingWindowHandlesDirty = missingHandles;
+}
+
+QRect DockRegistry::floatingWindowsBoundingRect(const FloatingWindow *exclude) const
+{
+    auto it = m_floatingWindowsBoundingRects.constFind(exclude);
+    if (it != m_floatingWindowsBoundingRects.cend())
+        return it.value();
+
+    QRect rect;
+    for (FloatingWindow *fw : m_floatingWindows) {
+        if (fw == exclude)
+            continue;
+
+        if (QWindow *window = fw->windowHandle())
+            rect |= window->geometry();
+    }
+
+    m_floatingWindowsBoundingRects.insert(exclude, rect);
+    return rect;
+}
+
+void DockRegistry::invalidateFloatingWindowsBoundingRects(const FloatingWindow *changed)
+{
+    if (!changed) {
+        m_floatingWindowsBoundingRects.clear();
+        return;
+    }
+
+    // The union which leaves out the window that changed is still valid
+    for (auto it = m_floatingWindowsBoundingRects.begin(); it != m_floatingWindowsBoundingRects.end();) {
+        if (it.key() == changed)
+            ++it;
+        else
+            it = m_floatingWindowsBoundingRects.erase(it);
+    }
+}
+
 void DockRegistry::registerLayout(LayoutWidget *layout)
 {
     m_layouts << layout;
@@ -368,6 +612,7 @@ void DockRegistry::registerFrame(Frame *frame)
 void DockRegistry::unregisterFrame(Frame *frame)
 {
     m_frames.removeOne(frame);
+    m_framesWithDirtyChrome.remove(frame);
 }
 
 DockWidgetBase *DockRegistry::focusedDockWidget() const
@@ -387,10 +632,8 @@ bool DockRegistry::containsMainWindow(const QString &uniqueName) const
 
 DockWidgetBase *DockRegistry::dockByName(const QString &name, DockByNameFlags flags) const
 {
-    for (auto dock : qAsConst(m_dockWidgets)) {
-        if (dock->uniqueName() == name)
-            return dock;
-    }
+    if (auto dock = m_dockWidgetsByName.value(name))
+        return dock;
 
     if (flags.testFlag(DockByNameFlag::ConsultRemapping)) {
         // Name doesn't exist, let's check if it was remapped during a layout restore.
@@ -420,12 +663,7 @@ DockWidgetBase *DockRegistry::dockByName(const QString &name, DockByNameFlags fl
 
 MainWindowBase *DockRegistry::mainWindowByName(const QString &name) const
 {
-    for (auto mainWindow : qAsConst(m_mainWindows)) {
-        if (mainWindow->uniqueName() == name)
-            return mainWindow;
-    }
-
-    return nullptr;
+    return m_mainWindowsByName.value(name);
 }
 
 MainWindowMDI *DockRegistry::mdiMainWindowByName(const QString &name) const
@@ -447,6 +685,34 @@ DockWidgetBase *DockRegistry::dockWidgetForGuest(QWidgetOrQuick *guest) const
 }
 
 bool DockRegistry::isSane() const
+{
+    if (m_numDockWidgetNameClashes > 0 || m_numMainWindowNameClashes > 0) {
+        // Only go through the names to tell which ones are wrong
+        return checkNamesSlow();
+    }
+
+    const int interval = Config::self().layoutSanityCheckInterval();
+    if (interval <= 0)
+        return true;
+
+    const quint64 generation = Layouting::Item::layoutGeneration();
+    if (generation == m_saneLayoutGeneration)
+        return true; // Nothing changed since the last successful check
+
+    if (++m_numSanityChecksSkipped < interval)
+        return true;
+
+    m_numSanityChecksSkipped = 0;
+    for (auto mainwindow : qAsConst(m_mainWindows)) {
+        if (!mainwindow->multiSplitter()->checkSanity())
+            return false;
+    }
+
+    m_saneLayoutGeneration = generation;
+    return true;
+}
+
+bool DockRegistry::checkNamesSlow() const
 {
     QSet<QString> names;
     for (auto dock : qAsConst(m_dockWidgets)) {
@@ -474,9 +740,6 @@ bool DockRegistry::isSane() const
         } else {
             names.insert(name);
         }
-
-        if (!mainwindow->multiSplitter()->checkSanity())
-            return false;
     }
 
     return true;
@@ -546,7 +809,7 @@ const QVector<FloatingWindow *> DockRegistry::floatingWindows(bool includeBeingD
     // Returns all the FloatingWindow which aren't being deleted
     QVector<FloatingWindow *> result;
     result.reserve(m_floatingWindows.size());
-    for (FloatingWindow *fw : m_floatingWindows) {
+    for (FloatingWindow *fw = m_bottomFloatingWindow; fw; fw = fw->m_windowAbove) {
         if (includeBeingDeleted || !fw->beingDeleted())
             result.push_back(fw);
     }
@@ -558,7 +821,7 @@ const QVector<QWindow *> DockRegistry::floatingQWindows() const
 {
     QVector<QWindow *> windows;
     windows.reserve(m_floatingWindows.size());
-    for (FloatingWindow *fw : m_floatingWindows) {
+    for (FloatingWindow *fw = m_bottomFloatingWindow; fw; fw = fw->m_windowAbove) {
         if (!fw->beingDeleted()) {
             if (QWindow *window = fw->windowHandle()) {
                 window->setProperty("kddockwidgets_qwidget", QVariant::fromValue<QWidgetOrQuick *>(fw)); // Since QWidgetWindow is private API
@@ -593,12 +856,24 @@ QWindow *DockRegistry::windowForHandle(WId id) const
 
 FloatingWindow *DockRegistry::floatingWindowForHandle(QWindow *windowHandle) const
 {
-    for (FloatingWindow *fw : m_floatingWindows) {
-        if (fw->windowHandle() == windowHandle)
-            return fw;
+    if (!windowHandle)
+        return nullptr;
+
+    if (m_floatingWindowHandlesDirty)
+        rebuildFloatingWindowHandles();
+
+    FloatingWindow *fw = m_floatingWindowsByHandle.value(windowHandle);
+    if (fw && fw->windowHandle() != windowHandle) {
+        // The handle was recreated behind our back. Rare, just rebuild.
+        rebuildFloatingWindowHandles();
+        fw = m_floatingWindowsByHandle.value(windowHandle);
+    } else if (!fw && isFloatingWindowHandle(windowHandle)) {
+        // A floating window got this handle without us being told
+        rebuildFloatingWindowHandles();
+        fw = m_floatingWindowsByHandle.value(windowHandle);
     }
 
-    return nullptr;
+    return fw;
 }
 
 FloatingWindow *DockRegistry::floatingWindowForHandle(WId hwnd) const
@@ -638,7 +913,7 @@ QVector<QWindow *> DockRegistry::topLevels(bool excludeFloatingDocks) const
     windows.reserve(m_floatingWindows.size() + m_mainWindows.size());
 
     if (!excludeFloatingDocks) {
-        for (FloatingWindow *fw : m_floatingWindows) {
+        for (FloatingWindow *fw = m_bottomFloatingWindow; fw; fw = fw->m_windowAbove) {
             if (fw->isVisible()) {
                 if (QWindow *window = fw->windowHandle()) {
                     window->setProperty("kddockwidgets_qwidget", QVariant::fromValue<QWidgetOrQuick *>(fw)); // Since QWidgetWindow is private API
@@ -674,15 +949,16 @@ void DockRegistry::clear(const DockWidgetBase::List &dockWidgets,
                          const MainWindowBase::List &mainWindows,
                          const QStringList &affinities)
 {
+    const AffinitySet affinitySet(affinities);
     for (auto dw : qAsConst(dockWidgets)) {
-        if (affinities.isEmpty() || affinitiesMatch(affinities, dw->affinities())) {
+        if (affinities.isEmpty() || affinitySet.matches(dw->d->affinitySet)) {
             dw->forceClose();
             dw->d->lastPosition()->removePlaceholders();
         }
     }
 
     for (auto mw : qAsConst(mainWindows)) {
-        if (affinities.isEmpty() || affinitiesMatch(affinities, mw->affinities())) {
+        if (affinities.isEmpty() || affinitySet.matches(mw->affinitySet())) {
             mw->multiSplitter()->clearLayout();
         }
     }
@@ -696,8 +972,107 @@ void DockRegistry::ensureAllFloatingWidgetsAreMorphed()
     }
 }
 
+int DockRegistry::compactPlaceholders()
+{
+    const int maxCount = Config::self().maxPlaceholdersPerDockWidget();
+    const int maxAge = Config::self().maxPlaceholderAge();
+    if ((maxCount <= 0 && maxAge <= 0) || LayoutSaver::restoreInProgress())
+        return 0;
+
+    int numPruned = 0;
+    for (DockWidgetBase *dw : qAsConst(m_dockWidgets))
+        numPruned += dw->d->lastPosition()->compactPlaceholders(maxCount, maxAge);
+
+    if (numPruned > 0) {
+        // Removing the placeholders might have left containers with a single child
+        for (LayoutWidget *layout : qAsConst(m_layouts)) {
+            if (auto multiSplitter = qobject_cast<MultiSplitter *>(layout))
+                multiSplitter->rootItem()->removeEmptyContainers();
+        }
+
+        Layouting::PerfCounters::increment(Layouting::PerfCounters::Counter_PlaceholdersPruned, quint64(numPruned));
+    }
+
+    return numPruned;
+}
+
+void DockRegistry::updatePlaceholderCompactionTimer()
+{
+    const int maxCount = Config::self().maxPlaceholdersPerDockWidget();
+    const int maxAge = Config::self().maxPlaceholderAge();
+    if (maxCount <= 0 && maxAge <= 0) {
+        m_placeholderCompactionTimer.stop();
+        return;
+    }
+
+    // Check twice per max-age, but not too often nor too rarely
+    const int interval = maxAge > 0 ? qBound(1000, maxAge / 2, 60000) : 60000;
+    m_placeholderCompactionTimer.start(interval);
+}
+
+int DockRegistry::hibernateGuests()
+{
+    const Config &config = Config::self();
+    const int idleTime = config.guestHibernationIdleTime();
+    const int maxAwake = config.maxAwakeGuests();
+    if ((idleTime <= 0 && maxAwake <= 0) || !config.guestHibernateFunc() || !config.guestFactoryFunc()
+        || LayoutSaver::restoreInProgress())
+        return 0;
+
+    // The hidden times are read once, they keep changing while sorting
+    int numAwake = 0;
+    std::vector<std::pair<qint64, DockWidgetBase *>> candidates;
+    for (DockWidgetBase *dw : qAsConst(m_dockWidgets)) {
+        if (!dw->widget())
+            continue;
+        numAwake++;
+        if (dw->d->canHibernate())
+            candidates.push_back({ dw->d->hiddenTime(), dw });
+    }
+
+    // Hidden for longest goes first
+    std::sort(candidates.begin(), candidates.end(), [](const std::pair<qint64, DockWidgetBase *> &c1,
+                                                       const std::pair<qint64, DockWidgetBase *> &c2) {
+        return c1.first > c2.first;
+    });
+
+    int numHibernated = 0;
+    for (const auto &candidate : candidates) {
+        const bool overBudget = maxAwake > 0 && numAwake > maxAwake;
+        const bool idle = idleTime > 0 && candidate.first >= idleTime;
+        if (!overBudget && !idle)
+            break;
+
+        if (candidate.second->d->hibernate()) {
+            numAwake--;
+            numHibernated++;
+        }
+    }
+
+    if (numHibernated > 0)
+        Layouting::PerfCounters::increment(Layouting::PerfCounters::Counter_GuestsHibernated, quint64(numHibernated));
+
+    return numHibernated;
+}
+
+void DockRegistry::updateGuestHibernationTimer()
+{
+    const Config &config = Config::self();
+    const int idleTime = config.guestHibernationIdleTime();
+    const int maxAwake = config.maxAwakeGuests();
+    if ((idleTime <= 0 && maxAwake <= 0) || !config.guestHibernateFunc() || !config.guestFactoryFunc()) {
+        m_guestHibernationTimer.stop();
+        return;
+    }
+
+    const int interval = idleTime > 0 ? qBound(1000, idleTime / 2, 60000) : 10000;
+    m_guestHibernationTimer.start(interval);
+}
+
 bool DockRegistry::eventFilter(QObject *watched, QEvent *event)
 {
+    Layouting::PerfCounters::increment(Layouting::PerfCounters::Counter_EventFilterInvocations);
+
     if (event->type() == QEvent::Quit && !m_isProcessingAppQuitEvent) {
         m_isProcessingAppQuitEvent = true;
         qApp->sendEvent(qApp, event);
@@ -707,15 +1082,30 @@ bool DockRegistry::eventFilter(QObject *watched, QEvent *event)
         if (auto windowHandle = qobject_cast<QWindow *>(watched)) {
             if (FloatingWindow *fw = floatingWindowForHandle(windowHandle)) {
                 // This floating window was exposed
-                m_floatingWindows.removeOne(fw);
-                m_floatingWindows.append(fw);
+                raiseFloatingWindow(fw);
+                invalidateFloatingWindowsBoundingRects(fw);
             }
+
+            scheduleRenderVisibilityUpdate();
+        }
+    } else if (event->type() == QEvent::Move || event->type() == QEvent::Resize
+               || event->type() == QEvent::WindowStateChange || event->type() == QEvent::Hide) {
+        if (auto windowHandle = qobject_cast<QWindow *>(watched)) {
+            if (FloatingWindow *fw = floatingWindowForHandle(windowHandle))
+                invalidateFloatingWindowsBoundingRects(fw);
+
+            scheduleRenderVisibilityUpdate();
+        }
+    } else if (event->type() == QEvent::WinIdChange) {
+        if (qobject_cast<FloatingWindow *>(watched)) {
+            m_floatingWindowHandlesDirty = true;
+            invalidateFloatingWindowsBoundingRects();
         }
     } else if (event->type() == QEvent::MouseButtonPress) {
         // When clicking on a MDI Frame we raise the window
         if (Frame *f = firstParentOfType<Frame>(watched)) {
-            if (f->isMDI())
-                f->raise();
+            if (MDILayoutWidget *mdi = f->mdiLayoutWidget())
+                mdi->raiseDockWidget(f);
         }
 
         // The following code is for hididng the overlay
@@ -780,3 +1170,98 @@ bool DockRegistry::onDockWidgetPressed(DockWidgetBase *dw, QMouseEvent *ev)
 
     return false;
 }
+
+void DockRegistry::beginChromeUpdateBatch()
+{
+    m_chromeUpdateBatchLevel++;
+}
+
+void DockRegistry::endChromeUpdateBatch()
+{
+    if (m_chromeUpdateBatchLevel == 0) {
+        qWarning() << Q_FUNC_INFO << "Unbalanced call";
+        return;
+    }
+
+    m_chromeUpdateBatchLevel--;
+    if (m_chromeUpdateBatchLevel == 0)
+        flushChromeUpdates();
+}
+
+bool DockRegistry::chromeUpdatesDeferred() const
+{
+    // The batch level doesn't matter while flushing, otherwise flushing inside a batch would
+    // queue each floating window again and never finish
+    switch (m_chromeFlushPhase) {
+    case ChromeFlushPhase::Frames:
+        return true;
+    case ChromeFlushPhase::FloatingWindows:
+        return false;
+    case ChromeFlushPhase::None:
+        break;
+    }
+
+    return m_chromeUpdateBatchLevel > 0;
+}
+
+void DockRegistry::scheduleChromeUpdate(Frame *frame)
+{
+    m_framesWithDirtyChrome.insert(frame);
+}
+
+void DockRegistry::scheduleChromeUpdate(FloatingWindow *fw)
+{
+    m_floatingWindowsWithDirtyChrome.insert(fw);
+}
+
+void DockRegistry::flushChromeUpdates()
+{
+    if (m_chromeFlushPhase != ChromeFlushPhase::None)
+        return;
+
+    QScopedValueRollback<ChromeFlushPhase> phaseGuard(m_chromeFlushPhase);
+
+    // Updating can dirty more windows, so loop until nothing is pending
+    while (!m_framesWithDirtyChrome.isEmpty() || !m_floatingWindowsWithDirtyChrome.isEmpty()) {
+        const QSet<Frame *> frames = m_framesWithDirtyChrome;
+        m_framesWithDirtyChrome.clear();
+
+        // Frames queue their floating window instead of updating it once per frame
+        m_chromeFlushPhase = ChromeFlushPhase::Frames;
+        for (Frame *frame : frames) {
+            if (!frame->beingDeletedLater())
+                frame->updateChrome();
+        }
+
+        const QSet<FloatingWindow *> floatingWindows = m_floatingWindowsWithDirtyChrome;
+        m_floatingWindowsWithDirtyChrome.clear();
+
+        m_chromeFlushPhase = ChromeFlushPhase::FloatingWindows;
+        for (FloatingWindow *fw : floatingWindows) {
+            if (!fw->beingDeleted())
+                fw->updateChrome();
+        }
+    }
+}
+
+ChromeUpdateBatch::ChromeUpdateBatch()
+{
+    DockRegistry::self()->beginChromeUpdateBatch();
+}
+
+ChromeUpdateBatch::~ChromeUpdateBatch()
+{
+    DockRegistry::self()->endChromeUpdateBatch();
+}
+
+void DockRegistry::scheduleRenderVisibilityUpdate()
+{
+    if (!m_renderVisibilityTimer.isActive())
+        m_renderVisibilityTimer.start();
+}
+
+void DockRegistry::updateRenderVisibilities()
+{
+    for (DockWidgetBase *dw : qAsConst(m_dockWidgets))
+        dw->d->updateRenderVisibility();
+}
@@ -20,6 +20,9 @@
 #include <QVector>
 #include <QObject>
 #include <QPointer>
+#include <QRect>
+#include <QSet>
+#include <QTimer>
 
 /**
  * DockRegistry is a singleton that knows about all DockWidgets.
@@ -29,6 +32,7 @@
 namespace KDDockWidgets {
 
 class FloatingWindow;
+class FocusScope;
 class Frame;
 class LayoutWidget;
 class MainWindowMDI;
@@ -78,6 +82,9 @@ public:
     /// @brief returns the dock widget that hosts @p guest widget. Nullptr if there's none.
     DockWidgetBase *dockWidgetForGuest(QWidgetOrQuick *guest) const;
 
+    ///@brief Returns whether dock widget and main window names are unique and non-empty, and,
+    /// according to Config::layoutSanityCheckInterval(), whether the main window layouts are sane.
+    /// Names are tracked at registration time, so that part is O(1).
     bool isSane() const;
 
     ///@brief returns all DockWidget instances
@@ -103,11 +110,17 @@ public:
 
     ///@brief returns all FloatingWindow instances. Not necessarily all floating dock widgets,
     /// As there might be DockWidgets which weren't morphed yet.
+    /// They're sorted by z-order, bottom first, as far as we can tell.
     const QVector<FloatingWindow *> floatingWindows(bool includeBeingDeleted = false) const;
 
     ///@brief overload that returns list of QWindow. This is more friendly for supporting both QtWidgets and QtQuick
     const QVector<QWindow *> floatingQWindows() const;
 
+    ///@brief Returns the union of the geometries of all floating windows, except @p exclude.
+    /// Cached, so it's cheap to rule out that a point or rect touches any floating window.
+    /// Pass the window being dragged as @p exclude, so its moves don't invalidate the cache.
+    QRect floatingWindowsBoundingRect(const FloatingWindow *exclude = nullptr) const;
+
     ///@brief returns whether if there's at least one floating window
     Q_INVOKABLE bool hasFloatingWindows() const;
 
@@ -197,6 +210,8 @@ public:
     /// Nesting is honoured. (MDIArea inside DropArea inside MainWindow, for example)
     bool itemIsInMainWindow(const Layouting::Item *) const;
 
+    ///@brief Returns whether the lists have an affinity in common, or are both empty.
+    /// Hot paths should use the AffinitySet the objects carry instead, see AffinitySet::matches()
     bool affinitiesMatch(const QStringList &affinities1, const QStringList &affinities2) const;
 
     /// @brief Returns a list of all known main window unique names
@@ -226,6 +241,48 @@ public:
     ///@brief Returns the Frame which is being resized in a MDI layout. nullptr if none
     Frame *frameInMDIResize() const;
 
+    ///@brief Called by WidgetResizeHandler when a MDI frame starts or stops being resized
+    void setFrameInMDIResize(Frame *, bool resizing);
+
+    /// @brief Prunes placeholders according to Config::setPlaceholderCompactionPolicy()
+    /// Containers left redundant are collapsed. Does nothing while a layout is being restored.
+    /// @return the number of placeholders pruned
+    Q_INVOKABLE int compactPlaceholders();
+
+    /// @brief Starts or stops the periodic compaction. Called by Config when the policy changes.
+    void updatePlaceholderCompactionTimer();
+
+    /// @brief Hibernates guests according to Config::setGuestHibernationPolicy()
+    /// Does nothing while a layout is being restored or if Config::setGuestHibernationFuncs() wasn't called.
+    /// @return the number of guests hibernated
+    Q_INVOKABLE int hibernateGuests();
+
+    /// @brief Starts or stops the periodic hibernation. Called by Config when the policy changes.
+    void updateGuestHibernationTimer();
+
+    /// @brief Defers Frame and FloatingWindow chrome updates (title bar visibility, float actions,
+    /// titles and icons) until the outermost batch ends, where each dirty window is resolved once.
+    /// Restoring a layout opens a batch. Prefer the public KDDockWidgets::ChromeUpdateBatch.
+    void beginChromeUpdateBatch();
+    void endChromeUpdateBatch();
+
+    /// @brief Returns whether chrome updates should be queued with scheduleChromeUpdate()
+    bool chromeUpdatesDeferred() const;
+
+    /// @brief Marks the frame's chrome as dirty
+    void scheduleChromeUpdate(Frame *);
+
+    /// @overload
+    void scheduleChromeUpdate(FloatingWindow *);
+
+    /// @brief Resolves all pending chrome updates now. Tests can call this instead of closing a batch.
+    /// When called inside a batch, it returns with nothing pending and the batch stays open.
+    Q_INVOKABLE void flushChromeUpdates();
+
+    /// @brief Recomputes DockWidgetBase::renderVisibility() of all dock widgets, on the next event loop iteration.
+    /// Called when top-level windows move, change state or get exposed, as that can change what's obscured.
+    void scheduleRenderVisibilityUpdate();
+
 Q_SIGNALS:
     /// @brief emitted when a main window or a floating window change screen
     void windowChangedScreen(QWindow *);
@@ -244,16 +301,72 @@ private:
     explicit DockRegistry(QObject *parent = nullptr);
     bool onDockWidgetPressed(DockWidgetBase *dw, QMouseEvent *);
     void onFocusObjectChanged(QObject *obj);
+    void registerFocusScope(FocusScope *, QObject *scopeWidget);
+    void unregisterFocusScope(FocusScope *, QObject *scopeWidget);
     void maybeDelete();
     void setFocusedDockWidget(DockWidgetBase *);
+    bool checkNamesSlow() const;
+    void updateRenderVisibilities();
+    void raiseFloatingWindow(FloatingWindow *);
+    void linkFloatingWindowOnTop(FloatingWindow *);
+    void unlinkFloatingWindow(FloatingWindow *);
+    void rebuildFloatingWindowHandles() const;
+
+    ///@brief Drops the cached bounding rects which include @p changed. All of them if nullptr.
+    void invalidateFloatingWindowsBoundingRects(const FloatingWindow *changed = nullptr);
 
     bool m_isProcessingAppQuitEvent = false;
     DockWidgetBase::List m_dockWidgets;
     MainWindowBase::List m_mainWindows;
     QList<Frame *> m_frames;
     QVector<FloatingWindow *> m_floatingWindows;
+
+    ///@brief Ends of the z-order list of floating windows. The links live in FloatingWindow, so raising is O(1).
+    /// Except on Windows and X11 we can't query the stacking order, so a window goes to the top when it's exposed.
+    FloatingWindow *m_bottomFloatingWindow = nullptr;
+    FloatingWindow *m_topFloatingWindow = nullptr;
+
+    ///@brief For floatingWindowForHandle(). Rebuilt when windows are added or removed or their handle changes.
+    mutable QHash<const QWindow *, FloatingWindow *> m_floatingWindowsByHandle;
+    mutable bool m_floatingWindowHandlesDirty = false;
+
+    ///@brief For floatingWindowsBoundingRect(), keyed by the excluded window. nullptr excludes none.
+    mutable QHash<const FloatingWindow *, QRect> m_floatingWindowsBoundingRects;
     QVector<LayoutWidget *> m_layouts;
+
+    ///@brief Name lookups. If names clash the first registered one is kept.
+    QHash<QString, DockWidgetBase *> m_dockWidgetsByName;
+    QHash<QString, MainWindowBase *> m_mainWindowsByName;
+
+    ///@brief Number of registered instances with an empty or duplicate name
+    int m_numDockWidgetNameClashes = 0;
+    int m_numMainWindowNameClashes = 0;
+
+    ///@brief The layout generation the last successful structural check ran at
+    mutable quint64 m_saneLayoutGeneration = 0;
+    mutable int m_numSanityChecksSkipped = 0;
     QPointer<DockWidgetBase> m_focusedDockWidget;
+    QPointer<Frame> m_frameInMDIResize;
+
+    ///@brief All FocusScopes, keyed by their widget, so a focus change needs a single parent walk
+    QHash<const QObject *, FocusScope *> m_focusScopes;
+
+    ///@brief The scopes containing the current focus object. Usually one, more if nested.
+    QVector<FocusScope *> m_focusedScopes;
+    QTimer m_placeholderCompactionTimer;
+    QTimer m_guestHibernationTimer;
+    QTimer m_renderVisibilityTimer;
+    int m_chromeUpdateBatchLevel = 0;
+
+    ///@brief Which windows flushChromeUpdates() is updating, if it's running
+    enum class ChromeFlushPhase {
+        None,
+        Frames, ///< Floating windows are queued, to be updated once after all frames
+        FloatingWindows ///< Nothing is queued anymore, even inside a batch
+    };
+    ChromeFlushPhase m_chromeFlushPhase = ChromeFlushPhase::None;
+    QSet<Frame *> m_framesWithDirtyChrome;
+    QSet<FloatingWindow *> m_floatingWindowsWithDirtyChrome;
 
     ///@brief Dock widget id remapping, used by LayoutSaver
     ///
@@ -13,12 +13,15 @@
 #define KD_DOCKWIDGET_BASE_P_H
 
 #include "DockWidgetBase.h"
+#include "AffinitySet_p.h"
 #include "SideBar_p.h"
 #include "DockRegistry_p.h"
 #include "Position_p.h"
 #include "FloatingWindow_p.h"
 
 #include <QCoreApplication>
+#include <QElapsedTimer>
+#include <QVariant>
 #include <QString>
 #include <QSize>
 
@@ -97,6 +100,23 @@ public:
     void close();
     bool restoreToPreviousPosition();
     void maybeRestoreToPreviousPosition();
+
+    /// @brief Recomputes q->renderVisibility() and emits renderVisibilityChanged() if needed
+    void updateRenderVisibility();
+    DockWidgetBase::RenderVisibility computeRenderVisibility() const;
+
+    /// @brief Returns whether the guest can be hibernated now, see Config::setGuestHibernationFuncs()
+    bool canHibernate() const;
+
+    /// @brief Returns for how long, in ms, the guest wasn't visible. 0 if it's visible.
+    qint64 hiddenTime() const;
+
+    /// @brief Asks the app to serialize the guest and deletes it. The dock widget itself stays.
+    /// @return true if the guest was hibernated
+    bool hibernate();
+
+    /// @brief Recreates the guest via Config::guestFactoryFunc(), if it was hibernated
+    void wakeUp();
     int currentTabIndex() const;
 
     /**
@@ -149,6 +169,7 @@ public:
 
     const QString name;
     QStringList affinities;
+    AffinitySet affinitySet; ///< affinities, interned. Kept in sync with it.
     QString title;
     QIcon titleBarIcon;
     QIcon tabBarIcon;
@@ -167,6 +188,10 @@ public:
     bool m_isMovingToSideBar = false;
     QSize m_lastOverlayedSize = QSize(0, 0);
     int m_userType = 0;
+    DockWidgetBase::RenderVisibility m_renderVisibility = DockWidgetBase::RenderVisibility::Closed;
+    QElapsedTimer m_hiddenTimer; ///< Valid while the guest can't be seen, for hibernation purposes
+    QVariant m_hibernatedState; ///< What GuestHibernateFunc returned
+    bool m_isHibernated = false;
 };
 }
 
@@ -475,8 +475,12 @@ void StateInternalMDIDragging::onEntry()
 
     // Raise the dock widget being dragged
     if (auto tb = qobject_cast<TitleBar *>(q->m_draggable->asWidget())) {
-        if (Frame *f = tb->frame())
-            f->raise();
+        if (Frame *f = tb->frame()) {
+            if (MDILayoutWidget *mdi = f->mdiLayoutWidget())
+                mdi->raiseDockWidget(f);
+            else
+                f->raise();
+        }
     }
 
     Q_EMIT q->isDraggingChanged();
@@ -969,8 +973,10 @@ WidgetType *DragController::qtTopLevelUnderCursor() const
         // The floating window list is sorted by z-order, as we catch QEvent::Expose and move it to last of the list
 
         FloatingWindow *tlwBeingDragged = m_windowBeingDragged->floatingWindow();
-        if (auto tl = qtTopLevelUnderCursor_impl(globalPos, DockRegistry::self()->floatingQWindows(), tlwBeingDragged))
-            return tl;
+        if (DockRegistry::self()->floatingWindowsBoundingRect(tlwBeingDragged).contains(globalPos)) {
+            if (auto tl = qtTopLevelUnderCursor_impl(globalPos, DockRegistry::self()->floatingQWindows(), tlwBeingDragged))
+                return tl;
+        }
 
         return qtTopLevelUnderCursor_impl<WidgetType *>(globalPos,
                                                         DockRegistry::self()->topLevels(/*excludeFloating=*/true),
@@ -982,13 +988,13 @@ WidgetType *DragController::qtTopLevelUnderCursor() const
 }
 
 static DropArea *deepestDropAreaInTopLevel(WidgetType *topLevel, QPoint globalPos,
-                                           const QStringList &affinities)
+                                           const AffinitySet &affinities)
 {
     const auto localPos = topLevel->mapFromGlobal(globalPos);
     auto w = topLevel->childAt(localPos.x(), localPos.y());
     while (w) {
         if (auto dt = qobject_cast<DropArea *>(w)) {
-            if (DockRegistry::self()->affinitiesMatch(dt->affinities(), affinities))
+            if (dt->affinitySet().matches(affinities))
                 return dt;
         }
         w = KDDockWidgets::Private::parentWidget(w);
@@ -1005,10 +1011,10 @@ DropArea *DragController::dropAreaUnderCursor() const
         return nullptr;
     }
 
-    const QStringList affinities = m_windowBeingDragged->floatingWindow()->affinities();
+    const AffinitySet affinities = m_windowBeingDragged->floatingWindow()->affinitySet();
 
     if (auto fw = qobject_cast<FloatingWindow *>(topLevel)) {
-        if (DockRegistry::self()->affinitiesMatch(fw->affinities(), affinities)) {
+        if (fw->affinitySet().matches(affinities)) {
             qCDebug(state) << Q_FUNC_INFO << "Found drop area in floating window";
             return fw->dropArea();
         }
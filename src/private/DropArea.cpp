@@ -79,17 +79,18 @@ Frame::List DropArea::frames() const
 
 Frame *DropArea::frameContainingPos(QPoint globalPos) const
 {
-    const Layouting::Item::List &items = this->items();
-    for (Layouting::Item *item : items) {
-        auto frame = static_cast<Frame *>(item->guestAsQObject());
-        if (!frame || !frame->QWidgetAdapter::isVisible()) {
-            continue;
-        }
-
-        if (frame->containsMouse(globalPos))
-            return frame;
-    }
-    return nullptr;
+    // Called for each mouse move while dragging, so don't ask every frame.
+    // Items are hit-tested via their container's spatial index instead.
+    const QPoint localPos = QWidgetAdapter::mapFromGlobal(globalPos);
+    Layouting::Item *item = rootItem()->itemAt_recursive(localPos);
+    if (!item)
+        return nullptr;
+
+    auto frame = static_cast<Frame *>(item->guestAsQObject());
+    if (!frame || !frame->QWidgetAdapter::isVisible() || !frame->containsMouse(globalPos))
+        return nullptr;
+
+    return frame;
 }
 
 void DropArea::updateFloatingActions()
@@ -190,6 +191,17 @@ QStringList DropArea::affinities() const
     return {};
 }
 
+AffinitySet DropArea::affinitySet() const
+{
+    if (auto mw = mainWindow()) {
+        return mw->affinitySet();
+    } else if (auto fw = floatingWindow()) {
+        return fw->affinitySet();
+    }
+
+    return {};
+}
+
 void DropArea::layoutParentContainerEqually(DockWidgetBase *dw)
 {
     Layouting::Item *item = itemForFrame(dw->d->frame());
@@ -373,17 +385,29 @@ void DropArea::removeHover()
     m_dropIndicatorOverlay->removeHover();
 }
 
+static AffinitySet affinitySetOf(const DockWidgetBase *dw)
+{
+    return dw->dptr()->affinitySet;
+}
+
+template<typename T>
+static AffinitySet affinitySetOf(const T *window)
+{
+    return window->affinitySet();
+}
+
 template<typename T>
 bool DropArea::validateAffinity(T *window, Frame *acceptingFrame) const
 {
-    if (!DockRegistry::self()->affinitiesMatch(window->affinities(), affinities())) {
+    const AffinitySet windowAffinities = affinitySetOf(window);
+    if (!windowAffinities.matches(affinitySet())) {
         return false;
     }
 
     if (acceptingFrame) {
         // We're dropping into another frame (as tabbed), so also check the affinity of the frame
         // not only of the main window, which might be more forgiving
-        if (!DockRegistry::self()->affinitiesMatch(window->affinities(), acceptingFrame->affinities())) {
+        if (!windowAffinities.matches(acceptingFrame->affinitySet())) {
             return false;
         }
     }
@@ -23,6 +23,7 @@
 #include "kddockwidgets/KDDockWidgets.h"
 
 #include "MultiSplitter_p.h"
+#include "AffinitySet_p.h"
 #include "DropIndicatorOverlayInterface_p.h"
 
 class TestDocks;
@@ -68,6 +69,10 @@ public:
     bool hasSingleFrame() const;
 
     QStringList affinities() const;
+
+    ///@brief Returns affinities() interned, for fast matching
+    AffinitySet affinitySet() const;
+
     void layoutParentContainerEqually(DockWidgetBase *);
 
     /// When DockWidget::Option_MDINestable is used, docked MDI dock widgets will be wrapped inside a DropArea, so they accept drops
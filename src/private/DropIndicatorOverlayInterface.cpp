@@ -155,7 +155,7 @@ bool DropIndicatorOverlayInterface::dropIndicatorVisible(DropLocation dropLoc) c
         }
 
         // Only allow to dock to center if the affinities match
-        if (!DockRegistry::self()->affinitiesMatch(m_hoveredFrame->affinities(), windowBeingDragged->affinities()))
+        if (!m_hoveredFrame->affinitySet().matches(windowBeingDragged->affinitySet()))
             return false;
     } else {
         qWarning() << Q_FUNC_INFO << "Unknown drop indicator location" << dropLoc;
@@ -409,13 +409,22 @@ void FloatingWindow::onFrameCountChanged(int count)
 {
     if (count == 0) {
         scheduleDeleteLater();
+    } else if (DockRegistry::self()->chromeUpdatesDeferred()) {
+        DockRegistry::self()->scheduleChromeUpdate(this);
     } else {
-        updateTitleBarVisibility();
-        if (count == 1) // if something was removed, then our single dock widget is floating, we need to check the QAction
-            dropArea()->updateFloatingActions();
+        updateChrome();
     }
 }
 
+void FloatingWindow::updateChrome()
+{
+    updateTitleBarVisibility();
+
+    // if something was removed, then our single dock widget is floating, we need to check the QAction
+    if (m_dropArea->frames().size() == 1)
+        dropArea()->updateFloatingActions();
+}
+
 void FloatingWindow::onVisibleFrameCountChanged(int count)
 {
     if (m_disableSetVisible)
@@ -472,6 +481,12 @@ QStringList FloatingWindow::affinities() const
     return frames.isEmpty() ? QStringList() : frames.constFirst()->affinities();
 }
 
+AffinitySet FloatingWindow::affinitySet() const
+{
+    auto frames = this->frames();
+    return frames.isEmpty() ? AffinitySet() : frames.constFirst()->affinitySet();
+}
+
 void FloatingWindow::updateTitleAndIcon()
 {
     QString title;
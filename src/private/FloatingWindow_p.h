@@ -145,8 +145,15 @@ public:
     void updateTitleAndIcon();
     void updateTitleBarVisibility();
 
+    ///@brief Updates title bar visibility, title, icon and the float actions.
+    /// Called directly or, during a chrome update batch, by DockRegistry::flushChromeUpdates()
+    void updateChrome();
+
     QStringList affinities() const;
 
+    ///@brief Returns affinities() interned, for fast matching
+    AffinitySet affinitySet() const;
+
     /**
      * Returns the drag rect in global coordinates. This is usually the title bar rect.
      * However, when using Config::Flag_HideTitleBarWhenTabsVisible it will be the tab bar background.
@@ -243,6 +250,7 @@ protected:
 
 private:
     Q_DISABLE_COPY(FloatingWindow)
+    friend class DockRegistry;
     QSize maxSizeHint() const;
     void updateSizeConstraints();
     void onFrameCountChanged(int count);
@@ -257,6 +265,9 @@ private:
 #ifdef Q_OS_WIN
     int m_lastHitTest = 0;
 #endif
+    ///@brief Neighbours in DockRegistry's z-order list
+    FloatingWindow *m_windowBelow = nullptr;
+    FloatingWindow *m_windowAbove = nullptr;
 };
 
 }
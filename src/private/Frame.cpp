@@ -33,6 +33,7 @@
 #include "MDILayoutWidget_p.h"
 #include "DropAreaWithCentralFrame_p.h"
 #include "multisplitter/Item_p.h"
+#include "multisplitter/PerfCounters_p.h"
 
 #include <QCloseEvent>
 #include <QTimer>
@@ -72,6 +73,7 @@ Frame::Frame(QWidgetOrQuick *parent, FrameOptions options, int userType)
     , m_userType(userType)
 {
     s_dbg_numFrames++;
+    Layouting::PerfCounters::increment(Layouting::PerfCounters::Counter_FramesCreated);
     DockRegistry::self()->registerFrame(this);
 
     connect(this, &Frame::currentDockWidgetChanged, this, &Frame::updateTitleAndIcon);
@@ -87,6 +89,7 @@ Frame::~Frame()
 {
     m_inDtor = true;
     s_dbg_numFrames--;
+    Layouting::PerfCounters::increment(Layouting::PerfCounters::Counter_FramesDestroyed);
     if (m_layoutItem)
         m_layoutItem->unref();
 
@@ -107,7 +110,11 @@ void Frame::updateTitleAndIcon()
 
         if (auto fw = floatingWindow()) {
             if (fw->hasSingleFrame()) {
-                fw->updateTitleAndIcon();
+                DockRegistry *registry = DockRegistry::self();
+                if (registry->chromeUpdatesDeferred())
+                    registry->scheduleChromeUpdate(fw);
+                else
+                    fw->updateTitleAndIcon();
             }
         }
 
@@ -143,6 +150,8 @@ void Frame::addWidget(Frame *frame, InitialOption addingOption)
         return;
     }
 
+    // Both frames' chrome is updated once, not once per dock widget moved
+    ChromeUpdateBatch batch;
     const auto &docks = frame->dockWidgets();
     for (DockWidgetBase *dockWidget : docks)
         addWidget(dockWidget, addingOption);
@@ -151,6 +160,7 @@ void Frame::addWidget(Frame *frame, InitialOption addingOption)
 void Frame::addWidget(FloatingWindow *floatingWindow, InitialOption addingOption)
 {
     Q_ASSERT(floatingWindow);
+    ChromeUpdateBatch batch;
     for (Frame *f : floatingWindow->frames())
         addWidget(f, addingOption);
 }
@@ -290,23 +300,31 @@ int Frame::dockWidgetCount() const
 void Frame::onDockWidgetCountChanged()
 {
     qCDebug(docking) << "Frame::onDockWidgetCountChanged:" << this << "; widgetCount=" << dockWidgetCount();
-    if (isEmpty() && !isCentralFrame()) {
+    if (isEmpty() && isOverlayed()) {
+        // The main window keeps its overlay frame around for the next overlay
+        QWidgetAdapter::setVisible(false);
+    } else if (isEmpty() && !isCentralFrame()) {
         scheduleDeleteLater();
+    } else if (DockRegistry::self()->chromeUpdatesDeferred()) {
+        DockRegistry::self()->scheduleChromeUpdate(this);
     } else {
-        updateTitleBarVisibility();
-
-        // We don't really keep track of the state, so emit even if the visibility didn't change. No biggie.
-        if (!(m_options & FrameOption_AlwaysShowsTabs))
-            Q_EMIT hasTabsVisibleChanged();
-
-        const DockWidgetBase::List docks = dockWidgets();
-        for (DockWidgetBase *dock : docks)
-            dock->d->updateFloatAction();
+        updateChrome();
     }
 
     Q_EMIT numDockWidgetsChanged();
 }
 
+void Frame::updateChrome()
+{
+    updateTitleBarVisibility();
+
+    // We don't really keep track of the state, so emit even if the visibility didn't change. No biggie.
+    if (!(m_options & FrameOption_AlwaysShowsTabs))
+        Q_EMIT hasTabsVisibleChanged();
+
+    updateFloatingActions();
+}
+
 void Frame::onCurrentTabChanged(int index)
 {
     if (index != -1) {
@@ -316,6 +334,11 @@ void Frame::onCurrentTabChanged(int index)
             qWarning() << "dockWidgetAt" << index << "returned nullptr" << this;
         }
     }
+
+    // Tabs going in and out of view don't always get show/hide events, depending on the tab widget
+    const DockWidgetBase::List docks = dockWidgets();
+    for (DockWidgetBase *dock : docks)
+        dock->d->updateRenderVisibility();
 }
 
 void Frame::isFocusedChangedCallback()
@@ -336,6 +359,7 @@ void Frame::updateTitleBarVisibility()
     }
 
     QScopedValueRollback<bool> guard(m_updatingTitleBar, true);
+    Layouting::PerfCounters::increment(Layouting::PerfCounters::Counter_TitleBarVisibilityUpdates);
 
     bool visible = false;
     if (isCentralFrame()) {
@@ -364,7 +388,11 @@ void Frame::updateTitleBarVisibility()
     if (auto fw = floatingWindow()) {
         // Update the floating window which might be using Flag_HideTitleBarWhenTabsVisible
         // In that case it might not show title bar depending on the number of tabs that the frame has
-        fw->updateTitleBarVisibility();
+        DockRegistry *registry = DockRegistry::self();
+        if (registry->chromeUpdatesDeferred())
+            registry->scheduleChromeUpdate(fw);
+        else
+            fw->updateTitleBarVisibility();
     }
 }
 
@@ -596,6 +624,17 @@ QStringList Frame::affinities() const
     }
 }
 
+AffinitySet Frame::affinitySet() const
+{
+    if (isEmpty()) {
+        if (auto m = mainWindow())
+            return m->affinitySet();
+        return {};
+    } else {
+        return dockWidgetAt(0)->dptr()->affinitySet;
+    }
+}
+
 void Frame::setLayoutWidget(LayoutWidget *dt)
 {
     if (dt == m_layoutWidget)
@@ -846,8 +885,8 @@ bool Frame::anyDockWidgetsHas(DockWidgetBase::LayoutSaverOption option) const
 void Frame::setAllowedResizeSides(CursorPositions sides)
 {
     if (sides) {
-        delete m_resizeHandler;
-        m_resizeHandler = new WidgetResizeHandler(WidgetResizeHandler::EventFilterMode::Global, WidgetResizeHandler::WindowMode::MDI, this);
+        if (!m_resizeHandler)
+            m_resizeHandler = new WidgetResizeHandler(WidgetResizeHandler::EventFilterMode::Global, WidgetResizeHandler::WindowMode::MDI, this);
         m_resizeHandler->setAllowedResizeSides(sides);
     } else {
         delete m_resizeHandler;
@@ -25,6 +25,7 @@
 #include "kddockwidgets/DockWidgetBase.h"
 #include "kddockwidgets/LayoutSaver.h"
 #include "multisplitter/Widget.h"
+#include "AffinitySet_p.h"
 
 #include <QVector>
 #include <QDebug>
@@ -119,6 +120,10 @@ public:
     void onDockWidgetTitleChanged();
     void updateTitleBarVisibility();
     void updateFloatingActions();
+
+    ///@brief Updates title bar visibility and the float actions.
+    /// Called directly or, during a chrome update batch, by DockRegistry::flushChromeUpdates()
+    void updateChrome();
     bool containsMouse(QPoint globalPos) const;
     TitleBar *titleBar() const;
     TitleBar *actualTitleBar() const;
@@ -255,6 +260,9 @@ public:
 
     QStringList affinities() const;
 
+    ///@brief Returns affinities() interned, for fast matching
+    AffinitySet affinitySet() const;
+
     ///@brief sets the layout item that either contains this Frame in the layout or is a placeholder
     void setLayoutItem(Layouting::Item *item) override;
 
@@ -0,0 +1,381 @@
+/*
+  This file is part of KDDockWidgets.
+
+  SPDX-FileCopyrightText: 2020-2022 Klarälvdalens Datakonsult AB, a KDAB Group company <info@kdab.com>
+  Author: Sérgio Martins <sergio.martins@kdab.com>
+
+  SPDX-License-Identifier: GPL-2.0-only OR GPL-3.0-only
+
+  Contact KDAB at <info@kdab.com> for commercial licensing options.
+*/
+
+#include "LayoutLibrary_p.h"
+
+#include <QSaveFile>
+#include <QtEndian>
+
+#include <cstring>
+#include <limits>
+
+using namespace KDDockWidgets;
+
+static const char s_magic[8] = { 'K', 'D', 'D', 'W', 'L', 'I', 'B', '\0' };
+static const quint32 s_libraryVersion = 1;
+static const quint64 s_headerSize = 32;
+static const quint64 s_entryFixedSize = 2 + 4 + 8 + 8 + 8; // Everything but the name
+
+template<typename T>
+static void appendLittleEndian(QByteArray &data, T value)
+{
+    char buffer[sizeof(T)];
+    qToLittleEndian<T>(value, buffer);
+    data.append(buffer, int(sizeof(T)));
+}
+
+LayoutLibrary::LayoutLibrary(const QString &filename)
+    : m_filename(filename)
+    , m_file(filename)
+{
+}
+
+LayoutLibrary::~LayoutLibrary()
+{
+    close();
+}
+
+bool LayoutLibrary::open()
+{
+    close();
+    m_errorString.clear();
+
+    if (!QFile::exists(m_filename)) {
+        m_isOpen = true;
+        return true;
+    }
+
+    if (!m_file.open(QIODevice::ReadOnly))
+        return setError(m_file.errorString());
+
+    m_size = quint64(m_file.size());
+    if (m_size < s_headerSize) {
+        close();
+        return setError(QStringLiteral("File is too small to be a layout library"));
+    }
+
+    m_data = m_file.map(0, m_file.size());
+    if (!m_data) {
+        const QString error = m_file.errorString();
+        close();
+        return setError(error);
+    }
+
+    if (std::memcmp(m_data, s_magic, sizeof(s_magic)) != 0) {
+        close();
+        return setError(QStringLiteral("File is not a layout library"));
+    }
+
+    const quint32 version = qFromLittleEndian<quint32>(m_data + 8);
+    const quint32 count = qFromLittleEndian<quint32>(m_data + 12);
+    const quint64 indexSize = qFromLittleEndian<quint64>(m_data + 16);
+    const quint64 indexChecksum = qFromLittleEndian<quint64>(m_data + 24);
+
+    if (version > s_libraryVersion) {
+        close();
+        return setError(QStringLiteral("Unsupported library version %1").arg(version));
+    }
+
+    if (indexSize > m_size - s_headerSize) {
+        close();
+        return setError(QStringLiteral("The index is truncated"));
+    }
+
+    const uchar *pos = m_data + s_headerSize;
+    const uchar *const end = pos + indexSize;
+    if (checksum(reinterpret_cast<const char *>(pos), indexSize) != indexChecksum) {
+        close();
+        return setError(QStringLiteral("The index is corrupt"));
+    }
+
+    // count isn't trusted for the reservation, each entry takes at least s_entryFixedSize bytes
+    m_entries.reserve(int(qMin(quint64(count), indexSize / s_entryFixedSize)));
+    for (quint32 i = 0; i < count; ++i) {
+        if (quint64(end - pos) < s_entryFixedSize) {
+            close();
+            return setError(QStringLiteral("The index is truncated"));
+        }
+
+        const quint16 nameSize = qFromLittleEndian<quint16>(pos);
+        pos += 2;
+        if (quint64(end - pos) < s_entryFixedSize - 2 + nameSize) {
+            close();
+            return setError(QStringLiteral("The index is truncated"));
+        }
+
+        Entry entry;
+        entry.name = QString::fromUtf8(reinterpret_cast<const char *>(pos), int(nameSize));
+        pos += nameSize;
+        entry.formatVersion = int(qFromLittleEndian<quint32>(pos));
+        entry.offset = qFromLittleEndian<quint64>(pos + 4);
+        entry.size = qFromLittleEndian<quint64>(pos + 12);
+        entry.checksum = qFromLittleEndian<quint64>(pos + 20);
+        pos += s_entryFixedSize - 2;
+        m_entries.push_back(entry);
+    }
+
+    m_isOpen = true;
+    return true;
+}
+
+void LayoutLibrary::close()
+{
+    if (m_data) {
+        m_file.unmap(const_cast<uchar *>(m_data));
+        m_data = nullptr;
+    }
+
+    m_file.close();
+    m_size = 0;
+    m_entries.clear();
+    m_isOpen = false;
+}
+
+bool LayoutLibrary::isOpen() const
+{
+    return m_isOpen;
+}
+
+QStringList LayoutLibrary::names() const
+{
+    QStringList result;
+    result.reserve(m_entries.size());
+    for (const Entry &entry : m_entries)
+        result.push_back(entry.name);
+
+    return result;
+}
+
+QVector<LayoutLibrary::Entry> LayoutLibrary::entries() const
+{
+    return m_entries;
+}
+
+bool LayoutLibrary::contains(const QString &name) const
+{
+    return indexOf(name) != -1;
+}
+
+QByteArray LayoutLibrary::layout(const QString &name)
+{
+    const int index = indexOf(name);
+    if (index == -1) {
+        setError(QStringLiteral("No layout named %1").arg(name));
+        return {};
+    }
+
+    const Entry &entry = m_entries.at(index);
+    if (!entryIsValid(entry))
+        return {};
+
+    // A deep copy, insert() and remove() replace the file and unmap it
+    return QByteArray(reinterpret_cast<const char *>(m_data + entry.offset), int(entry.size));
+}
+
+bool LayoutLibrary::insert(const QString &name, const QByteArray &data, int formatVersion)
+{
+    if (!m_isOpen)
+        return setError(QStringLiteral("The library isn't open"));
+
+    if (name.isEmpty())
+        return setError(QStringLiteral("Layouts need a name"));
+
+    QVector<Entry> newEntries;
+    QVector<QByteArray> blobs;
+    newEntries.reserve(m_entries.size() + 1);
+    blobs.reserve(m_entries.size() + 1);
+
+    // The layouts we keep are copied straight from the mapped file, they aren't parsed
+    for (const Entry &entry : qAsConst(m_entries)) {
+        if (!entryIsValid(entry))
+            return false;
+
+        newEntries.push_back(entry);
+        blobs.push_back(QByteArray::fromRawData(reinterpret_cast<const char *>(m_data + entry.offset),
+                                                int(entry.size)));
+    }
+
+    Entry newEntry;
+    newEntry.name = name;
+    newEntry.formatVersion = formatVersion;
+    newEntry.checksum = checksum(data.constData(), quint64(data.size()));
+
+    const int index = indexOf(name);
+    if (index == -1) {
+        newEntries.push_back(newEntry);
+        blobs.push_back(data);
+    } else {
+        newEntries[index] = newEntry;
+        blobs[index] = data;
+    }
+
+    return write(newEntries, blobs);
+}
+
+bool LayoutLibrary::remove(const QString &name)
+{
+    if (!m_isOpen)
+        return setError(QStringLiteral("The library isn't open"));
+
+    const int index = indexOf(name);
+    if (index == -1)
+        return setError(QStringLiteral("No layout named %1").arg(name));
+
+    QVector<Entry> newEntries;
+    QVector<QByteArray> blobs;
+    for (int i = 0; i < m_entries.size(); ++i) {
+        const Entry &entry = m_entries.at(i);
+        if (i == index)
+            continue;
+
+        if (!entryIsValid(entry))
+            return false;
+
+        newEntries.push_back(entry);
+        blobs.push_back(QByteArray::fromRawData(reinterpret_cast<const char *>(m_data + entry.offset),
+                                                int(entry.size)));
+    }
+
+    return write(newEntries, blobs);
+}
+
+bool LayoutLibrary::validate()
+{
+    if (!m_isOpen)
+        return false;
+
+    QStringList seenNames;
+    seenNames.reserve(m_entries.size());
+    for (const Entry &entry : qAsConst(m_entries)) {
+        if (seenNames.contains(entry.name))
+            return setError(QStringLiteral("Duplicate layout name %1").arg(entry.name));
+        seenNames.push_back(entry.name);
+
+        if (!entryIsValid(entry))
+            return false;
+    }
+
+    return true;
+}
+
+QString LayoutLibrary::errorString() const
+{
+    return m_errorString;
+}
+
+bool LayoutLibrary::isLibrary(const QString &filename)
+{
+    QFile file(filename);
+    if (!file.open(QIODevice::ReadOnly))
+        return false;
+
+    return file.read(sizeof(s_magic)) == QByteArray(s_magic, int(sizeof(s_magic)));
+}
+
+quint64 LayoutLibrary::checksum(const char *data, quint64 size)
+{
+    quint64 hash = 14695981039346656037ULL;
+    for (quint64 i = 0; i < size; ++i)
+        hash = (hash ^ quint8(data[i])) * 1099511628211ULL;
+
+    return hash;
+}
+
+int LayoutLibrary::indexOf(const QString &name) const
+{
+    for (int i = 0; i < m_entries.size(); ++i) {
+        if (m_entries.at(i).name == name)
+            return i;
+    }
+
+    return -1;
+}
+
+bool LayoutLibrary::entryIsValid(const Entry &entry)
+{
+    if (entry.offset < s_headerSize || entry.offset > m_size || entry.size > m_size - entry.offset
+        || entry.size > quint64(std::numeric_limits<int>::max())) {
+        return setError(QStringLiteral("Layout %1 is truncated").arg(entry.name));
+    }
+
+    if (checksum(reinterpret_cast<const char *>(m_data + entry.offset), entry.size) != entry.checksum)
+        return setError(QStringLiteral("Layout %1 is corrupt").arg(entry.name));
+
+    return true;
+}
+
+bool LayoutLibrary::write(QVector<Entry> entries, const QVector<QByteArray> &blobs)
+{
+    Q_ASSERT(entries.size() == blobs.size());
+
+    QVector<QByteArray> utf8Names;
+    utf8Names.reserve(entries.size());
+    quint64 indexSize = 0;
+    for (const Entry &entry : qAsConst(entries)) {
+        const QByteArray utf8Name = entry.name.toUtf8();
+        if (utf8Name.size() > std::numeric_limits<quint16>::max())
+            return setError(QStringLiteral("Layout name is too long"));
+
+        utf8Names.push_back(utf8Name);
+        indexSize += s_entryFixedSize + quint64(utf8Name.size());
+    }
+
+    // The blobs follow the index, whose size doesn't depend on the offsets
+    QByteArray index;
+    index.reserve(int(indexSize));
+    quint64 offset = s_headerSize + indexSize;
+    for (int i = 0; i < entries.size(); ++i) {
+        Entry &entry = entries[i];
+        entry.offset = offset;
+        entry.size = quint64(blobs.at(i).size());
+        offset += entry.size;
+
+        const QByteArray &utf8Name = utf8Names.at(i);
+        appendLittleEndian<quint16>(index, quint16(utf8Name.size()));
+        index.append(utf8Name);
+        appendLittleEndian<quint32>(index, quint32(entry.formatVersion));
+        appendLittleEndian<quint64>(index, entry.offset);
+        appendLittleEndian<quint64>(index, entry.size);
+        appendLittleEndian<quint64>(index, entry.checksum);
+    }
+
+    QByteArray header(s_magic, int(sizeof(s_magic)));
+    appendLittleEndian<quint32>(header, s_libraryVersion);
+    appendLittleEndian<quint32>(header, quint32(entries.size()));
+    appendLittleEndian<quint64>(header, indexSize);
+    appendLittleEndian<quint64>(header, checksum(index.constData(), quint64(index.size())));
+
+    QSaveFile file(m_filename);
+    if (!file.open(QIODevice::WriteOnly))
+        return setError(file.errorString());
+
+    file.write(header);
+    file.write(index);
+    for (const QByteArray &blob : blobs)
+        file.write(blob);
+
+    // The blobs we kept reference the old file, so only unmap it now. It must be closed before
+    // it's replaced, as that's not allowed on Windows.
+    close();
+    if (!file.commit()) {
+        const QString error = file.errorString();
+        open();
+        return setError(error);
+    }
+
+    return open();
+}
+
+bool LayoutLibrary::setError(const QString &error)
+{
+    m_errorString = error;
+    return false;
+}
@@ -0,0 +1,117 @@
+/*
+  This file is part of KDDockWidgets.
+
+  SPDX-FileCopyrightText: 2020-2022 Klarälvdalens Datakonsult AB, a KDAB Group company <info@kdab.com>
+  Author: Sérgio Martins <sergio.martins@kdab.com>
+
+  SPDX-License-Identifier: GPL-2.0-only OR GPL-3.0-only
+
+  Contact KDAB at <info@kdab.com> for commercial licensing options.
+*/
+
+#ifndef KD_LAYOUTLIBRARY_P_H
+#define KD_LAYOUTLIBRARY_P_H
+
+#include "kddockwidgets/docks_export.h"
+
+#include <QByteArray>
+#include <QFile>
+#include <QString>
+#include <QStringList>
+#include <QVector>
+
+namespace KDDockWidgets {
+
+/**
+ * @brief A single file holding many named layouts
+ *
+ * The file starts with a small header and an index, followed by the layouts, stored as the JSON
+ * produced by LayoutSaver::serializeLayout(). The file is memory mapped, so listing the layouts
+ * only touches the header and the index, and reading a layout only touches its own bytes.
+ *
+ * Format, all integers are little-endian:
+ *
+ *     header: magic "KDDWLIB\0", quint32 library version, quint32 entry count,
+ *             quint64 index size, quint64 index checksum
+ *     index:  per entry: quint16 name size, UTF-8 name, quint32 layout format version,
+ *             quint64 offset, quint64 size, quint64 checksum
+ *     blobs:  the layouts, at the offsets stored in the index
+ *
+ * Checksums are 64-bit FNV-1a. Modifications rewrite the file through QSaveFile, so readers
+ * either see the old or the new library, never a partially written one.
+ */
+class DOCKS_EXPORT_FOR_UNIT_TESTS LayoutLibrary
+{
+public:
+    struct Entry
+    {
+        QString name;
+        int formatVersion = 0;
+        quint64 offset = 0;
+        quint64 size = 0;
+        quint64 checksum = 0;
+    };
+
+    explicit LayoutLibrary(const QString &filename);
+    ~LayoutLibrary();
+
+    ///@brief Maps the file and reads its index
+    /// Returns false if the file can't be opened or isn't a valid library. A library which doesn't
+    /// exist yet isn't an error, it's just empty.
+    bool open();
+
+    ///@brief Unmaps the file. Layouts already returned by layout() are copies and stay valid.
+    void close();
+
+    bool isOpen() const;
+
+    ///@brief Returns the names of the layouts in the library, in the order they were added
+    QStringList names() const;
+
+    ///@brief Returns the index
+    QVector<Entry> entries() const;
+
+    bool contains(const QString &name) const;
+
+    ///@brief Returns the layout named @p name, or an empty array if it doesn't exist or is corrupt
+    /// The data is copied out of the mapped file, so it stays valid after insert(), remove() or close().
+    QByteArray layout(const QString &name);
+
+    ///@brief Adds a layout named @p name, or replaces the existing one
+    /// Like remove(), requires the library to be open, and reopens it afterwards. Layouts already
+    /// returned by layout() are unaffected.
+    bool insert(const QString &name, const QByteArray &data, int formatVersion);
+
+    ///@brief Removes the layout named @p name. Returns false if it doesn't exist.
+    bool remove(const QString &name);
+
+    ///@brief Verifies the checksums and bounds of every layout in the library
+    bool validate();
+
+    QString errorString() const;
+
+    ///@brief Returns whether @p filename starts with the library magic
+    static bool isLibrary(const QString &filename);
+
+    ///@brief Returns the checksum used for the index and the layouts
+    static quint64 checksum(const char *data, quint64 size);
+
+private:
+    int indexOf(const QString &name) const;
+    bool entryIsValid(const Entry &entry);
+    bool write(QVector<Entry> entries, const QVector<QByteArray> &blobs);
+    bool setError(const QString &error);
+
+    const QString m_filename;
+    QFile m_file;
+    const uchar *m_data = nullptr;
+    quint64 m_size = 0;
+    bool m_isOpen = false;
+    QVector<Entry> m_entries;
+    QString m_errorString;
+    Q_DISABLE_COPY(LayoutLibrary)
+};
+
+}
+
+#endif
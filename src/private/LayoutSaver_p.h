@@ -15,6 +15,8 @@
 #include "kddockwidgets/KDDockWidgets.h"
 #include "kddockwidgets/LayoutSaver.h"
 #include "kddockwidgets/QWidgetAdapter.h"
+#include "AffinitySet_p.h"
+#include "multisplitter/Item_p.h"
 
 #include <QDebug>
 #include <QGuiApplication>
@@ -52,21 +54,6 @@ enum class InternalRestoreOption {
 Q_DECLARE_FLAGS(InternalRestoreOptions, InternalRestoreOption)
 
 
-template<typename T>
-typename T::List fromVariantList(const QVariantList &listV)
-{
-    typename T::List result;
-
-    result.reserve(listV.size());
-    for (const QVariant &v : listV) {
-        T t;
-        t.fromVariantMap(v.toMap());
-        result.push_back(t);
-    }
-
-    return result;
-}
-
 template<typename T>
 QVariantList toVariantList(const typename T::List &list)
 {
@@ -83,7 +70,9 @@ struct LayoutSaver::Placeholder
     typedef QVector<LayoutSaver::Placeholder> List;
 
     QVariantMap toVariantMap() const;
-    void fromVariantMap(const QVariantMap &map);
+    void fromJsonStream(Layouting::JsonStreamReader &);
+
+    bool operator==(const Placeholder &) const;
 
     bool isFloatingWindow;
     int indexOfFloatingWindow;
@@ -119,8 +108,8 @@ struct LayoutSaver::ScalingInfo
 struct LayoutSaver::Position
 {
     QRect lastFloatingGeometry;
-    int tabIndex;
-    bool wasFloating;
+    int tabIndex = 0;
+    bool wasFloating = false;
     LayoutSaver::Placeholder::List placeholders;
     QHash<SideBarLocation, QRect> lastOverlayedGeometries;
 
@@ -128,7 +117,9 @@ struct LayoutSaver::Position
     void scaleSizes(const ScalingInfo &scalingInfo);
 
     QVariantMap toVariantMap() const;
-    void fromVariantMap(const QVariantMap &map);
+    void fromJsonStream(Layouting::JsonStreamReader &);
+
+    bool operator==(const Position &) const;
 };
 
 struct DOCKS_EXPORT LayoutSaver::DockWidget
@@ -159,7 +150,8 @@ struct DOCKS_EXPORT LayoutSaver::DockWidget
     bool skipsRestore() const;
 
     QVariantMap toVariantMap() const;
-    void fromVariantMap(const QVariantMap &map);
+    ///@brief Reads a dock widget and returns its shared instance, see dockWidgetForName()
+    static Ptr fromJsonStream(Layouting::JsonStreamReader &);
 
     QString uniqueName;
     QStringList affinities;
@@ -203,7 +195,10 @@ struct LayoutSaver::Frame
     LayoutSaver::DockWidget::Ptr singleDockWidget() const;
 
     QVariantMap toVariantMap() const;
-    void fromVariantMap(const QVariantMap &map);
+    void fromJsonStream(Layouting::JsonStreamReader &);
+
+    ///@brief Compares the serialized state. Dock widgets are compared by name.
+    bool operator==(const Frame &) const;
 
     bool isNull = true;
     QString objectName;
@@ -228,9 +223,11 @@ struct LayoutSaver::MultiSplitter
     bool skipsRestore() const;
 
     QVariantMap toVariantMap() const;
-    void fromVariantMap(const QVariantMap &map);
+    void fromJsonStream(Layouting::JsonStreamReader &);
+
+    bool operator==(const MultiSplitter &) const;
 
-    QVariantMap layout;
+    Layouting::ItemRecord layout;
     QHash<QString, LayoutSaver::Frame> frames;
 };
 
@@ -248,7 +245,10 @@ struct LayoutSaver::FloatingWindow
     void scaleSizes(const ScalingInfo &);
 
     QVariantMap toVariantMap() const;
-    void fromVariantMap(const QVariantMap &map);
+    void fromJsonStream(Layouting::JsonStreamReader &);
+
+    ///@brief Compares the serialized state, floatingWindowInstance isn't compared
+    bool operator==(const FloatingWindow &) const;
 
     LayoutSaver::MultiSplitter multiSplitterLayout;
     QStringList affinities;
@@ -275,7 +275,10 @@ public:
     void scaleSizes();
 
     QVariantMap toVariantMap() const;
-    void fromVariantMap(const QVariantMap &map);
+    void fromJsonStream(Layouting::JsonStreamReader &);
+
+    ///@brief Compares the serialized state, scalingInfo isn't compared
+    bool operator==(const MainWindow &) const;
 
     QHash<SideBarLocation, QStringList> dockWidgetsPerSideBar;
     KDDockWidgets::MainWindowOptions options;
@@ -293,13 +296,22 @@ public:
 };
 
 ///@brief we serialize some info about screens, so eventually we can make restore smarter when switching screens
-/// Not used currently, but nice to have in the json already
+/// Used to detect that a layout is restored in the same environment it was saved in
 struct LayoutSaver::ScreenInfo
 {
     typedef QVector<LayoutSaver::ScreenInfo> List;
 
     QVariantMap toVariantMap() const;
-    void fromVariantMap(const QVariantMap &map);
+    void fromJsonStream(Layouting::JsonStreamReader &);
+
+    ///@brief Returns the info for the screens we currently have
+    static List current();
+
+    bool operator==(const ScreenInfo &other) const
+    {
+        return index == other.index && geometry == other.geometry && name == other.name
+            && qFuzzyCompare(devicePixelRatio, other.devicePixelRatio);
+    }
 
     int index;
     QRect geometry;
@@ -311,20 +323,9 @@ struct LayoutSaver::Layout
 {
 public:
     Layout()
+        : screenInfo(ScreenInfo::current())
     {
         s_currentLayoutBeingRestored = this;
-
-        const QList<QScreen *> screens = qApp->screens();
-        const int numScreens = screens.size();
-        screenInfo.reserve(numScreens);
-        for (int i = 0; i < numScreens; ++i) {
-            ScreenInfo info;
-            info.index = i;
-            info.geometry = screens[i]->geometry();
-            info.name = screens[i]->name();
-            info.devicePixelRatio = screens[i]->devicePixelRatio();
-            screenInfo.push_back(info);
-        }
     }
 
     ~Layout()
@@ -337,11 +338,14 @@ public:
     QByteArray toJson() const;
     bool fromJson(const QByteArray &jsonData);
     QVariantMap toVariantMap() const;
-    void fromVariantMap(const QVariantMap &map);
 
     /// Iterates through the layout and patches all absolute sizes. See RestoreOption_RelativeToMainWindow.
     void scaleSizes(KDDockWidgets::InternalRestoreOptions);
 
+    /// Returns true if the screens and the main window geometries are the same as when the layout
+    /// was saved, typically when restoring at application startup. There's nothing to scale then.
+    bool environmentUnchanged() const;
+
     static LayoutSaver::Layout *s_currentLayoutBeingRestored;
 
     LayoutSaver::MainWindow mainWindowForIndex(int index) const;
@@ -373,11 +377,27 @@ public:
         Q_DISABLE_COPY(RAIIIsRestoring)
     };
 
+    ///@brief The windows and dock widgets a restore can leave alone, as they're already in the
+    /// state being restored. Used by LayoutHistory, which restores only what changed.
+    struct Unchanged
+    {
+        QStringList mainWindows; ///< unique names
+        QHash<int, KDDockWidgets::FloatingWindow *> floatingWindows; ///< index in the layout -> existing window
+        QStringList dockWidgets; ///< unique names
+    };
+
     explicit Private(RestoreOptions options);
 
+    ///@brief Fills @p layout with the current state of the windows and dock widgets
+    void serialize(LayoutSaver::Layout &layout) const;
+
+    ///@brief Restores a layout. Whatever is in @p unchanged isn't touched.
+    bool restore(LayoutSaver::Layout &layout, const Unchanged &unchanged = {});
+
     bool matchesAffinity(const QStringList &affinities) const;
+    bool matchesAffinity(const AffinitySet &affinities) const;
     void floatWidgetsWhichSkipRestore(const QStringList &mainWindowNames);
-    void floatUnknownWidgets(const LayoutSaver::Layout &layout);
+    void floatUnknownWidgets(const LayoutSaver::Layout &layout, const QStringList &mainWindowNames);
 
     template<typename T>
     void deserializeWindowGeometry(const T &saved, QWidgetOrQuick *topLevel);
@@ -388,6 +408,7 @@ public:
     DockRegistry *const m_dockRegistry;
     InternalRestoreOptions m_restoreOptions = {};
     QStringList m_affinityNames;
+    AffinitySet m_affinitySet; ///< m_affinityNames, interned
 
     static bool s_restoreInProgress;
 };
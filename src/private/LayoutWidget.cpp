@@ -21,8 +21,21 @@
 
 #include "multisplitter/Item_p.h"
 
+#include <QGuiApplication>
+#include <QScreen>
+#include <QScopedValueRollback>
+#include <QTimer>
+
 using namespace KDDockWidgets;
 
+/// @brief Returns the duration of a display frame, in ms
+static int frameInterval()
+{
+    const QScreen *screen = QGuiApplication::primaryScreen();
+    const qreal refreshRate = screen ? screen->refreshRate() : 0;
+    return refreshRate > 0 ? qMax(1, qRound(1000 / refreshRate)) : 16;
+}
+
 
 LayoutWidget::LayoutWidget(QWidgetOrQuick *parent)
     : LayoutGuestWidget(parent)
@@ -148,6 +161,8 @@ void LayoutWidget::unrefOldPlaceholders(const Frame::List &framesBeingAdded) con
 
 void LayoutWidget::setLayoutSize(QSize size)
 {
+    flushCoalescedResize();
+
     if (size != this->size()) {
         m_rootItem->setSize_recursive(size);
         if (!m_inResizeEvent && !LayoutSaver::restoreInProgress())
@@ -190,6 +205,17 @@ Layouting::Item *LayoutWidget::itemForFrame(const Frame *frame) const
     if (!frame)
         return nullptr;
 
+    // Fast path: the frame usually knows its item, we just need to check it's in this layout
+    if (Layouting::Item *item = frame->layoutItem()) {
+        if (item->guestWidget() == frame) {
+            Layouting::Item *root = item;
+            while (root->parentContainer())
+                root = root->parentContainer();
+            if (root == m_rootItem)
+                return item;
+        }
+    }
+
     return m_rootItem->itemForWidget(frame);
 }
 
@@ -257,7 +283,7 @@ bool LayoutWidget::deserialize(const LayoutSaver::MultiSplitter &l)
         frames.insert(frame.id, f);
     }
 
-    m_rootItem->fillFromVariantMap(l.layout, frames);
+    m_rootItem->fillFromRecord(l.layout, frames);
 
     updateSizeConstraints();
 
@@ -281,16 +307,83 @@ bool LayoutWidget::onResize(QSize newSize)
 
     if (!LayoutSaver::restoreInProgress()) {
         // don't resize anything while we're restoring the layout
-        setLayoutSize(newSize);
+        if (Config::self().coalescedLayoutResize())
+            scheduleCoalescedResize(newSize);
+        else
+            setLayoutSize(newSize);
     }
 
     return false; // So QWidget::resizeEvent is called
 }
 
+void LayoutWidget::scheduleCoalescedResize(QSize size)
+{
+    if (!m_coalescedResizeTimer) {
+        m_coalescedResizeTimer = new QTimer(this);
+        m_coalescedResizeTimer->setSingleShot(true);
+        connect(m_coalescedResizeTimer, &QTimer::timeout, this, &LayoutWidget::applyCoalescedResize);
+
+        m_resizeSettleTimer = new QTimer(this);
+        m_resizeSettleTimer->setSingleShot(true);
+        connect(m_resizeSettleTimer, &QTimer::timeout, this, &LayoutWidget::settleCoalescedResize);
+    }
+
+    m_coalescedResizeSize = size;
+    m_resizeSettleTimer->stop();
+
+    // Not restarted if already running, so a continuous resize still relayouts once per frame
+    if (!m_coalescedResizeTimer->isActive())
+        m_coalescedResizeTimer->start(frameInterval());
+}
+
+void LayoutWidget::applyCoalescedResize()
+{
+    const QSize size = m_coalescedResizeSize;
+    m_coalescedResizeSize = QSize();
+    if (!size.isValid() || size == this->size() || LayoutSaver::restoreInProgress())
+        return;
+
+    const int tolerance = Config::self().coalescedLayoutResizeTolerance();
+    {
+        QScopedValueRollback<int> toleranceGuard(Layouting::Item::guestGeometryTolerance, tolerance);
+        m_rootItem->setSize_recursive(size);
+    }
+
+    if (tolerance > 0) {
+        // Some guests might have been left behind, fix them once the user stops resizing
+        m_hasSkippedGuestGeometries = true;
+        m_resizeSettleTimer->start(5 * frameInterval());
+    }
+}
+
+void LayoutWidget::settleCoalescedResize()
+{
+    if (m_hasSkippedGuestGeometries) {
+        m_hasSkippedGuestGeometries = false;
+        m_rootItem->applySkippedGuestGeometries();
+    }
+}
+
+void LayoutWidget::flushCoalescedResize()
+{
+    if (!m_coalescedResizeTimer)
+        return;
+
+    m_coalescedResizeTimer->stop();
+    m_resizeSettleTimer->stop();
+
+    const QSize size = m_coalescedResizeSize;
+    m_coalescedResizeSize = QSize();
+    if (size.isValid() && size != this->size() && !LayoutSaver::restoreInProgress())
+        m_rootItem->setSize_recursive(size);
+
+    settleCoalescedResize();
+}
+
 LayoutSaver::MultiSplitter LayoutWidget::serialize() const
 {
     LayoutSaver::MultiSplitter l;
-    l.layout = m_rootItem->toVariantMap();
+    l.layout = m_rootItem->toRecord();
     const Layouting::Item::List items = m_rootItem->items_recursive();
     l.frames.reserve(items.size());
     for (Layouting::Item *item : items) {
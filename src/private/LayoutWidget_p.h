@@ -31,6 +31,10 @@
 
 #include <QList>
 
+QT_BEGIN_NAMESPACE
+class QTimer;
+QT_END_NAMESPACE
+
 namespace Layouting {
 class Item;
 class ItemContainer;
@@ -123,6 +127,10 @@ public:
      */
     void setLayoutSize(QSize);
 
+    /// @brief Applies a resize postponed by Config::setCoalescedLayoutResize() right away, along with
+    /// any guest geometries that were skipped. Called by setLayoutSize().
+    void flushCoalescedResize();
+
 
     /// @brief restores the dockwidget @p dw to its previous position
     void restorePlaceholder(DockWidgetBase *dw, Layouting::Item *, int tabIndex);
@@ -224,8 +232,16 @@ Q_SIGNALS:
     void visibleWidgetCountChanged(int count);
 
 private:
+    void scheduleCoalescedResize(QSize);
+    void applyCoalescedResize();
+    void settleCoalescedResize();
+
     bool m_inResizeEvent = false;
+    bool m_hasSkippedGuestGeometries = false;
     Layouting::ItemContainer *m_rootItem = nullptr;
+    QTimer *m_coalescedResizeTimer = nullptr;
+    QTimer *m_resizeSettleTimer = nullptr;
+    QSize m_coalescedResizeSize;
 };
 
 }
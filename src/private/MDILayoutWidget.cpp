@@ -15,6 +15,10 @@
 #include "Config.h"
 #include "FrameworkWidgetFactory.h"
 
+#include <QtMath>
+
+#include <algorithm>
+
 using namespace KDDockWidgets;
 
 MDILayoutWidget::MDILayoutWidget(QWidgetOrQuick *parent)
@@ -114,3 +118,149 @@ void MDILayoutWidget::resizeDockWidget(Frame *frame, QSize size)
 
     item->setSize(size.expandedTo(frame->minimumSize()));
 }
+
+void MDILayoutWidget::raiseDockWidget(Frame *frame)
+{
+    if (!frame)
+        return;
+
+    if (Layouting::Item *item = itemForFrame(frame))
+        m_rootItem->raiseItem(item);
+
+    frame->raise();
+}
+
+QList<Frame *> MDILayoutWidget::framesInZOrder() const
+{
+    QList<Frame *> frames;
+    const Layouting::Item::List items = m_rootItem->itemsInZOrder();
+    for (Layouting::Item *item : items) {
+        if (auto frame = qobject_cast<Frame *>(item->guestAsQObject()))
+            frames << frame;
+    }
+
+    return frames;
+}
+
+Frame *MDILayoutWidget::frameAt(QPoint localPos, int margin) const
+{
+    if (Layouting::Item *item = m_rootItem->itemAt(localPos, margin))
+        return qobject_cast<Frame *>(item->guestAsQObject());
+
+    return nullptr;
+}
+
+void MDILayoutWidget::setDockWidgetGeometries(const QVector<FrameGeometry> &geometries)
+{
+#ifdef KDDOCKWIDGETS_QTWIDGETS
+    // A single repaint for the whole batch, instead of one per frame. QtQuick doesn't need this,
+    // moving items only marks them dirty and the next frame renders them all.
+    const bool updatesWereEnabled = updatesEnabled();
+    setUpdatesEnabled(false);
+#endif
+
+    QVector<FrameGeometry> toRaise;
+    {
+        Layouting::ItemContainer::GeometryTransaction transaction(m_rootItem);
+        for (const FrameGeometry &g : geometries) {
+            Layouting::Item *item = itemForFrame(g.frame);
+            if (!item) {
+                qWarning() << Q_FUNC_INFO << "Frame not found in the layout" << g.frame;
+                continue;
+            }
+
+            QRect geometry = g.geometry;
+            geometry.setSize(geometry.size().expandedTo(g.frame->minimumSize()));
+            item->setGeometry(geometry);
+
+            if (g.z >= 0)
+                toRaise.push_back(g);
+        }
+    }
+
+    // Raise the lowest first, so the highest z ends up on top
+    std::stable_sort(toRaise.begin(), toRaise.end(), [](const FrameGeometry &a, const FrameGeometry &b) {
+        return a.z < b.z;
+    });
+    for (const FrameGeometry &g : qAsConst(toRaise))
+        raiseDockWidget(g.frame);
+
+#ifdef KDDOCKWIDGETS_QTWIDGETS
+    setUpdatesEnabled(updatesWereEnabled);
+#endif
+}
+
+QList<Frame *> MDILayoutWidget::visibleFramesInZOrder() const
+{
+    QList<Frame *> frames = framesInZOrder();
+    frames.erase(std::remove_if(frames.begin(), frames.end(), [](Frame *frame) {
+                     return !frame->QWidgetAdapter::isVisible();
+                 }),
+                 frames.end());
+    return frames;
+}
+
+void MDILayoutWidget::tileDockWidgets()
+{
+    const QList<Frame *> frames = visibleFramesInZOrder();
+    const int count = int(frames.size());
+    if (count == 0)
+        return;
+
+    const int columns = qCeil(qSqrt(qreal(count)));
+    const int rows = (count + columns - 1) / columns;
+    const QSize area = size();
+
+    QVector<FrameGeometry> geometries;
+    geometries.reserve(count);
+    for (int i = 0; i < count; ++i) {
+        const int row = i / columns;
+        const int column = i % columns;
+
+        // The last row might have less frames, they share its whole width
+        const int columnsInRow = row == rows - 1 ? count - row * columns : columns;
+        const int left = column * area.width() / columnsInRow;
+        const int right = (column + 1) * area.width() / columnsInRow;
+        const int top = row * area.height() / rows;
+        const int bottom = (row + 1) * area.height() / rows;
+        geometries.push_back({ frames.at(i), QRect(QPoint(left, top), QPoint(right - 1, bottom - 1)) });
+    }
+
+    setDockWidgetGeometries(geometries);
+}
+
+void MDILayoutWidget::cascadeDockWidgets()
+{
+    const QList<Frame *> frames = visibleFramesInZOrder();
+    const int count = int(frames.size());
+    if (count == 0)
+        return;
+
+    const int step = 30;
+    const QSize area = size();
+    const QSize frameSize = area * 2 / 3;
+
+    // How many fit diagonally before wrapping back to the top-left
+    const int maxSteps = qMax(1, qMin(area.width() - frameSize.width(), area.height() - frameSize.height()) / step + 1);
+
+    // Bottom-most frame first, so stacking is preserved and each title bar stays visible
+    QVector<FrameGeometry> geometries;
+    geometries.reserve(count);
+    for (int i = 0; i < count; ++i) {
+        const int offset = (i % maxSteps) * step;
+        geometries.push_back({ frames.at(i), QRect(QPoint(offset, offset), frameSize) });
+    }
+
+    setDockWidgetGeometries(geometries);
+}
+
+Frame *MDILayoutWidget::frameForDockWidget(DockWidgetBase *dw)
+{
+    if (!dw)
+        return nullptr;
+
+    if (DockWidgetBase *wrapperDW = dw->d->mdiDockWidgetWrapper())
+        return wrapperDW->d->frame();
+
+    return dw->d->frame();
+}
@@ -55,7 +55,48 @@ public:
     /// @brief sets the size and position of the dock widget @p f
     void setDockWidgetGeometry(Frame *f, QRect);
 
+    /// @brief Raises the dock widget @p f above the others in this MDI area
+    void raiseDockWidget(Frame *f);
+
+    /// @brief A frame's requested geometry and stacking, for setDockWidgetGeometries()
+    struct FrameGeometry
+    {
+        FrameGeometry() = default;
+        FrameGeometry(Frame *f, QRect geo, int zOrder = -1)
+            : frame(f)
+            , geometry(geo)
+            , z(zOrder)
+        {
+        }
+
+        Frame *frame = nullptr;
+        QRect geometry;
+        int z = -1; ///< Frames with z >= 0 are raised in increasing z order. -1 keeps the stacking.
+    };
+
+    /// @brief Applies the geometries of many frames in one pass, repainting only once at the end
+    /// With QtQuick there's no repaint to suppress, the scene graph renders all moves in one frame.
+    void setDockWidgetGeometries(const QVector<FrameGeometry> &);
+
+    /// @brief Arranges the visible frames in a grid filling this MDI area
+    void tileDockWidgets();
+
+    /// @brief Arranges the visible frames diagonally, overlapping, in their current stacking order
+    void cascadeDockWidgets();
+
+    /// @brief Returns the MDI frame of dock widget @p dw, which is the frame of its wrapper when
+    /// using DockWidget::Option_MDINestable
+    static Frame *frameForDockWidget(DockWidgetBase *dw);
+
+    /// @brief Returns the frames in this MDI area, from bottom to top
+    QList<Frame *> framesInZOrder() const;
+
+    /// @brief Returns the topmost frame at @p localPos, or nullptr if there's none
+    /// Frames are grown by @p margin on each side, so their resize margins can be hit-tested too.
+    Frame *frameAt(QPoint localPos, int margin = 0) const;
+
 private:
+    QList<Frame *> visibleFramesInZOrder() const;
     Layouting::ItemFreeContainer *const m_rootItem;
 };
 
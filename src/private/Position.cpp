@@ -35,9 +35,13 @@ void Position::addPlaceholderItem(Layouting::Item *placeholder)
 {
     Q_ASSERT(placeholder);
 
-    // 1. Already exists, nothing to do
-    if (containsPlaceholder(placeholder))
-        return;
+    // 1. Already exists, nothing to do besides noting it's occupied again
+    for (const auto &itemRef : m_placeholders) {
+        if (itemRef->item == placeholder) {
+            itemRef->lastOccupied.restart();
+            return;
+        }
+    }
 
     if (DockRegistry::self()->itemIsInMainWindow(placeholder)) {
         // 2. If we have a MainWindow placeholder we don't need nothing else
@@ -120,6 +124,51 @@ void Position::removePlaceholder(Layouting::Item *placeholder)
                          m_placeholders.end());
 }
 
+int Position::compactPlaceholders(int maxCount, int maxAgeMSecs)
+{
+    if (m_clearing)
+        return 0;
+
+    const auto originalSize = m_placeholders.size();
+
+    // Items which are still occupied don't age
+    for (const auto &itemRef : m_placeholders) {
+        if (!itemRef->item->isPlaceholder())
+            itemRef->lastOccupied.restart();
+    }
+
+    if (maxAgeMSecs > 0) {
+        m_placeholders.erase(std::remove_if(m_placeholders.begin(), m_placeholders.end(), [maxAgeMSecs](const std::unique_ptr<ItemRef> &itemref) {
+                                 return itemref->item->isPlaceholder() && itemref->lastOccupied.hasExpired(maxAgeMSecs);
+                             }),
+                             m_placeholders.end());
+    }
+
+    const auto excess = int(m_placeholders.size()) - maxCount;
+    if (maxCount > 0 && excess > 0) {
+        // Drop the placeholders which were least recently occupied, not the ones inserted first
+        std::vector<ItemRef *> candidates;
+        for (const auto &itemRef : m_placeholders) {
+            if (itemRef->item->isPlaceholder())
+                candidates.push_back(itemRef.get());
+        }
+
+        std::stable_sort(candidates.begin(), candidates.end(), [](ItemRef *a, ItemRef *b) {
+            return a->lastOccupied < b->lastOccupied;
+        });
+
+        if (int(candidates.size()) > excess)
+            candidates.resize(size_t(excess));
+
+        m_placeholders.erase(std::remove_if(m_placeholders.begin(), m_placeholders.end(), [&candidates](const std::unique_ptr<ItemRef> &itemref) {
+                                 return std::find(candidates.cbegin(), candidates.cend(), itemref.get()) != candidates.cend();
+                             }),
+                             m_placeholders.end());
+    }
+
+    return int(originalSize - m_placeholders.size());
+}
+
 void Position::deserialize(const LayoutSaver::Position &lp)
 {
     m_lastFloatingGeometry = lp.lastFloatingGeometry;
@@ -206,6 +255,7 @@ ItemRef::ItemRef(const QMetaObject::Connection &conn, Layouting::Item *it)
     , connection(conn)
 {
     item->ref();
+    lastOccupied.start();
 }
 
 ItemRef::~ItemRef()
@@ -24,6 +24,7 @@
 #include "LayoutSaver.h"
 #include "QWidgetAdapter.h"
 
+#include <QElapsedTimer>
 #include <QHash>
 #include <QPointer>
 #include <QScopedValueRollback>
@@ -50,6 +51,9 @@ struct ItemRef
     const QPointer<Layouting::Item> guard;
     const QMetaObject::Connection connection;
 
+    ///@brief Time since the dock widget was last seen in this item. Used for pruning stale placeholders.
+    QElapsedTimer lastOccupied;
+
 private:
     Q_DISABLE_COPY(ItemRef)
 };
@@ -123,6 +127,12 @@ public:
     ///@brief removes the Item @p placeholder
     void removePlaceholder(Layouting::Item *placeholder);
 
+    ///@brief Removes placeholders which are unoccupied for more than @p maxAgeMSecs, and then
+    /// the least recently occupied ones until there's at most @p maxCount. 0 means no limit.
+    /// Occupied items (where the dock widget currently is) are never removed.
+    /// @return the number of placeholders removed
+    int compactPlaceholders(int maxCount, int maxAgeMSecs);
+
     void saveTabIndex(int tabIndex, bool isFloating)
     {
         m_tabIndex = tabIndex;
@@ -18,6 +18,7 @@
 #include "Utils_p.h"
 #include "DockRegistry_p.h"
 #include "MDILayoutWidget_p.h"
+#include "multisplitter/PerfCounters_p.h"
 
 #include <QEvent>
 #include <QMouseEvent>
@@ -81,6 +82,8 @@ int WidgetResizeHandler::widgetResizeHandlerMargin()
 
 bool WidgetResizeHandler::eventFilter(QObject *o, QEvent *e)
 {
+    Layouting::PerfCounters::increment(Layouting::PerfCounters::Counter_EventFilterInvocations);
+
     if (s_disableAllHandlers)
         return false;
 
@@ -122,6 +125,16 @@ bool WidgetResizeHandler::eventFilter(QObject *o, QEvent *e)
         // is near "Frame 2"'s margins, and would show resize cursor.
         // We only want to continue if the cursor is near the margins of our own frame (mTarget)
 
+        // Every MDI frame gets every mouse event, so first rule out most of them with the layout's
+        // spatial index: only the topmost frame near the cursor can be resized
+        if (!m_resizingInProgress) {
+            if (MDILayoutWidget *layout = static_cast<Frame *>(mTarget)->mdiLayoutWidget()) {
+                const QPoint localPos = layout->mapFromGlobal(Qt5Qt6Compat::eventGlobalPos(me));
+                if (layout->frameAt(localPos, widgetResizeHandlerMargin()) != mTarget)
+                    return false;
+            }
+        }
+
         auto frame = firstParentOfType<Frame>(widget);
         if (frame && frame->isMDIWrapper()) {
             // We don't care about the inner Option_MDINestable helper frame
@@ -154,7 +167,7 @@ bool WidgetResizeHandler::eventFilter(QObject *o, QEvent *e)
 
         m_resizingInProgress = true;
         if (isMDI())
-            Q_EMIT DockRegistry::self()->frameInMDIResizeChanged();
+            DockRegistry::self()->setFrameInMDIResize(static_cast<Frame *>(mTarget), true);
         mNewPosition = Qt5Qt6Compat::eventGlobalPos(mouseEvent);
         mCursorPos = cursorPos;
 
@@ -163,8 +176,8 @@ bool WidgetResizeHandler::eventFilter(QObject *o, QEvent *e)
     case QEvent::MouseButtonRelease: {
         m_resizingInProgress = false;
         if (isMDI()) {
-            Q_EMIT DockRegistry::self()->frameInMDIResizeChanged();
             auto frame = static_cast<Frame *>(mTarget);
+            DockRegistry::self()->setFrameInMDIResize(frame, false);
             // Usually in KDDW all geometry changes are done in the layout items, which propagate to the widgets
             // When resizing a MDI however, we're resizing the widget directly. So update the corresponding layout
             // item when we're finished.
@@ -11,6 +11,7 @@
 
 #include "WindowBeingDragged_p.h"
 #include "DragController_p.h"
+#include "DockWidgetBase_p.h"
 #include "Frame_p.h"
 #include "LayoutWidget_p.h"
 #include "Logging_p.h"
@@ -129,6 +130,12 @@ QStringList WindowBeingDragged::affinities() const
                             : QStringList();
 }
 
+AffinitySet WindowBeingDragged::affinitySet() const
+{
+    return m_floatingWindow ? m_floatingWindow->affinitySet()
+                            : AffinitySet();
+}
+
 QSize WindowBeingDragged::size() const
 {
     if (m_floatingWindow)
@@ -250,6 +257,18 @@ QStringList WindowBeingDraggedWayland::affinities() const
     return {};
 }
 
+AffinitySet WindowBeingDraggedWayland::affinitySet() const
+{
+    if (m_floatingWindow)
+        return WindowBeingDragged::affinitySet();
+    else if (m_frame)
+        return m_frame->affinitySet();
+    else if (m_dockWidget)
+        return m_dockWidget->dptr()->affinitySet;
+
+    return {};
+}
+
 QVector<DockWidgetBase *> WindowBeingDraggedWayland::dockWidgets() const
 {
     if (m_floatingWindow)
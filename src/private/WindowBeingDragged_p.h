@@ -55,6 +55,9 @@ public:
     ///@brief returns the affinities of the window being dragged
     virtual QStringList affinities() const;
 
+    ///@brief Returns affinities() interned, for fast matching
+    virtual AffinitySet affinitySet() const;
+
     ///@brief size of the window being dragged contents
     virtual QSize size() const;
 
@@ -95,6 +98,7 @@ public:
     QSize maxSize() const override;
     QPixmap pixmap() const override;
     QStringList affinities() const override;
+    AffinitySet affinitySet() const override;
     QVector<DockWidgetBase *> dockWidgets() const override;
 
     // These two are set for Wayland only, where we can't make the floating window immediately (no way to position it)
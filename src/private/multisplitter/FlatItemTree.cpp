@@ -0,0 +1,212 @@
+/*
+  This file is part of KDDockWidgets.
+
+  SPDX-FileCopyrightText: 2020-2022 Klarälvdalens Datakonsult AB, a KDAB Group company <info@kdab.com>
+  Author: Sérgio Martins <sergio.martins@kdab.com>
+
+  SPDX-License-Identifier: GPL-2.0-only OR GPL-3.0-only
+
+  Contact KDAB at <info@kdab.com> for commercial licensing options.
+*/
+
+#include "FlatItemTree_p.h"
+
+using namespace Layouting;
+
+void FlatItemTree::build(const ItemContainer *root)
+{
+    // clear() keeps the capacity, so rebuilding a tree of the same size doesn't allocate
+    m_items.clear();
+    m_parents.clear();
+    m_subtreeEnds.clear();
+    m_flags.clear();
+    m_geometries.clear();
+    m_minSizes.clear();
+    m_maxSizeHints.clear();
+    m_percentages.clear();
+    m_indexes.clear();
+
+    m_layoutGeneration = Item::layoutGeneration();
+    m_constraintsGeneration = Item::constraintsGeneration();
+    m_separatorThickness = Item::separatorThickness;
+    m_hardcodedMaximumSize = Item::hardcodedMaximumSize;
+
+    if (!root)
+        return;
+
+    append(root, /*parent=*/-1, QPoint(0, 0));
+
+    // Children come after their parent, so walking backwards resolves them first
+    for (int i = size() - 1; i >= 0; --i) {
+        if (m_flags.at(i) & Flag_IsContainer)
+            computeSizeConstraints(i);
+    }
+}
+
+bool FlatItemTree::isUpToDate() const
+{
+    return constraintsAreUpToDate() && m_layoutGeneration == Item::layoutGeneration();
+}
+
+bool FlatItemTree::constraintsAreUpToDate() const
+{
+    return !m_items.isEmpty() && m_constraintsGeneration == Item::constraintsGeneration()
+        && m_separatorThickness == Item::separatorThickness && m_hardcodedMaximumSize == Item::hardcodedMaximumSize;
+}
+
+Item::List FlatItemTree::leaves(int index) const
+{
+    Item::List result;
+    const int end = subtreeEnd(index);
+    for (int i = index + 1; i < end; ++i) {
+        if (!(m_flags.at(i) & Flag_IsContainer))
+            result.push_back(m_items.at(i));
+    }
+
+    return result;
+}
+
+void FlatItemTree::append(const Item *item, int parent, QPoint rootPos)
+{
+    const int index = size();
+    m_items.push_back(const_cast<Item *>(item));
+    m_parents.push_back(parent);
+    m_subtreeEnds.push_back(index + 1);
+    m_geometries.push_back(QRect(rootPos, item->size()));
+    m_percentages.push_back(item->m_sizingInfo.percentageWithinParent);
+    m_indexes.insert(item, index);
+
+    quint8 flags = item->isBeingInserted() ? Flag_IsBeingInserted : Flag_None;
+    if (item->isContainer()) {
+        flags |= Flag_IsContainer;
+        if (auto box = qobject_cast<const ItemBoxContainer *>(item)) {
+            if (box->orientation() == Qt::Vertical)
+                flags |= Flag_IsVertical;
+        }
+
+        // Containers are resolved by computeSizeConstraints(), once their children are known
+        m_minSizes.push_back(QSize());
+        m_maxSizeHints.push_back(QSize());
+    } else {
+        if (item->isVisible())
+            flags |= Flag_IsVisible;
+        if (item->isVisible(/*excludeBeingInserted=*/true))
+            flags |= Flag_IsVisibleExcludingBeingInserted;
+
+        m_minSizes.push_back(item->minSize());
+        m_maxSizeHints.push_back(item->maxSizeHint());
+    }
+    m_flags.push_back(flags);
+
+    if (item->isContainer()) {
+        const Item::List children = static_cast<const ItemContainer *>(item)->childItems();
+        for (const Item *child : children)
+            append(child, index, rootPos + child->pos());
+
+        m_subtreeEnds[index] = size();
+    }
+}
+
+void FlatItemTree::computeSizeConstraints(int index)
+{
+    const Item *item = m_items.at(index);
+    if (!qobject_cast<const ItemBoxContainer *>(item)) {
+        // Not something we know the rules for, ask it
+        if (item->isVisible())
+            m_flags[index] |= Flag_IsVisible;
+        if (item->isVisible(/*excludeBeingInserted=*/true))
+            m_flags[index] |= Flag_IsVisibleExcludingBeingInserted;
+        m_minSizes[index] = item->minSize();
+        m_maxSizeHints[index] = item->maxSizeHint();
+        return;
+    }
+
+    // The rules below mirror ItemBoxContainer::minSize() and ItemBoxContainer::maxSizeHint()
+    const bool isVertical = m_flags.at(index) & Flag_IsVertical;
+    const int end = m_subtreeEnds.at(index);
+    const bool hasChildren = index + 1 < end;
+
+    bool isVisible = false;
+    bool isVisibleExcludingBeingInserted = false;
+
+    int minW = 0;
+    int minH = 0;
+    int numVisible = 0;
+
+    int maxW = isVertical ? m_hardcodedMaximumSize.width() : 0;
+    int maxH = isVertical ? 0 : m_hardcodedMaximumSize.height();
+    int visibleMinW = 0; // The min size of only the visible children, which is what the max size is bounded by
+    int visibleMinH = 0;
+    int numVisibleNotBeingInserted = 0;
+
+    for (int child = index + 1; child < end; child = m_subtreeEnds.at(child)) {
+        const quint8 childFlags = m_flags.at(child);
+        const bool childIsVisible = childFlags & Flag_IsVisible;
+        const bool childIsBeingInserted = childFlags & Flag_IsBeingInserted;
+        isVisible = isVisible || childIsVisible;
+        isVisibleExcludingBeingInserted = isVisibleExcludingBeingInserted || (childFlags & Flag_IsVisibleExcludingBeingInserted);
+
+        if (!(childIsVisible || childIsBeingInserted))
+            continue;
+
+        const QSize childMinSize = m_minSizes.at(child);
+        numVisible++;
+        if (isVertical) {
+            minW = qMax(minW, childMinSize.width());
+            minH += childMinSize.height();
+        } else {
+            minH = qMax(minH, childMinSize.height());
+            minW += childMinSize.width();
+        }
+
+        if (!childIsVisible || childIsBeingInserted)
+            continue;
+
+        const QSize childMaxSize = m_maxSizeHints.at(child);
+        numVisibleNotBeingInserted++;
+        if (isVertical) {
+            maxW = qMin(maxW, childMaxSize.width());
+            maxH = qMin(maxH + childMaxSize.height(), m_hardcodedMaximumSize.height());
+            visibleMinW = qMax(visibleMinW, childMinSize.width());
+            visibleMinH += childMinSize.height();
+        } else {
+            maxH = qMin(maxH, childMaxSize.height());
+            maxW = qMin(maxW + childMaxSize.width(), m_hardcodedMaximumSize.width());
+            visibleMinH = qMax(visibleMinH, childMinSize.height());
+            visibleMinW += childMinSize.width();
+        }
+    }
+
+    if (hasChildren) {
+        const int separatorWaste = qMax(0, (numVisible - 1) * m_separatorThickness);
+        if (isVertical)
+            minH += separatorWaste;
+        else
+            minW += separatorWaste;
+    }
+
+    if (numVisibleNotBeingInserted > 0) {
+        const int separatorWaste = (numVisibleNotBeingInserted - 1) * m_separatorThickness;
+        if (isVertical) {
+            maxH = qMin(maxH + separatorWaste, m_hardcodedMaximumSize.height());
+            visibleMinH += separatorWaste;
+        } else {
+            maxW = qMin(maxW + separatorWaste, m_hardcodedMaximumSize.width());
+            visibleMinW += separatorWaste;
+        }
+    }
+
+    if (maxW == 0)
+        maxW = m_hardcodedMaximumSize.width();
+
+    if (maxH == 0)
+        maxH = m_hardcodedMaximumSize.height();
+
+    if (isVisible)
+        m_flags[index] |= Flag_IsVisible;
+    if (isVisibleExcludingBeingInserted)
+        m_flags[index] |= Flag_IsVisibleExcludingBeingInserted;
+
+    m_minSizes[index] = QSize(minW, minH);
+    m_maxSizeHints[index] = QSize(maxW, maxH).expandedTo(QSize(visibleMinW, visibleMinH));
+}
@@ -0,0 +1,139 @@
+/*
+  This file is part of KDDockWidgets.
+
+  SPDX-FileCopyrightText: 2020-2022 Klarälvdalens Datakonsult AB, a KDAB Group company <info@kdab.com>
+  Author: Sérgio Martins <sergio.martins@kdab.com>
+
+  SPDX-License-Identifier: GPL-2.0-only OR GPL-3.0-only
+
+  Contact KDAB at <info@kdab.com> for commercial licensing options.
+*/
+
+#pragma once
+
+#include "kddockwidgets/docks_export.h"
+#include "Item_p.h"
+
+#include <QHash>
+#include <QRect>
+#include <QSize>
+#include <QVector>
+
+namespace Layouting {
+
+/**
+ * @brief A flat, contiguous snapshot of an Item tree.
+ *
+ * Items are stored in depth-first pre-order, as a struct of arrays, so whole-tree queries walk
+ * memory linearly instead of chasing QObject pointers. A node's subtree is the index range
+ * [index, subtreeEnd(index)), its first child is at index + 1 and the next sibling of child c is at
+ * subtreeEnd(c). The Item pointers are kept as handles back into the real tree.
+ *
+ * Containers' min and max sizes are computed bottom-up in a single pass, with the same rules as
+ * ItemBoxContainer::minSize() and ItemBoxContainer::maxSizeHint().
+ *
+ * The snapshot doesn't observe the tree, use isUpToDate() to know if it can still be used, or
+ * constraintsAreUpToDate() if only the size constraints are needed.
+ */
+class DOCKS_EXPORT_FOR_UNIT_TESTS FlatItemTree
+{
+public:
+    enum Flag : quint8 {
+        Flag_None = 0,
+        Flag_IsContainer = 1,
+        Flag_IsVisible = 2, ///< Item::isVisible()
+        Flag_IsVisibleExcludingBeingInserted = 4, ///< Item::isVisible(/*excludeBeingInserted=*/true)
+        Flag_IsBeingInserted = 8,
+        Flag_IsVertical = 16 ///< Only set for vertical ItemBoxContainers
+    };
+
+    ///@brief Rebuilds the arrays from the tree rooted at @p root
+    void build(const ItemContainer *root);
+
+    ///@brief Returns whether nothing changed in any layout since build() ran
+    bool isUpToDate() const;
+
+    ///@brief Returns whether minSize(), maxSizeHint() and the flags are still valid. Unlike
+    /// isUpToDate(), geometry changes don't make them stale, only geometry() and percentageWithinParent().
+    bool constraintsAreUpToDate() const;
+
+    ///@brief Returns the number of items, including containers and the root
+    int size() const
+    {
+        return int(m_items.size());
+    }
+
+    ///@brief Returns the index of @p item, or -1 if it's not in the snapshot
+    int indexOf(const Item *item) const
+    {
+        return m_indexes.value(item, -1);
+    }
+
+    Item *item(int index) const
+    {
+        return m_items.at(index);
+    }
+
+    ///@brief Returns the index of the parent container. -1 for the root.
+    int parent(int index) const
+    {
+        return m_parents.at(index);
+    }
+
+    ///@brief Returns one past the last index of the subtree rooted at @p index
+    int subtreeEnd(int index) const
+    {
+        return m_subtreeEnds.at(index);
+    }
+
+    bool testFlag(int index, Flag flag) const
+    {
+        return m_flags.at(index) & flag;
+    }
+
+    ///@brief Returns the item's geometry in root coordinates, like Item::mapToRoot(Item::rect())
+    QRect geometry(int index) const
+    {
+        return m_geometries.at(index);
+    }
+
+    QSize minSize(int index) const
+    {
+        return m_minSizes.at(index);
+    }
+
+    QSize maxSizeHint(int index) const
+    {
+        return m_maxSizeHints.at(index);
+    }
+
+    double percentageWithinParent(int index) const
+    {
+        return m_percentages.at(index);
+    }
+
+    ///@brief Returns the non-container items under @p index, in the same order as ItemContainer::items_recursive()
+    Item::List leaves(int index) const;
+
+private:
+    void append(const Item *item, int parent, QPoint rootPos);
+    void computeSizeConstraints(int index);
+
+    QVector<Item *> m_items;
+    QVector<int> m_parents;
+    QVector<int> m_subtreeEnds;
+    QVector<quint8> m_flags;
+    QVector<QRect> m_geometries;
+    QVector<QSize> m_minSizes;
+    QVector<QSize> m_maxSizeHints;
+    QVector<double> m_percentages;
+    QHash<const Item *, int> m_indexes;
+
+    // What the snapshot depends on, besides the tree itself
+    quint64 m_layoutGeneration = 0;
+    quint64 m_constraintsGeneration = 0;
+    int m_separatorThickness = 0;
+    QSize m_hardcodedMaximumSize;
+};
+
+}
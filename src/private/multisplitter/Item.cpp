@@ -10,17 +10,22 @@
 */
 
 #include "Item_p.h"
+#include "FlatItemTree_p.h"
+#include "JsonStreamReader_p.h"
 #include "Separator_p.h"
 #include "MultiSplitterConfig.h"
 #include "Widget.h"
 #include "ItemFreeContainer_p.h"
+#include "PerfCounters_p.h"
 
 #include <QEvent>
+#include <QMetaMethod>
 #include <QDebug>
 #include <QScopedValueRollback>
 #include <QTimer>
 #include <QGuiApplication>
 #include <QScreen>
+#include <QVarLengthArray>
 #include <algorithm>
 
 #ifdef Q_CC_MSVC
@@ -37,6 +42,7 @@ using namespace Layouting;
 using namespace KDDockWidgets;
 
 int Layouting::Item::separatorThickness = 5;
+int Layouting::Item::guestGeometryTolerance = 0;
 
 // There are the defaults. They can be changed by the user via Config.h API.
 QSize Layouting::Item::hardcodedMinimumSize = QSize(80, 90);
@@ -44,6 +50,30 @@ QSize Layouting::Item::hardcodedMaximumSize = QSize(16777215, 16777215);
 
 bool Layouting::ItemBoxContainer::s_inhibitSimplify = false;
 
+/// @brief Bumped whenever an item's geometry, visibility, size constraints or parent changes, or when
+/// children are added/removed. The spatial index is rebuilt lazily when out of date.
+static quint64 s_layoutGeneration = 1;
+
+/// @brief Like s_layoutGeneration, but not bumped by geometry changes. The min and max sizes
+/// cached in the FlatItemTree of ItemBoxContainer::Private only depend on what bumps this one, so
+/// they survive a layout pass.
+static quint64 s_constraintsGeneration = 1;
+
+static void invalidateSpatialIndexes()
+{
+    ++s_layoutGeneration;
+}
+
+static void invalidateSizeConstraints()
+{
+    ++s_constraintsGeneration;
+    invalidateSpatialIndexes();
+}
+
+/// @brief Number of root containers with an ItemGeometryObserver. Lets Item::setGeometry() skip
+/// looking for the root when nobody is observing.
+static int s_numGeometryObservers = 0;
+
 inline bool locationIsVertical(Location loc)
 {
     return loc == Location_OnTop || loc == Location_OnBottom;
@@ -213,36 +243,53 @@ void Item::setGuestWidget(Widget *guest)
     updateObjectName();
 }
 
+static bool isWithinTolerance(QRect r1, QRect r2, int tolerance)
+{
+    return qAbs(r1.left() - r2.left()) < tolerance && qAbs(r1.top() - r2.top()) < tolerance
+        && qAbs(r1.right() - r2.right()) < tolerance && qAbs(r1.bottom() - r2.bottom()) < tolerance;
+}
+
 void Item::updateWidgetGeometries()
 {
     if (m_guest) {
-        m_guest->setGeometry(mapToRoot(rect()));
+        const QRect geo = mapToRoot(rect());
+        if (guestGeometryTolerance > 0 && isWithinTolerance(m_guest->geometry(), geo, guestGeometryTolerance)) {
+            m_guestGeometrySkipped = true;
+            return;
+        }
+
+        m_guestGeometrySkipped = false;
+        PerfCounters::increment(PerfCounters::Counter_WidgetGeometryApplied);
+        m_guest->setGeometry(geo);
     }
 }
 
-QVariantMap Item::toVariantMap() const
+ItemRecord Item::toRecord() const
 {
-    QVariantMap result;
-
-    result[QStringLiteral("sizingInfo")] = m_sizingInfo.toVariantMap();
-    result[QStringLiteral("isVisible")] = m_isVisible;
-    result[QStringLiteral("isContainer")] = isContainer();
-    result[QStringLiteral("objectName")] = objectName();
+    ItemRecord record;
+    // Only what SizingInfo serializes, the rest is recalculated when restoring
+    record.sizingInfo.geometry = m_sizingInfo.geometry;
+    record.sizingInfo.minSize = m_sizingInfo.minSize;
+    record.sizingInfo.maxSizeHint = m_sizingInfo.maxSizeHint;
+    record.isVisible = m_isVisible;
+    record.isContainer = isContainer();
+    record.objectName = objectName();
     if (m_guest)
-        result[QStringLiteral("guestId")] = m_guest->id(); // just for coorelation purposes when restoring
+        record.guestId = m_guest->id(); // just for coorelation purposes when restoring
+    record.isNull = false;
 
-    return result;
+    return record;
 }
 
-void Item::fillFromVariantMap(const QVariantMap &map, const QHash<QString, Widget *> &widgets)
+void Item::fillFromRecord(const ItemRecord &record, const QHash<QString, Widget *> &widgets)
 {
-    m_sizingInfo.fromVariantMap(map[QStringLiteral("sizingInfo")].toMap());
-    m_isVisible = map[QStringLiteral("isVisible")].toBool();
-    setObjectName(map[QStringLiteral("objectName")].toString());
+    m_sizingInfo = record.sizingInfo;
+    m_isVisible = record.isVisible;
+    invalidateSizeConstraints();
+    setObjectName(record.objectName);
 
-    const QString guestId = map.value(QStringLiteral("guestId")).toString();
-    if (!guestId.isEmpty()) {
-        if (Widget *guest = widgets.value(guestId)) {
+    if (!record.guestId.isEmpty()) {
+        if (Widget *guest = widgets.value(record.guestId)) {
             setGuestWidget(guest);
             m_guest->setParent(hostWidget());
         } else if (hostWidget()) {
@@ -251,6 +298,18 @@ void Item::fillFromVariantMap(const QVariantMap &map, const QHash<QString, Widge
     }
 }
 
+QVariantMap Item::toVariantMap() const
+{
+    return toRecord().toVariantMap();
+}
+
+void Item::fillFromVariantMap(const QVariantMap &map, const QHash<QString, Widget *> &widgets)
+{
+    ItemRecord record;
+    record.fromVariantMap(map);
+    fillFromRecord(record, widgets);
+}
+
 Item *Item::createFromVariantMap(Widget *hostWidget, ItemContainer *parent,
                                  const QVariantMap &map, const QHash<QString, Widget *> &widgets)
 {
@@ -366,9 +425,20 @@ bool Item::isBeingInserted() const
     return m_sizingInfo.isBeingInserted;
 }
 
+quint64 Item::layoutGeneration()
+{
+    return s_layoutGeneration;
+}
+
+quint64 Item::constraintsGeneration()
+{
+    return s_constraintsGeneration;
+}
+
 void Item::setBeingInserted(bool is)
 {
     m_sizingInfo.isBeingInserted = is;
+    invalidateSizeConstraints();
 
     // Trickle up the hierarchy too, as the parent might be hidden due to not having visible children
     if (auto parent = parentContainer()) {
@@ -386,6 +456,8 @@ void Item::setParentContainer(ItemContainer *parent)
     if (parent == m_parent)
         return;
 
+    invalidateSizeConstraints();
+
     if (m_parent) {
         disconnect(this, &Item::minSizeChanged, m_parent, &ItemContainer::onChildMinSizeChanged);
         disconnect(this, &Item::visibleChanged, m_parent, &ItemContainer::onChildVisibleChanged);
@@ -449,6 +521,7 @@ void Item::setMinSize(QSize sz)
 {
     if (sz != m_sizingInfo.minSize) {
         m_sizingInfo.minSize = sz;
+        invalidateSizeConstraints();
         Q_EMIT minSizeChanged(this);
         if (!m_isSettingGuest)
             setSize_recursive(size().expandedTo(sz));
@@ -459,6 +532,7 @@ void Item::setMaxSizeHint(QSize sz)
 {
     if (sz != m_sizingInfo.maxSizeHint) {
         m_sizingInfo.maxSizeHint = sz;
+        invalidateSizeConstraints();
         Q_EMIT maxSizeChanged(this);
     }
 }
@@ -598,6 +672,7 @@ void Item::setIsVisible(bool is)
 {
     if (is != m_isVisible) {
         m_isVisible = is;
+        invalidateSizeConstraints();
         Q_EMIT visibleChanged(this, is);
     }
 
@@ -674,6 +749,8 @@ void Item::setGeometry(QRect rect)
     QRect &m_geometry = m_sizingInfo.geometry;
 
     if (rect != m_geometry) {
+        PerfCounters::increment(PerfCounters::Counter_ItemSetGeometry);
+        invalidateSpatialIndexes();
         const QRect oldGeo = m_geometry;
 
         m_geometry = rect;
@@ -701,21 +778,65 @@ void Item::setGeometry(QRect rect)
                        << ": parent=" << parentContainer();
         }
 
-        Q_EMIT geometryChanged();
+        static const QMetaMethod geometryChangedSignal = QMetaMethod::fromSignal(&Item::geometryChanged);
+        static const QMetaMethod widthChangedSignal = QMetaMethod::fromSignal(&Item::widthChanged);
+        static const QMetaMethod heightChangedSignal = QMetaMethod::fromSignal(&Item::heightChanged);
 
-        if (oldGeo.x() != x())
-            Q_EMIT xChanged();
-        if (oldGeo.y() != y())
-            Q_EMIT yChanged();
-        if (oldGeo.width() != width())
+        if (shouldEmitGeometrySignal(geometryChangedSignal))
+            Q_EMIT geometryChanged();
+
+        emitPositionChanged(oldGeo.x() != x(), oldGeo.y() != y());
+
+        if (oldGeo.width() != width() && shouldEmitGeometrySignal(widthChangedSignal))
             Q_EMIT widthChanged();
-        if (oldGeo.height() != height())
+        if (oldGeo.height() != height() && shouldEmitGeometrySignal(heightChangedSignal))
             Q_EMIT heightChanged();
 
+        if (s_numGeometryObservers > 0)
+            notifyGeometryObserver();
+
         updateWidgetGeometries();
     }
 }
 
+bool Item::shouldEmitGeometrySignal(const QMetaMethod &signal) const
+{
+    switch (Config::self().m_geometrySignals) {
+    case Config::GeometrySignals::Always:
+        return true;
+    case Config::GeometrySignals::WhenConnected:
+        return isSignalConnected(signal);
+    case Config::GeometrySignals::QtQuickOnly:
+#ifdef KDDOCKWIDGETS_QTQUICK
+        return true;
+#else
+        return false;
+#endif
+    }
+
+    return true;
+}
+
+void Item::emitPositionChanged(bool xDidChange, bool yDidChange)
+{
+    if (!xDidChange && !yDidChange)
+        return;
+
+    static const QMetaMethod xChangedSignal = QMetaMethod::fromSignal(&Item::xChanged);
+    static const QMetaMethod yChangedSignal = QMetaMethod::fromSignal(&Item::yChanged);
+
+    if (xDidChange && shouldEmitGeometrySignal(xChangedSignal))
+        Q_EMIT xChanged();
+    if (yDidChange && shouldEmitGeometrySignal(yChangedSignal))
+        Q_EMIT yChanged();
+
+    // Children positions are relative to us, but anything mapping them to the root needs to know
+    if (m_isContainer) {
+        for (Item *child : qAsConst(static_cast<ItemContainer *>(this)->m_children))
+            child->emitPositionChanged(xDidChange, yDidChange);
+    }
+}
+
 void Item::dumpLayout(int level)
 {
     QString indent;
@@ -763,6 +884,7 @@ Item::Item(bool isContainer, Widget *hostWidget, ItemContainer *parent)
 
 Item::~Item()
 {
+    invalidateSizeConstraints();
 }
 
 bool Item::eventFilter(QObject *widget, QEvent *e)
@@ -932,6 +1054,9 @@ struct ItemBoxContainer::Private
     int defaultLengthFor(Item *item, InitialOption option) const;
     bool isOverflowing() const;
     void relayoutIfNeeded();
+    /// Returns whether the deserialized geometries already honour the min-sizes and tile each
+    /// container without gaps or overlaps, in which case relayoutIfNeeded() wouldn't change anything
+    bool restoredGeometriesAreValid() const;
     const Item *itemFromPath(const QVector<int> &path) const;
     void resizeChildren(QSize oldSize, QSize newSize, SizingInfo::List &sizes, ChildrenResizeStrategy);
     void honourMaxSizes(SizingInfo::List &sizes);
@@ -951,6 +1076,11 @@ struct ItemBoxContainer::Private
     QSize minSize(const Item::List &items) const;
     int excessLength() const;
 
+    /// Rebuilds m_indexedChildren if anything changed in the layout since the last time
+    void updateSpatialIndex() const;
+    /// Returns the first separator, along m_orientation, whose end is at or after @p pos
+    Separator *separatorNotBefore(int pos) const;
+
     mutable bool m_checkSanityScheduled = false;
     QVector<Layouting::Separator *> m_separators;
     bool m_convertingItemToContainer = false;
@@ -958,6 +1088,25 @@ struct ItemBoxContainer::Private
     bool m_isDeserializing = false;
     bool m_isSimplifying = false;
     Qt::Orientation m_orientation = Qt::Vertical;
+
+    // Spatial index: the visible children sorted along m_orientation together with their end edge,
+    // so hit-testing is a binary search instead of a linear scan. Children don't overlap, but if they
+    // transiently do, m_spatialIndexUsable is false and we fallback to scanning linearly.
+    mutable QVector<Item *> m_indexedChildren;
+    mutable QVector<int> m_indexedEdges;
+    mutable quint64 m_spatialIndexGeneration = 0;
+    mutable bool m_spatialIndexUsable = false;
+
+    /// Returns the root's FlatItemTree, rebuilt if stale. Nested containers look themselves up in it.
+    /// Pass @p needsGeometries if the geometries are used, otherwise only the size constraints
+    /// need to be up to date, and those don't change during layout passes.
+    /// Returns nullptr while it's being built.
+    const FlatItemTree *flatTree(bool needsGeometries = false) const;
+
+    // Only used when we're the root
+    mutable FlatItemTree m_flatTree;
+    mutable bool m_buildingFlatTree = false;
+
     ItemBoxContainer *const q;
 };
 
@@ -1148,16 +1297,17 @@ bool ItemBoxContainer::checkSanity()
             return false;
         }
 
-        Widget *separatorWidget = separator->asWidget();
-        if (separatorWidget->geometry().size() != expectedSeparatorSize) {
-            qWarning() << Q_FUNC_INFO << "Unexpected separator size" << separatorWidget->geometry().size()
+        // Not asWidget()->geometry(), virtual separators don't have a widget
+        const QRect separatorGeometry = separator->geometry();
+        if (separatorGeometry.size() != expectedSeparatorSize) {
+            qWarning() << Q_FUNC_INFO << "Unexpected separator size" << separatorGeometry.size()
                        << "; expected=" << expectedSeparatorSize
                        << separator << "; this=" << this;
             return false;
         }
 
-        const int separatorPos2 = Layouting::pos(separatorWidget->geometry().topLeft(), oppositeOrientation(d->m_orientation));
-        if (Layouting::pos(separatorWidget->geometry().topLeft(), oppositeOrientation(d->m_orientation)) != pos2) {
+        const int separatorPos2 = Layouting::pos(separatorGeometry.topLeft(), oppositeOrientation(d->m_orientation));
+        if (separatorPos2 != pos2) {
             root()->dumpLayout();
             qWarning() << Q_FUNC_INFO << "Unexpected position pos2=" << separatorPos2
                        << "; expected=" << pos2
@@ -1217,12 +1367,14 @@ int ItemBoxContainer::indexOfVisibleChild(const Item *item) const
 
 void ItemBoxContainer::restore(Item *child)
 {
+    GeometryTransaction transaction(this);
     restoreChild(child, NeighbourSqueezeStrategy::ImmediateNeighboursFirst);
 }
 
 void ItemBoxContainer::removeItem(Item *item, bool hardRemove)
 {
     Q_ASSERT(!item->isRoot());
+    GeometryTransaction transaction(this);
 
     if (!contains(item)) {
         // Not ours, ask parent
@@ -1238,6 +1390,7 @@ void ItemBoxContainer::removeItem(Item *item, bool hardRemove)
 
     if (hardRemove) {
         m_children.removeOne(item);
+        invalidateSizeConstraints();
         delete item;
         if (!isContainer)
             Q_EMIT root()->numItemsChanged();
@@ -1294,6 +1447,7 @@ ItemBoxContainer *ItemBoxContainer::convertChildToContainer(Item *leaf)
 
     insertItem(container, index, DefaultSizeMode::NoDefaultSizeMode);
     m_children.removeOne(leaf);
+    invalidateSizeConstraints();
     container->setGeometry(leaf->geometry());
     container->insertItem(leaf, Location_OnTop, DefaultSizeMode::NoDefaultSizeMode);
     Q_EMIT itemsChanged();
@@ -1348,6 +1502,7 @@ void ItemBoxContainer::insertItem(Item *item, Location loc,
                                   KDDockWidgets::InitialOption initialOption)
 {
     Q_ASSERT(item != this);
+    GeometryTransaction transaction(this);
     if (contains(item)) {
         qWarning() << Q_FUNC_INFO << "Item already exists";
         return;
@@ -1362,6 +1517,7 @@ void ItemBoxContainer::insertItem(Item *item, Location loc,
         if (m_children.size() == 1) {
             // 2 items is the minimum to know which orientation we're layedout
             d->m_orientation = locOrientation;
+            invalidateSizeConstraints();
         }
 
         const auto index = locationIsSide1(loc) ? 0 : m_children.size();
@@ -1373,6 +1529,7 @@ void ItemBoxContainer::insertItem(Item *item, Location loc,
         container->setGeometry(rect());
         container->setChildren(m_children, d->m_orientation);
         m_children.clear();
+        invalidateSizeConstraints();
         setOrientation(oppositeOrientation(d->m_orientation));
         insertItem(container, 0, DefaultSizeMode::NoDefaultSizeMode);
 
@@ -1483,16 +1640,14 @@ QRect ItemBoxContainer::suggestedDropRect(const Item *item, const Item *relative
     if (windowNeedsGrowing)
         return suggestedDropRectFallback(item, relativeTo, loc);
 
-    const QVariantMap rootSerialized = root()->toVariantMap();
     ItemBoxContainer rootCopy(nullptr);
-    rootCopy.fillFromVariantMap(rootSerialized, {});
+    rootCopy.fillFromRecord(root()->toRecord(), {});
 
     if (relativeTo)
         relativeTo = rootCopy.d->itemFromPath(relativeTo->pathFromRoot());
 
-    const QVariantMap itemSerialized = item->toVariantMap();
     auto itemCopy = new Item(nullptr);
-    itemCopy->fillFromVariantMap(itemSerialized, {});
+    itemCopy->fillFromRecord(item->toRecord(), {});
 
     if (relativeTo) {
         auto r = const_cast<Item *>(relativeTo);
@@ -1626,6 +1781,7 @@ Qt::Orientation ItemBoxContainer::orientation() const
 
 void ItemBoxContainer::positionItems(SizingInfo::List &sizes)
 {
+    PerfCounters::increment(PerfCounters::Counter_LayoutPasses);
     int nextPos = 0;
     const auto count = sizes.count();
     const Qt::Orientation oppositeOrientation = ::oppositeOrientation(d->m_orientation);
@@ -1655,17 +1811,30 @@ void ItemBoxContainer::clear()
         delete item;
     }
     m_children.clear();
+    invalidateSizeConstraints();
     d->deleteSeparators();
 }
 
 Item *ItemBoxContainer::itemAt(QPoint p) const
 {
-    for (Item *item : qAsConst(m_children)) {
-        if (item->isVisible() && item->geometry().contains(p))
-            return item;
+    d->updateSpatialIndex();
+    if (!d->m_spatialIndexUsable) {
+        for (Item *item : qAsConst(m_children)) {
+            if (item->isVisible() && item->geometry().contains(p))
+                return item;
+        }
+
+        return nullptr;
     }
 
-    return nullptr;
+    const auto begin = d->m_indexedEdges.cbegin();
+    const auto end = d->m_indexedEdges.cend();
+    const auto it = std::lower_bound(begin, end, Layouting::pos(p, d->m_orientation));
+    if (it == end)
+        return nullptr;
+
+    Item *item = d->m_indexedChildren.at(int(it - begin));
+    return item->geometry().contains(p) ? item : nullptr;
 }
 
 Item *ItemBoxContainer::itemAt_recursive(QPoint p) const
@@ -1681,6 +1850,24 @@ Item *ItemBoxContainer::itemAt_recursive(QPoint p) const
     return nullptr;
 }
 
+Separator *ItemBoxContainer::separatorAt_recursive(QPoint p) const
+{
+    // Separator geometries are in root coordinates
+    const QPoint rootPos = mapToRoot(p);
+    if (Separator *separator = d->separatorNotBefore(Layouting::pos(rootPos, d->m_orientation))) {
+        if (separator->geometry().contains(rootPos))
+            return separator;
+    }
+
+    // Separators don't overlap any sibling, so only the child container under p can have it
+    if (Item *item = itemAt(p)) {
+        if (auto c = item->asBoxContainer())
+            return c->separatorAt_recursive(c->mapFromParent(p));
+    }
+
+    return nullptr;
+}
+
 void ItemBoxContainer::setHostWidget(Widget *host)
 {
     Item::setHostWidget(host);
@@ -1723,6 +1910,7 @@ void ItemBoxContainer::insertItem(Item *item, int index, InitialOption option)
     }
 
     m_children.insert(index, item);
+    invalidateSizeConstraints();
     item->setParentContainer(this);
 
     Q_EMIT itemsChanged();
@@ -1763,6 +1951,7 @@ int ItemBoxContainer::usableLength() const
 void ItemBoxContainer::setChildren(const List &children, Qt::Orientation o)
 {
     m_children = children;
+    invalidateSizeConstraints();
     for (Item *item : children)
         item->setParentContainer(this);
 
@@ -1773,6 +1962,7 @@ void ItemBoxContainer::setOrientation(Qt::Orientation o)
 {
     if (o != d->m_orientation) {
         d->m_orientation = o;
+        invalidateSizeConstraints();
         d->updateSeparators_recursive();
     }
 }
@@ -1787,12 +1977,13 @@ QSize ItemBoxContainer::Private::minSize(const Item::List &items) const
             if (!(item->isVisible() || item->isBeingInserted()))
                 continue;
             numVisible++;
+            const QSize itemMinSize = item->minSize(); // recursive for containers, so only once
             if (q->isVertical()) {
-                minW = qMax(minW, item->minSize().width());
-                minH += item->minSize().height();
+                minW = qMax(minW, itemMinSize.width());
+                minH += itemMinSize.height();
             } else {
-                minH = qMax(minH, item->minSize().height());
-                minW += item->minSize().width();
+                minH = qMax(minH, itemMinSize.height());
+                minW += itemMinSize.width();
             }
         }
 
@@ -1806,13 +1997,40 @@ QSize ItemBoxContainer::Private::minSize(const Item::List &items) const
     return QSize(minW, minH);
 }
 
+const FlatItemTree *ItemBoxContainer::Private::flatTree(bool needsGeometries) const
+{
+    ItemBoxContainer *root = q->root();
+    if (!root || root->d->m_buildingFlatTree)
+        return nullptr;
+
+    FlatItemTree &tree = root->d->m_flatTree;
+    if (needsGeometries ? !tree.isUpToDate() : !tree.constraintsAreUpToDate()) {
+        QScopedValueRollback<bool> guard(root->d->m_buildingFlatTree, true);
+        tree.build(root);
+    }
+
+    return &tree;
+}
+
 QSize ItemBoxContainer::minSize() const
 {
+    if (const FlatItemTree *tree = d->flatTree()) {
+        const int index = tree->indexOf(this);
+        if (index != -1)
+            return tree->minSize(index);
+    }
+
     return d->minSize(m_children);
 }
 
 QSize ItemBoxContainer::maxSizeHint() const
 {
+    if (const FlatItemTree *tree = d->flatTree()) {
+        const int index = tree->indexOf(this);
+        if (index != -1)
+            return tree->maxSizeHint(index);
+    }
+
     int maxW = isVertical() ? hardcodedMaximumSize.width() : 0;
     int maxH = isVertical() ? 0 : hardcodedMaximumSize.height();
 
@@ -2030,6 +2248,7 @@ void ItemBoxContainer::Private::honourMaxSizes(SizingInfo::List &sizes)
 
 void ItemBoxContainer::setSize_recursive(QSize newSize, ChildrenResizeStrategy strategy)
 {
+    GeometryTransaction transaction(this);
     QScopedValueRollback<bool> block(d->m_blockUpdatePercentages, true);
 
     const QSize minSize = this->minSize();
@@ -2123,8 +2342,8 @@ void ItemBoxContainer::dumpLayout(int level)
             if (i < d->m_separators.size()) {
                 auto separator = d->m_separators.at(i);
                 qDebug().noquote() << indent << " - Separator: "
-                                   << "local.geo=" << mapFromRoot(separator->asWidget()->geometry())
-                                   << "global.geo=" << separator->asWidget()->geometry()
+                                   << "local.geo=" << mapFromRoot(separator->geometry())
+                                   << "global.geo=" << separator->geometry()
                                    << separator;
             }
             ++i;
@@ -2241,6 +2460,7 @@ int ItemBoxContainer::oppositeLength() const
 
 void ItemBoxContainer::requestSeparatorMove(Separator *separator, int delta)
 {
+    GeometryTransaction transaction(this);
     const auto separatorIndex = d->m_separators.indexOf(separator);
     if (separatorIndex == -1) {
         // Doesn't happen
@@ -2346,6 +2566,7 @@ void ItemBoxContainer::requestSeparatorMove(Separator *separator, int delta)
 
 void ItemBoxContainer::requestEqualSize(Separator *separator)
 {
+    GeometryTransaction transaction(this);
     const auto separatorIndex = d->m_separators.indexOf(separator);
     if (separatorIndex == -1) {
         // Doesn't happen
@@ -2480,6 +2701,7 @@ void ItemBoxContainer::layoutEqually(SizingInfo::List &sizes)
 
 void ItemBoxContainer::layoutEqually_recursive()
 {
+    GeometryTransaction transaction(this);
     layoutEqually();
     for (Item *item : qAsConst(m_children)) {
         if (item->isVisible()) {
@@ -2798,37 +3020,33 @@ void ItemBoxContainer::growItem(int index, SizingInfo::List &sizes, int missing,
         const LengthOnSide side1Length = lengthOnSide(sizes, index - 1, Side1, d->m_orientation);
         const LengthOnSide side2Length = lengthOnSide(sizes, index + 1, Side2, d->m_orientation);
 
-        int available1 = side1Length.available();
-        int available2 = side2Length.available();
+        const int available1 = side1Length.available();
+        const int available2 = side2Length.available();
 
         if (toSteal > available1 + available2) {
             root()->dumpLayout();
             Q_ASSERT(false);
         }
 
-        while (toSteal > 0) {
+        // Half from each side. If one side runs out, the other side gives the rest.
+        // An odd remainder comes from side1.
+        if (toSteal > 0) {
             if (available1 == 0) {
-                Q_ASSERT(available2 >= toSteal);
-                side2Growth += toSteal;
-                break;
+                side2Growth = toSteal;
             } else if (available2 == 0) {
-                Q_ASSERT(available1 >= toSteal);
-                side1Growth += toSteal;
-                break;
+                side1Growth = toSteal;
+            } else {
+                const int half = qMax(1, toSteal / 2);
+                side1Growth = qMin(half, available1);
+                side2Growth = qMin(toSteal - side1Growth, qMin(half, available2));
+                const int rest = toSteal - side1Growth - side2Growth;
+                if (rest > 0) {
+                    if (side1Growth == available1)
+                        side2Growth += rest;
+                    else
+                        side1Growth += rest;
+                }
             }
-
-            const int toTake = qMax(1, toSteal / 2);
-            const int took1 = qMin(toTake, available1);
-            toSteal -= took1;
-            available1 -= took1;
-            side1Growth += took1;
-            if (toSteal == 0)
-                break;
-
-            const int took2 = qMin(toTake, available2);
-            toSteal -= took2;
-            side2Growth += took2;
-            available2 -= took2;
         }
         shrinkNeighbours(index, sizes, side1Growth, side2Growth, neighbourSqueezeStrategy);
     } else if (growthStrategy == GrowthStrategy::Side1Only) {
@@ -2912,52 +3130,92 @@ SizingInfo::List ItemBoxContainer::sizes(bool ignoreBeingInserted) const
     return result;
 }
 
-QVector<int> ItemBoxContainer::calculateSqueezes(SizingInfo::List::ConstIterator begin, // clazy:exclude=function-args-by-ref
-                                                 SizingInfo::List::ConstIterator end, int needed, // clazy:exclude=function-args-by-ref
-                                                 NeighbourSqueezeStrategy strategy, bool reversed) const
+/// @brief Distributes @p needed among donors, taking the same amount from each, capped by what
+/// each has available. The remainder which can't be split evenly comes from the first donors.
+///
+/// Equivalent to taking missing / numDonors from every donor until satisfied, but instead of
+/// iterating we find the final level directly: the smallest L for which what's still missing after
+/// taking qMin(available, L) from everyone is less than the number of donors with more than L.
+///
+/// @return false if there isn't enough available
+static bool distributeSqueezesEvenly(const int *available, int count, int needed, int *squeezes)
 {
-    QVector<int> availabilities;
-    for (auto it = begin; it < end; ++it) {
-        availabilities << it->availableLength(d->m_orientation);
-    }
+    std::fill(squeezes, squeezes + count, 0);
+    if (needed <= 0)
+        return true;
+
+    QVarLengthArray<int, 32> sorted;
+    for (int i = 0; i < count; ++i) {
+        if (available[i] > 0)
+            sorted.append(available[i]);
+    }
+    std::sort(sorted.begin(), sorted.end());
+
+    // Between two consecutive availabilities the number of unsaturated donors is constant, so
+    // the level can be solved for in closed form
+    const int numDonors = int(sorted.size());
+    int level = -1;
+    int levelStart = 0;
+    int saturated = 0; // Sum of the availabilities <= levelStart
+    for (int i = 0; i <= numDonors; ++i) {
+        const int numUnsaturated = numDonors - i;
+        const int rest = needed - saturated;
+        if (numUnsaturated == 0) {
+            if (rest <= 0)
+                level = levelStart;
+            break;
+        }
+
+        const int levelEnd = sorted.at(i);
+        if (levelEnd > levelStart) {
+            const int candidate = qMax(levelStart, rest > 0 ? rest / numUnsaturated : 0);
+            if (candidate < levelEnd) {
+                level = candidate;
+                break;
+            }
+        }
 
-    const auto count = availabilities.count();
+        saturated += sorted.at(i);
+        levelStart = levelEnd;
+    }
 
-    QVector<int> squeezes;
-    squeezes.resize(count);
-    std::fill(squeezes.begin(), squeezes.end(), 0);
+    if (level == -1)
+        return false;
 
     int missing = needed;
+    for (int i = 0; i < count; ++i) {
+        squeezes[i] = qMin(available[i], level);
+        missing -= squeezes[i];
+    }
 
-    if (strategy == NeighbourSqueezeStrategy::AllNeighbours) {
-        while (missing > 0) {
-            const int numDonors = std::count_if(availabilities.cbegin(), availabilities.cend(), [](int num) {
-                return num > 0;
-            });
+    // Less than the number of donors left, first come first served
+    for (int i = 0; i < count && missing > 0; ++i) {
+        const int extra = qMin(missing, available[i] - squeezes[i]);
+        squeezes[i] += extra;
+        missing -= extra;
+    }
 
-            if (numDonors == 0) {
-                root()->dumpLayout();
-                Q_ASSERT(false);
-                return {};
-            }
+    return true;
+}
 
-            int toTake = missing / numDonors;
-            if (toTake == 0)
-                toTake = missing;
+void ItemBoxContainer::calculateSqueezes(SizingInfo::List::ConstIterator begin, // clazy:exclude=function-args-by-ref
+                                         SizingInfo::List::ConstIterator end, int needed, // clazy:exclude=function-args-by-ref
+                                         NeighbourSqueezeStrategy strategy, int *squeezes,
+                                         bool reversed) const
+{
+    const auto count = int(end - begin);
+    QVarLengthArray<int, 32> availabilities(count);
+    for (int i = 0; i < count; ++i)
+        availabilities[i] = (begin + i)->availableLength(d->m_orientation);
 
-            for (int i = 0; i < count; ++i) {
-                const int available = availabilities.at(i);
-                if (available == 0)
-                    continue;
-                const int took = qMin(missing, qMin(toTake, available));
-                availabilities[i] -= took;
-                missing -= took;
-                squeezes[i] += took;
-                if (missing == 0)
-                    break;
-            }
+    if (strategy == NeighbourSqueezeStrategy::AllNeighbours) {
+        if (!distributeSqueezesEvenly(availabilities.constData(), count, needed, squeezes)) {
+            root()->dumpLayout();
+            Q_ASSERT(false);
         }
     } else if (strategy == NeighbourSqueezeStrategy::ImmediateNeighboursFirst) {
+        std::fill(squeezes, squeezes + count, 0);
+        int missing = needed;
         for (int i = 0; i < count; i++) {
             const auto index = reversed ? count - 1 - i : i;
 
@@ -2972,14 +3230,6 @@ QVector<int> ItemBoxContainer::calculateSqueezes(SizingInfo::List::ConstIterator
                 break;
         }
     }
-
-    if (missing < 0) {
-        // Doesn't really happen
-        qWarning() << Q_FUNC_INFO << "Missing is negative" << missing
-                   << squeezes;
-    }
-
-    return squeezes;
 }
 
 void ItemBoxContainer::shrinkNeighbours(int index, SizingInfo::List &sizes, int side1Amount,
@@ -2992,7 +3242,8 @@ void ItemBoxContainer::shrinkNeighbours(int index, SizingInfo::List &sizes, int
         auto begin = sizes.cbegin();
         auto end = sizes.cbegin() + index;
         const bool reversed = strategy == NeighbourSqueezeStrategy::ImmediateNeighboursFirst;
-        const QVector<int> squeezes = calculateSqueezes(begin, end, side1Amount, strategy, reversed);
+        QVarLengthArray<int, 32> squeezes(int(end - begin));
+        calculateSqueezes(begin, end, side1Amount, strategy, squeezes.data(), reversed);
         for (int i = 0; i < squeezes.size(); ++i) {
             const int squeeze = squeezes.at(i);
             SizingInfo &sizing = sizes[i];
@@ -3005,7 +3256,8 @@ void ItemBoxContainer::shrinkNeighbours(int index, SizingInfo::List &sizes, int
         auto begin = sizes.cbegin() + index + 1;
         auto end = sizes.cend();
 
-        const QVector<int> squeezes = calculateSqueezes(begin, end, side2Amount, strategy);
+        QVarLengthArray<int, 32> squeezes(int(end - begin));
+        calculateSqueezes(begin, end, side2Amount, strategy, squeezes.data());
         for (int i = 0; i < squeezes.size(); ++i) {
             const int squeeze = squeezes.at(i);
             SizingInfo &sizing = sizes[i + index + 1];
@@ -3055,13 +3307,16 @@ void ItemBoxContainer::Private::updateSeparators()
                 newSeparators.push_back(separator);
                 m_separators.removeOne(separator);
             } else {
-                separator = Config::self().createSeparator(q->hostWidget());
+                // Prefer a separator that a container in the same host widget stopped using
+                separator = q->hostWidget()->takeSeparatorFromPool(m_orientation);
+                if (!separator)
+                    separator = Config::self().createSeparator(q->hostWidget());
                 separator->init(q, m_orientation);
                 newSeparators.push_back(separator);
             }
         }
 
-        // delete what remained, which is unused
+        // pool what remained, which is unused
         deleteSeparators();
 
         m_separators = newSeparators;
@@ -3082,7 +3337,17 @@ void ItemBoxContainer::Private::updateSeparators()
 
 void ItemBoxContainer::Private::deleteSeparators()
 {
-    qDeleteAll(m_separators);
+    // Separators aren't deleted but hidden and returned to their host widget, so they can be
+    // reused without churning native widgets when showing/hiding docks or restoring a layout.
+    // Note that during setHostWidget() the separators still belong to the old host.
+    for (Separator *separator : qAsConst(m_separators)) {
+        if (Widget *host = separator->hostWidget()) {
+            host->returnSeparatorToPool(separator);
+        } else {
+            delete separator;
+        }
+    }
+
     m_separators.clear();
 }
 
@@ -3115,6 +3380,11 @@ int ItemBoxContainer::Private::excessLength() const
     return qMax(0, Layouting::length(q->size(), m_orientation) - q->maxLengthHint(m_orientation));
 }
 
+void ItemBoxContainer::removeEmptyContainers()
+{
+    simplify();
+}
+
 void ItemBoxContainer::simplify()
 {
     // Removes unneeded nesting. For example, a vertical layout doesn't need to have vertical layouts
@@ -3148,6 +3418,7 @@ void ItemBoxContainer::simplify()
 
     if (m_children != newChildren) {
         m_children = newChildren;
+        invalidateSizeConstraints();
         positionItems();
         updateChildPercentages();
     }
@@ -3155,14 +3426,63 @@ void ItemBoxContainer::simplify()
 
 Separator *ItemBoxContainer::Private::separatorAt(int p) const
 {
-    for (Separator *separator : m_separators) {
-        if (separator->position() == p)
-            return separator;
-    }
+    // m_separators is sorted by position, as updateSeparators() assigns positions in order
+    const auto it = std::lower_bound(m_separators.cbegin(), m_separators.cend(), p,
+                                     [](Separator *separator, int pos) {
+                                         return separator->position() < pos;
+                                     });
+
+    if (it != m_separators.cend() && (*it)->position() == p)
+        return *it;
 
     return nullptr;
 }
 
+Separator *ItemBoxContainer::Private::separatorNotBefore(int pos) const
+{
+    const auto it = std::lower_bound(m_separators.cbegin(), m_separators.cend(), pos,
+                                     [this](Separator *separator, int p) {
+                                         const QRect geo = separator->geometry();
+                                         return (m_orientation == Qt::Vertical ? geo.bottom() : geo.right()) < p;
+                                     });
+
+    return it == m_separators.cend() ? nullptr : *it;
+}
+
+void ItemBoxContainer::Private::updateSpatialIndex() const
+{
+    if (m_spatialIndexGeneration == s_layoutGeneration)
+        return;
+
+    m_spatialIndexGeneration = s_layoutGeneration;
+    m_indexedChildren.clear();
+    m_indexedEdges.clear();
+    m_spatialIndexUsable = true;
+
+    bool first = true;
+    int previousEnd = 0;
+    for (Item *item : qAsConst(q->m_children)) {
+        const QRect geo = item->geometry();
+        if (!item->isVisible() || geo.isEmpty()) // Can't contain any point
+            continue;
+
+        const int start = m_orientation == Qt::Vertical ? geo.top() : geo.left();
+        const int end = m_orientation == Qt::Vertical ? geo.bottom() : geo.right();
+        if (!first && start <= previousEnd) {
+            // Overlapping or out of order, can't binary search
+            m_spatialIndexUsable = false;
+            m_indexedChildren.clear();
+            m_indexedEdges.clear();
+            return;
+        }
+
+        m_indexedChildren.push_back(item);
+        m_indexedEdges.push_back(end);
+        previousEnd = end;
+        first = false;
+    }
+}
+
 bool ItemBoxContainer::isVertical() const
 {
     return d->m_orientation == Qt::Vertical;
@@ -3240,38 +3560,36 @@ int ItemBoxContainer::maxPosForSeparator_global(Separator *separator, bool honou
     return separator->position() + availableToSqueeze;
 }
 
-QVariantMap ItemBoxContainer::toVariantMap() const
+ItemRecord ItemBoxContainer::toRecord() const
 {
-    QVariantMap result = Item::toVariantMap();
+    ItemRecord record = Item::toRecord();
 
-    QVariantList childrenV;
-    childrenV.reserve(m_children.size());
+    record.children.reserve(m_children.size());
     for (Item *child : qAsConst(m_children)) {
-        childrenV.push_back(child->toVariantMap());
+        record.children.push_back(child->toRecord());
     }
 
-    result[QStringLiteral("children")] = childrenV;
-    result[QStringLiteral("orientation")] = d->m_orientation;
+    record.orientation = d->m_orientation;
 
-    return result;
+    return record;
 }
 
-void ItemBoxContainer::fillFromVariantMap(const QVariantMap &map,
-                                          const QHash<QString, Widget *> &widgets)
+void ItemBoxContainer::fillFromRecord(const ItemRecord &record,
+                                      const QHash<QString, Widget *> &widgets)
 {
     QScopedValueRollback<bool> deserializing(d->m_isDeserializing, true);
 
-    Item::fillFromVariantMap(map, widgets);
-    const QVariantList childrenV = map[QStringLiteral("children")].toList();
-    d->m_orientation = Qt::Orientation(map[QStringLiteral("orientation")].toInt());
-
-    for (const QVariant &childV : childrenV) {
-        const QVariantMap childMap = childV.toMap();
-        const bool isContainer = childMap.value(QStringLiteral("isContainer")).toBool();
-        Item *child = isContainer ? new ItemBoxContainer(hostWidget(), this)
-                                  : new Item(hostWidget(), this);
-        child->fillFromVariantMap(childMap, widgets);
+    Item::fillFromRecord(record, widgets);
+    d->m_orientation = record.orientation;
+    invalidateSizeConstraints();
+
+    m_children.reserve(record.children.size());
+    for (const ItemRecord &childRecord : record.children) {
+        Item *child = childRecord.isContainer ? new ItemBoxContainer(hostWidget(), this)
+                                              : new Item(hostWidget(), this);
+        child->fillFromRecord(childRecord, widgets);
         m_children.push_back(child);
+        invalidateSizeConstraints();
     }
 
     if (isRoot()) {
@@ -3281,8 +3599,15 @@ void ItemBoxContainer::fillFromVariantMap(const QVariantMap &map,
             d->updateWidgets_recursive();
         }
 
-        d->relayoutIfNeeded();
-        positionItems_recursive();
+        if (d->restoredGeometriesAreValid()) {
+            // Common case when the screen didn't change since the layout was saved: the saved
+            // geometries are used verbatim
+            if (!d->isDummy())
+                PerfCounters::increment(PerfCounters::Counter_FastPathRestores);
+        } else {
+            d->relayoutIfNeeded();
+            positionItems_recursive();
+        }
 
         Q_EMIT minSizeChanged(this);
 #ifdef DOCKS_DEVELOPER_MODE
@@ -3395,6 +3720,56 @@ void ItemBoxContainer::Private::relayoutIfNeeded()
     }
 }
 
+bool ItemBoxContainer::Private::restoredGeometriesAreValid() const
+{
+    const FlatItemTree *tree = flatTree(/*needsGeometries=*/true);
+    if (!tree || tree->size() == 0)
+        return false;
+
+    for (int i = 0; i < tree->size(); ++i) {
+        // The root is checked even if empty, like relayoutIfNeeded() does
+        if (i != 0 && !tree->testFlag(i, FlatItemTree::Flag_IsVisible))
+            continue;
+
+        const QRect geo = tree->geometry(i);
+        const QSize min = tree->minSize(i);
+        if (geo.width() < min.width() || geo.height() < min.height())
+            return false;
+
+        if (!tree->testFlag(i, FlatItemTree::Flag_IsContainer))
+            continue;
+
+        // The visible children must be laid out back to back, separated by exactly one separator,
+        // and fill the container in both directions
+        const bool vertical = tree->testFlag(i, FlatItemTree::Flag_IsVertical);
+        const int containerStart = vertical ? geo.y() : geo.x();
+        const int containerEnd = vertical ? geo.bottom() : geo.right();
+        int nextPos = containerStart;
+        bool hasVisibleChildren = false;
+
+        for (int child = i + 1; child < tree->subtreeEnd(i); child = tree->subtreeEnd(child)) {
+            if (!tree->testFlag(child, FlatItemTree::Flag_IsVisible))
+                continue;
+
+            const QRect childGeo = tree->geometry(child);
+            const bool fillsOppositeSide = vertical
+                ? (childGeo.x() == geo.x() && childGeo.width() == geo.width())
+                : (childGeo.y() == geo.y() && childGeo.height() == geo.height());
+            const int childStart = vertical ? childGeo.y() : childGeo.x();
+            if (!fillsOppositeSide || childStart != nextPos)
+                return false;
+
+            nextPos = (vertical ? childGeo.bottom() : childGeo.right()) + 1 + Item::separatorThickness;
+            hasVisibleChildren = true;
+        }
+
+        if (hasVisibleChildren && nextPos - Item::separatorThickness != containerEnd + 1)
+            return false;
+    }
+
+    return true;
+}
+
 const Item *ItemBoxContainer::Private::itemFromPath(const QVector<int> &path) const
 {
     const ItemBoxContainer *container = q;
@@ -3513,6 +3888,124 @@ void SizingInfo::fromVariantMap(const QVariantMap &map)
     maxSizeHint = mapToSize(map[QStringLiteral("maxSize")].toMap());
 }
 
+void SizingInfo::fromJsonStream(JsonStreamReader &reader)
+{
+    *this = SizingInfo();
+    if (!reader.beginObject())
+        return;
+
+    while (reader.nextKey()) {
+        switch (reader.keyHash()) {
+        case JsonStreamReader::hashKey("geometry"):
+            geometry = reader.readRect();
+            break;
+        case JsonStreamReader::hashKey("minSize"):
+            minSize = reader.readSize();
+            break;
+        case JsonStreamReader::hashKey("maxSize"):
+            maxSizeHint = reader.readSize();
+            break;
+        default:
+            reader.skipValue();
+        }
+    }
+}
+
+QVariantMap ItemRecord::toVariantMap() const
+{
+    QVariantMap result;
+    result[QStringLiteral("sizingInfo")] = sizingInfo.toVariantMap();
+    result[QStringLiteral("isVisible")] = isVisible;
+    result[QStringLiteral("isContainer")] = isContainer;
+    result[QStringLiteral("objectName")] = objectName;
+    if (!guestId.isEmpty())
+        result[QStringLiteral("guestId")] = guestId;
+
+    if (isContainer) {
+        QVariantList childrenV;
+        childrenV.reserve(children.size());
+        for (const ItemRecord &child : children)
+            childrenV.push_back(child.toVariantMap());
+
+        result[QStringLiteral("children")] = childrenV;
+        result[QStringLiteral("orientation")] = orientation;
+    }
+
+    return result;
+}
+
+bool ItemRecord::operator==(const ItemRecord &other) const
+{
+    return isNull == other.isNull && isVisible == other.isVisible
+        && isContainer == other.isContainer && orientation == other.orientation
+        && sizingInfo.geometry == other.sizingInfo.geometry
+        && sizingInfo.minSize == other.sizingInfo.minSize
+        && sizingInfo.maxSizeHint == other.sizingInfo.maxSizeHint
+        && guestId == other.guestId && objectName == other.objectName
+        && children == other.children;
+}
+
+void ItemRecord::fromVariantMap(const QVariantMap &map)
+{
+    *this = ItemRecord();
+    if (map.isEmpty())
+        return;
+
+    isNull = false;
+    sizingInfo.fromVariantMap(map[QStringLiteral("sizingInfo")].toMap());
+    isVisible = map[QStringLiteral("isVisible")].toBool();
+    isContainer = map.value(QStringLiteral("isContainer")).toBool();
+    objectName = map[QStringLiteral("objectName")].toString();
+    guestId = map.value(QStringLiteral("guestId")).toString();
+    orientation = Qt::Orientation(map.value(QStringLiteral("orientation"), Qt::Vertical).toInt());
+
+    const QVariantList childrenV = map[QStringLiteral("children")].toList();
+    children.resize(childrenV.size());
+    for (int i = 0; i < children.size(); ++i)
+        children[i].fromVariantMap(childrenV.at(i).toMap());
+}
+
+void ItemRecord::fromJsonStream(JsonStreamReader &reader)
+{
+    *this = ItemRecord();
+    if (!reader.beginObject())
+        return;
+
+    while (reader.nextKey()) {
+        isNull = false;
+        switch (reader.keyHash()) {
+        case JsonStreamReader::hashKey("sizingInfo"):
+            sizingInfo.fromJsonStream(reader);
+            break;
+        case JsonStreamReader::hashKey("isVisible"):
+            isVisible = reader.readBool();
+            break;
+        case JsonStreamReader::hashKey("isContainer"):
+            isContainer = reader.readBool();
+            break;
+        case JsonStreamReader::hashKey("objectName"):
+            objectName = reader.readString();
+            break;
+        case JsonStreamReader::hashKey("guestId"):
+            guestId = reader.readString();
+            break;
+        case JsonStreamReader::hashKey("orientation"):
+            orientation = Qt::Orientation(reader.readInt(Qt::Vertical));
+            break;
+        case JsonStreamReader::hashKey("children"):
+            if (reader.beginArray()) {
+                while (reader.nextElement()) {
+                    children.push_back(ItemRecord());
+                    children.last().fromJsonStream(reader);
+                }
+            }
+            break;
+        default:
+            reader.skipValue();
+        }
+    }
+}
+
 int ItemBoxContainer::Private::defaultLengthFor(Item *item, InitialOption option) const
 {
     int result = 0;
@@ -3554,25 +4047,89 @@ struct ItemContainer::Private
 
     ~Private()
     {
+        if (m_geometryObserver)
+            --s_numGeometryObservers;
     }
+
     ItemContainer *const q;
+    ItemGeometryObserver *m_geometryObserver = nullptr;
+    int m_geometryTransactionLevel = 0;
+    QVector<QPointer<Item>> m_pendingGeometryChanges;
 };
 
+ItemGeometryObserver::~ItemGeometryObserver() = default;
+
+ItemContainer *ItemContainer::observedRoot(Item *item)
+{
+    Item *top = item;
+    while (top->m_parent)
+        top = top->m_parent;
+
+    if (!top->m_isContainer)
+        return nullptr;
+
+    auto root = static_cast<ItemContainer *>(top);
+    return root->d->m_geometryObserver ? root : nullptr;
+}
+
+void ItemContainer::flushGeometryChanges()
+{
+    if (d->m_pendingGeometryChanges.isEmpty())
+        return;
+
+    Item::List items;
+    items.reserve(d->m_pendingGeometryChanges.size());
+    for (const QPointer<Item> &item : qAsConst(d->m_pendingGeometryChanges)) {
+        if (item) {
+            item->m_geometryChangePending = false;
+            items.push_back(item.data());
+        }
+    }
+    d->m_pendingGeometryChanges.clear();
+
+    if (d->m_geometryObserver && !items.isEmpty())
+        d->m_geometryObserver->itemGeometriesChanged(items);
+}
+
+void Item::notifyGeometryObserver()
+{
+    ItemContainer *root = ItemContainer::observedRoot(this);
+    if (!root)
+        return;
+
+    ItemContainer::Private *rootD = root->d;
+    if (rootD->m_geometryTransactionLevel == 0) {
+        rootD->m_geometryObserver->itemGeometriesChanged({ this });
+    } else if (!m_geometryChangePending) {
+        m_geometryChangePending = true;
+        rootD->m_pendingGeometryChanges.push_back(this);
+    }
+}
+
+ItemContainer::GeometryTransaction::GeometryTransaction(Item *item)
+{
+    if (s_numGeometryObservers == 0 || !item)
+        return;
+
+    m_root = ItemContainer::observedRoot(item);
+    if (m_root)
+        m_root->d->m_geometryTransactionLevel++;
+}
+
+ItemContainer::GeometryTransaction::~GeometryTransaction()
+{
+    if (!m_root)
+        return;
+
+    m_root->d->m_geometryTransactionLevel--;
+    if (m_root->d->m_geometryTransactionLevel == 0)
+        m_root->flushGeometryChanges();
+}
+
 ItemContainer::ItemContainer(Widget *hostWidget, ItemContainer *parent)
     : Item(true, hostWidget, parent)
     , d(new Private(this))
 {
-    connect(this, &Item::xChanged, this, [this] {
-        for (Item *item : qAsConst(m_children)) {
-            Q_EMIT item->xChanged();
-        }
-    });
-
-    connect(this, &Item::yChanged, this, [this] {
-        for (Item *item : qAsConst(m_children)) {
-            Q_EMIT item->yChanged();
-        }
-    });
 }
 
 ItemContainer::ItemContainer(Widget *hostWidget)
@@ -3586,6 +4143,39 @@ ItemContainer::~ItemContainer()
     delete d;
 }
 
+void ItemContainer::applySkippedGuestGeometries()
+{
+    QScopedValueRollback<int> tolerance(Item::guestGeometryTolerance, 0);
+    const Item::List items = items_recursive();
+    for (Item *item : items) {
+        if (item->m_guestGeometrySkipped)
+            item->updateWidgetGeometries();
+    }
+}
+
+void ItemContainer::setGeometryObserver(ItemGeometryObserver *observer)
+{
+    if (observer == d->m_geometryObserver)
+        return;
+
+    if (observer && !isRoot()) {
+        qWarning() << Q_FUNC_INFO << "Geometry observers are only supported on root containers";
+        return;
+    }
+
+    if (d->m_geometryObserver)
+        --s_numGeometryObservers;
+    if (observer)
+        ++s_numGeometryObservers;
+
+    d->m_geometryObserver = observer;
+}
+
+ItemGeometryObserver *ItemContainer::geometryObserver() const
+{
+    return d->m_geometryObserver;
+}
+
 const Item::List ItemContainer::childItems() const
 {
     return m_children;
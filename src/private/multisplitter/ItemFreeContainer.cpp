@@ -10,21 +10,94 @@
 */
 
 #include "ItemFreeContainer_p.h"
+#include "Widget.h"
+
+#include <QHash>
+
+#include <algorithm>
 
 using namespace Layouting;
 
+namespace {
+/// Side of each square cell of the hit-testing grid, in pixels
+const int s_gridCellSize = 256;
+
+inline quint64 cellKey(int column, int row)
+{
+    return (quint64(quint32(column)) << 32) | quint32(row);
+}
+
+/// Returns the grid column or row of @p coordinate. Rounds down, as children can be at negative positions.
+inline int cellIndex(int coordinate)
+{
+    return coordinate >= 0 ? coordinate / s_gridCellSize
+                           : -((-coordinate - 1) / s_gridCellSize) - 1;
+}
+}
+
+struct ItemFreeContainer::Private
+{
+    explicit Private(ItemFreeContainer *qq)
+        : q(qq)
+    {
+    }
+
+    void updateGrid() const;
+    quint64 zOf(const Item *item) const
+    {
+        return m_zOrder.value(item);
+    }
+
+    ItemFreeContainer *const q;
+
+    // Raising just hands out a new, bigger stamp. The order is only sorted when actually needed.
+    QHash<const Item *, quint64> m_zOrder;
+    quint64 m_nextZ = 0;
+
+    // Visible children bucketed by the grid cells their geometry intersects
+    mutable QHash<quint64, Item::List> m_grid;
+    mutable quint64 m_gridGeneration = 0;
+};
+
+void ItemFreeContainer::Private::updateGrid() const
+{
+    if (m_gridGeneration == Item::layoutGeneration())
+        return;
+
+    m_gridGeneration = Item::layoutGeneration();
+    m_grid.clear();
+
+    for (Item *item : qAsConst(q->m_children)) {
+        const QRect geo = item->geometry();
+        if (!item->isVisible() || geo.isEmpty())
+            continue;
+
+        const int firstColumn = cellIndex(geo.left());
+        const int lastColumn = cellIndex(geo.right());
+        const int firstRow = cellIndex(geo.top());
+        const int lastRow = cellIndex(geo.bottom());
+        for (int column = firstColumn; column <= lastColumn; ++column) {
+            for (int row = firstRow; row <= lastRow; ++row)
+                m_grid[cellKey(column, row)].push_back(item);
+        }
+    }
+}
+
 ItemFreeContainer::ItemFreeContainer(Widget *hostWidget, ItemContainer *parent)
     : ItemContainer(hostWidget, parent)
+    , d(new Private(this))
 {
 }
 
 ItemFreeContainer::ItemFreeContainer(Widget *hostWidget)
     : ItemContainer(hostWidget)
+    , d(new Private(this))
 {
 }
 
 ItemFreeContainer::~ItemFreeContainer()
 {
+    delete d;
 }
 
 void ItemFreeContainer::addDockWidget(Item *item, QPoint localPt)
@@ -37,6 +110,7 @@ void ItemFreeContainer::addDockWidget(Item *item, QPoint localPt)
     item->setIsVisible(true); // TODO: Use OptionStartHidden here too
 
     m_children.append(item);
+    d->m_zOrder.insert(item, ++d->m_nextZ);
     item->setParentContainer(this);
     item->setPos(localPt);
 
@@ -48,10 +122,63 @@ void ItemFreeContainer::addDockWidget(Item *item, QPoint localPt)
     Q_EMIT numItemsChanged();
 }
 
+void ItemFreeContainer::raiseItem(Item *item)
+{
+    if (!contains(item)) {
+        qWarning() << Q_FUNC_INFO << "Unknown item" << item;
+        return;
+    }
+
+    d->m_zOrder.insert(item, ++d->m_nextZ);
+}
+
+Item::List ItemFreeContainer::itemsInZOrder() const
+{
+    Item::List items = m_children;
+    std::sort(items.begin(), items.end(), [this](const Item *a, const Item *b) {
+        return d->zOf(a) < d->zOf(b);
+    });
+
+    return items;
+}
+
+Item *ItemFreeContainer::itemAt(QPoint localPt, int margin) const
+{
+    d->updateGrid();
+
+    // With a margin, children near localPt can be in the neighbouring cells too
+    const QMargins margins(margin, margin, margin, margin);
+    const int firstColumn = cellIndex(localPt.x() - margin);
+    const int lastColumn = cellIndex(localPt.x() + margin);
+    const int firstRow = cellIndex(localPt.y() - margin);
+    const int lastRow = cellIndex(localPt.y() + margin);
+
+    Item *result = nullptr;
+    quint64 resultZ = 0;
+    for (int column = firstColumn; column <= lastColumn; ++column) {
+        for (int row = firstRow; row <= lastRow; ++row) {
+            auto it = d->m_grid.constFind(cellKey(column, row));
+            if (it == d->m_grid.cend())
+                continue;
+
+            for (Item *item : it.value()) {
+                const quint64 z = d->zOf(item);
+                if ((!result || z > resultZ) && item->geometry().marginsAdded(margins).contains(localPt)) {
+                    result = item;
+                    resultZ = z;
+                }
+            }
+        }
+    }
+
+    return result;
+}
+
 void ItemFreeContainer::clear()
 {
     qDeleteAll(m_children);
     m_children.clear();
+    d->m_zOrder.clear();
 }
 
 void ItemFreeContainer::removeItem(Item *item, bool hardRemove)
@@ -60,6 +187,7 @@ void ItemFreeContainer::removeItem(Item *item, bool hardRemove)
 
     if (hardRemove) {
         m_children.removeOne(item);
+        d->m_zOrder.remove(item);
         delete item;
     } else {
         item->setIsVisible(false);
@@ -86,3 +214,43 @@ void ItemFreeContainer::onChildVisibleChanged(Item *, bool)
 {
     // Nothing needed to do in this layout type
 }
+
+ItemRecord ItemFreeContainer::toRecord() const
+{
+    ItemRecord record = Item::toRecord();
+
+    const Item::List children = itemsInZOrder();
+    record.children.reserve(children.size());
+    for (Item *child : children)
+        record.children.push_back(child->toRecord());
+
+    return record;
+}
+
+void ItemFreeContainer::fillFromRecord(const ItemRecord &record,
+                                       const QHash<QString, Widget *> &widgets)
+{
+    Item::fillFromRecord(record, widgets);
+
+    // Children come bottom to top. Since each guest is reparented in that order, the widgets
+    // end up stacked correctly as well.
+    for (const ItemRecord &childRecord : record.children) {
+        auto child = new Item(hostWidget(), this);
+        child->fillFromRecord(childRecord, widgets);
+        m_children.push_back(child);
+        d->m_zOrder.insert(child, ++d->m_nextZ);
+
+        if (child->isVisible()) {
+            if (Widget *guest = child->guestWidget()) {
+                guest->setGeometry(child->geometry());
+                guest->setVisible(true);
+            }
+        }
+    }
+
+    if (!record.children.isEmpty()) {
+        Q_EMIT itemsChanged();
+        Q_EMIT numVisibleItemsChanged(numVisibleChildren());
+        Q_EMIT numItemsChanged();
+    }
+}
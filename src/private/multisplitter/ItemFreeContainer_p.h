@@ -35,13 +35,34 @@ public:
     ~ItemFreeContainer();
 
     /// @brief adds the item to the specified position
+    /// The item goes on top of the z-order.
     void addDockWidget(Item *item, QPoint localPt);
 
+    /// @brief Puts @p item on top of the z-order. O(1).
+    /// Note that this only updates the model, stacking the guest widget is up to the caller.
+    void raiseItem(Item *item);
+
+    /// @brief Returns the children sorted by z-order, from bottom to top
+    Item::List itemsInZOrder() const;
+
+    /// @brief Returns the topmost visible child containing @p localPt, or nullptr
+    /// Children are grown by @p margin on each side first, which should be at most a few pixels.
+    /// Uses a grid of the children's geometries, rebuilt lazily when the layout changes.
+    Item *itemAt(QPoint localPt, int margin = 0) const;
+
     void clear() override;
     void removeItem(Item *, bool hardRemove = true) override;
     void restore(Item *child) override;
     void onChildMinSizeChanged(Item *child) override;
     void onChildVisibleChanged(Item *child, bool visible) override;
+
+    /// Children are saved in z-order, so restoring stacks them without raising each one
+    ItemRecord toRecord() const override;
+    void fillFromRecord(const ItemRecord &record, const QHash<QString, Widget *> &widgets) override;
+
+private:
+    struct Private;
+    Private *const d;
 };
 
 }
@@ -15,6 +15,7 @@
 #include "kddockwidgets/KDDockWidgets.h"
 
 #include <QObject>
+#include <QPointer>
 #include <QVector>
 #include <QRect>
 #include <QVariant>
@@ -30,6 +31,8 @@ Q_NAMESPACE
 class ItemContainer;
 class ItemBoxContainer;
 class Item;
+class FlatItemTree;
+class JsonStreamReader;
 class Separator;
 class Widget;
 struct LengthOnSide;
@@ -123,7 +126,7 @@ inline QRect mapToRect(const QVariantMap &map)
                  map.value(QStringLiteral("height")).toInt());
 }
 
-struct SizingInfo
+struct DOCKS_EXPORT_FOR_UNIT_TESTS SizingInfo
 {
 
     SizingInfo();
@@ -230,6 +233,7 @@ struct SizingInfo
 
     QVariantMap toVariantMap() const;
     void fromVariantMap(const QVariantMap &);
+    void fromJsonStream(JsonStreamReader &);
 
     typedef QVector<SizingInfo> List;
     QRect geometry;
@@ -239,6 +243,50 @@ struct SizingInfo
     bool isBeingInserted = false;
 };
 
+/**
+ * @brief The serialized state of an Item and, for containers, of its children
+ *
+ * Items are built from records, so the layout can be deserialized from a QVariantMap or directly
+ * from a JSON stream, without going through an intermediate QVariantMap.
+ */
+struct DOCKS_EXPORT_FOR_UNIT_TESTS ItemRecord
+{
+    typedef QVector<ItemRecord> List;
+
+    QVariantMap toVariantMap() const;
+    void fromVariantMap(const QVariantMap &);
+    void fromJsonStream(JsonStreamReader &);
+
+    ///@brief Compares what's serialized, so only the geometry and sizes of the sizing info
+    bool operator==(const ItemRecord &) const;
+
+    SizingInfo sizingInfo;
+    QString objectName;
+    QString guestId;
+    List children;
+    Qt::Orientation orientation = Qt::Vertical;
+    bool isVisible = false;
+    bool isContainer = false;
+    bool isNull = true; ///< true if nothing was read
+};
+
+/**
+ * @brief Observer for Item geometry changes which doesn't go through Qt signals
+ *
+ * Install it on a root container via ItemContainer::setGeometryObserver(). Geometry changes made
+ * inside an ItemContainer::GeometryTransaction are delivered in one call, when the outermost
+ * transaction ends. Changes made outside of a transaction are delivered immediately.
+ */
+class DOCKS_EXPORT_FOR_UNIT_TESTS ItemGeometryObserver
+{
+public:
+    virtual ~ItemGeometryObserver();
+
+    ///@brief Called with the items whose geometry changed. Each item is listed once, in the order
+    /// it first changed. Items deleted meanwhile aren't included.
+    virtual void itemGeometriesChanged(const QVector<Item *> &items) = 0;
+};
+
 class DOCKS_EXPORT_FOR_UNIT_TESTS Item : public QObject
 {
     Q_OBJECT
@@ -270,6 +318,11 @@ public:
     static QSize hardcodedMaximumSize;
     static int separatorThickness;
 
+    ///@brief Guest widgets whose geometry would move by less than this many pixels on every edge
+    /// aren't updated. 0 by default. For intermediate passes of coalesced resizes, which must be
+    /// followed by ItemContainer::applySkippedGuestGeometries().
+    static int guestGeometryTolerance;
+
     int x() const;
     int y() const;
     int width() const;
@@ -327,12 +380,22 @@ public:
     virtual void setGeometry_recursive(QRect rect);
     virtual void dumpLayout(int level = 0);
     virtual void setHostWidget(Widget *);
-    virtual QVariantMap toVariantMap() const;
-    virtual void fillFromVariantMap(const QVariantMap &map, const QHash<QString, Widget *> &widgets);
+    virtual ItemRecord toRecord() const;
+    virtual void fillFromRecord(const ItemRecord &record, const QHash<QString, Widget *> &widgets);
+    QVariantMap toVariantMap() const;
+    void fillFromVariantMap(const QVariantMap &map, const QHash<QString, Widget *> &widgets);
 
     static Item *createFromVariantMap(Widget *hostWidget, ItemContainer *parent,
                                       const QVariantMap &map, const QHash<QString, Widget *> &widgets);
 
+    ///@brief Returns a counter that is bumped whenever any item's geometry, visibility or parent
+    /// changes, or when children are added/removed. Allows to cache results derived from layouts.
+    static quint64 layoutGeneration();
+
+    ///@brief Like layoutGeneration(), but not bumped by geometry changes. Only by what can change
+    /// min and max sizes: size constraints, visibility, parent, orientation and children.
+    static quint64 constraintsGeneration();
+
 Q_SIGNALS:
     void geometryChanged();
     void xChanged();
@@ -374,9 +437,15 @@ private:
     friend class ItemContainer;
     friend class ItemBoxContainer;
     friend class ItemFreeContainer;
+    friend class FlatItemTree;
     void turnIntoPlaceholder();
     bool eventFilter(QObject *o, QEvent *event) override;
+    bool shouldEmitGeometrySignal(const QMetaMethod &signal) const;
+    void emitPositionChanged(bool xDidChange, bool yDidChange);
+    void notifyGeometryObserver();
     int m_refCount = 0;
+    bool m_geometryChangePending = false;
+    bool m_guestGeometrySkipped = false;
     void updateObjectName();
     void onWidgetDestroyed();
     bool m_isVisible = false;
@@ -414,6 +483,25 @@ public:
     int count_recursive() const;
     virtual void clear() = 0;
 
+    ///@brief Applies the guest geometries skipped due to Item::guestGeometryTolerance
+    void applySkippedGuestGeometries();
+
+    ///@brief Sets the observer to notify when the geometry of this container or any of its
+    /// descendants changes. Only honoured on root containers. Doesn't take ownership.
+    void setGeometryObserver(ItemGeometryObserver *);
+    ItemGeometryObserver *geometryObserver() const;
+
+    ///@brief RAII helper which batches ItemGeometryObserver notifications until the outermost
+    /// transaction on the same root ends. A no-op if no observer is installed.
+    struct DOCKS_EXPORT_FOR_UNIT_TESTS GeometryTransaction
+    {
+        explicit GeometryTransaction(Item *item);
+        ~GeometryTransaction();
+        Q_DISABLE_COPY(GeometryTransaction)
+    private:
+        QPointer<ItemContainer> m_root;
+    };
+
 protected:
     bool hasSingleVisibleItem() const;
 
@@ -425,6 +513,9 @@ Q_SIGNALS:
     void numItemsChanged();
 
 private:
+    friend class Item;
+    static ItemContainer *observedRoot(Item *);
+    void flushGeometryChanges();
     struct Private;
     Private *const d;
 };
@@ -461,8 +552,8 @@ public:
     void dumpLayout(int level = 0) override;
     void setSize_recursive(QSize newSize, ChildrenResizeStrategy strategy = ChildrenResizeStrategy::Percentage) override;
     QRect suggestedDropRect(const Item *item, const Item *relativeTo, KDDockWidgets::Location) const;
-    QVariantMap toVariantMap() const override;
-    void fillFromVariantMap(const QVariantMap &map, const QHash<QString, Widget *> &widgets) override;
+    ItemRecord toRecord() const override;
+    void fillFromRecord(const ItemRecord &record, const QHash<QString, Widget *> &widgets) override;
     void clear() override;
     Qt::Orientation orientation() const;
     bool isVertical() const;
@@ -534,15 +625,16 @@ private:
     void onChildVisibleChanged(Item *child, bool visible) override;
     void updateSizeConstraints();
     SizingInfo::List sizes(bool ignoreBeingInserted = false) const;
-    QVector<int> calculateSqueezes(SizingInfo::List::ConstIterator begin,
-                                   SizingInfo::List::ConstIterator end, int needed,
-                                   NeighbourSqueezeStrategy, bool reversed = false) const;
+    ///@brief Calculates how much to squeeze each of the items in [begin, end) so they give @p needed.
+    /// Writes into @p squeezes, which must have room for one int per item.
+    void calculateSqueezes(SizingInfo::List::ConstIterator begin,
+                           SizingInfo::List::ConstIterator end, int needed,
+                           NeighbourSqueezeStrategy, int *squeezes, bool reversed = false) const;
     QRect suggestedDropRectFallback(const Item *item, const Item *relativeTo, KDDockWidgets::Location) const;
     void positionItems();
     void positionItems_recursive();
     void positionItems(SizingInfo::List &sizes);
     Item *itemAt(QPoint p) const;
-    Item *itemAt_recursive(QPoint p) const;
     void setHostWidget(Widget *) override;
     void setIsVisible(bool) override;
     bool isVisible(bool excludeBeingInserted = false) const override;
@@ -561,6 +653,18 @@ public:
     QVector<Layouting::Separator *> separators_recursive() const;
     QVector<Layouting::Separator *> separators() const;
 
+    ///@brief Returns the visible leaf item at @p p, which is in this container's coordinate space.
+    /// Descends into child containers. Each level is a binary search over the children.
+    Item *itemAt_recursive(QPoint p) const;
+
+    ///@brief Returns the separator at @p p, which is in this container's coordinate space.
+    /// Descends into child containers. Returns nullptr if there's no separator there.
+    Separator *separatorAt_recursive(QPoint p) const;
+
+    ///@brief Removes nesting which became redundant, for example a container left with a single child
+    /// after its other items were removed.
+    void removeEmptyContainers();
+
 private:
     void simplify();
     static bool s_inhibitSimplify;
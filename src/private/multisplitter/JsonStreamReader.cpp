@@ -0,0 +1,604 @@
+/*
+  This file is part of KDDockWidgets.
+
+  SPDX-FileCopyrightText: 2020-2022 Klarälvdalens Datakonsult AB, a KDAB Group company <info@kdab.com>
+  Author: Sérgio Martins <sergio.martins@kdab.com>
+
+  SPDX-License-Identifier: GPL-2.0-only OR GPL-3.0-only
+
+  Contact KDAB at <info@kdab.com> for commercial licensing options.
+*/
+
+#include "JsonStreamReader_p.h"
+
+#include <QtMath>
+
+#include <climits>
+#include <cstring>
+
+using namespace Layouting;
+
+static int hexValue(char c)
+{
+    if (c >= '0' && c <= '9')
+        return c - '0';
+    if (c >= 'a' && c <= 'f')
+        return c - 'a' + 10;
+    if (c >= 'A' && c <= 'F')
+        return c - 'A' + 10;
+    return -1;
+}
+
+/// Reads the 4 hex digits of a \uXXXX escape, @p p points to the first digit
+static int readCodeUnit(const char *p, const char *end)
+{
+    if (end - p < 4)
+        return -1;
+
+    int result = 0;
+    for (int i = 0; i < 4; ++i) {
+        const int digit = hexValue(p[i]);
+        if (digit == -1)
+            return -1;
+        result = (result << 4) | digit;
+    }
+
+    return result;
+}
+
+static void appendUtf8(QByteArray &out, uint codePoint)
+{
+    if (codePoint < 0x80) {
+        out.append(char(codePoint));
+    } else if (codePoint < 0x800) {
+        out.append(char(0xC0 | (codePoint >> 6)));
+        out.append(char(0x80 | (codePoint & 0x3F)));
+    } else if (codePoint < 0x10000) {
+        out.append(char(0xE0 | (codePoint >> 12)));
+        out.append(char(0x80 | ((codePoint >> 6) & 0x3F)));
+        out.append(char(0x80 | (codePoint & 0x3F)));
+    } else {
+        out.append(char(0xF0 | (codePoint >> 18)));
+        out.append(char(0x80 | ((codePoint >> 12) & 0x3F)));
+        out.append(char(0x80 | ((codePoint >> 6) & 0x3F)));
+        out.append(char(0x80 | (codePoint & 0x3F)));
+    }
+}
+
+/// Decodes the escape sequences of the string contents [begin, end) into UTF-8
+static bool decodeEscapes(const char *begin, const char *end, QByteArray &out)
+{
+    out.clear();
+    out.reserve(int(end - begin));
+
+    for (const char *p = begin; p < end; ++p) {
+        if (*p != '\\') {
+            out.append(*p);
+            continue;
+        }
+
+        if (++p == end)
+            return false;
+
+        switch (*p) {
+        case '"':
+        case '\\':
+        case '/':
+            out.append(*p);
+            break;
+        case 'b':
+            out.append('\b');
+            break;
+        case 'f':
+            out.append('\f');
+            break;
+        case 'n':
+            out.append('\n');
+            break;
+        case 'r':
+            out.append('\r');
+            break;
+        case 't':
+            out.append('\t');
+            break;
+        case 'u': {
+            const int unit = readCodeUnit(p + 1, end);
+            if (unit == -1)
+                return false;
+            p += 4;
+
+            uint codePoint = uint(unit);
+            if (unit >= 0xDC00 && unit <= 0xDFFF) {
+                return false; // lone low surrogate
+            } else if (unit >= 0xD800 && unit <= 0xDBFF) {
+                // High surrogate, must be followed by a low one
+                if (end - p < 7 || p[1] != '\\' || p[2] != 'u')
+                    return false;
+                const int low = readCodeUnit(p + 3, end);
+                if (low < 0xDC00 || low > 0xDFFF)
+                    return false;
+                p += 6;
+                codePoint = 0x10000 + ((uint(unit) - 0xD800) << 10) + (uint(low) - 0xDC00);
+            }
+
+            appendUtf8(out, codePoint);
+            break;
+        }
+        default:
+            return false;
+        }
+    }
+
+    return true;
+}
+
+static quint64 hashRange(const char *begin, const char *end)
+{
+    quint64 hash = JsonStreamReader::hashKey("");
+    for (const char *p = begin; p < end; ++p)
+        hash = (hash ^ quint8(*p)) * 1099511628211ULL;
+
+    return hash;
+}
+
+JsonStreamReader::JsonStreamReader(const QByteArray &data)
+    : m_data(data)
+    , m_pos(m_data.constData())
+    , m_end(m_data.constData() + m_data.size())
+{
+    // Skip the UTF-8 BOM, if any
+    if (m_end - m_pos >= 3 && std::memcmp(m_pos, "\xEF\xBB\xBF", 3) == 0)
+        m_pos += 3;
+}
+
+bool JsonStreamReader::beginObject()
+{
+    return beginScope('{', Scope::Object);
+}
+
+bool JsonStreamReader::nextKey()
+{
+    if (!nextInScope('}', Scope::Object))
+        return false;
+
+    if (m_pos == m_end || *m_pos != '"') {
+        setError("Expected a key");
+        return false;
+    }
+
+    if (!scanString(m_keyBegin, m_keyEnd, m_keyHasEscapes))
+        return false;
+
+    if (m_keyHasEscapes) {
+        if (!decodeEscapes(m_keyBegin, m_keyEnd, m_buffer)) {
+            setError("Invalid escape sequence");
+            return false;
+        }
+        m_keyHash = hashRange(m_buffer.constData(), m_buffer.constData() + m_buffer.size());
+    } else {
+        m_keyHash = hashRange(m_keyBegin, m_keyEnd);
+    }
+
+    skipWhitespace();
+    return expect(':');
+}
+
+QString JsonStreamReader::key() const
+{
+    if (!m_keyHasEscapes)
+        return QString::fromUtf8(m_keyBegin, int(m_keyEnd - m_keyBegin));
+
+    QByteArray decoded;
+    decodeEscapes(m_keyBegin, m_keyEnd, decoded);
+    return QString::fromUtf8(decoded);
+}
+
+bool JsonStreamReader::beginArray()
+{
+    return beginScope('[', Scope::Array);
+}
+
+bool JsonStreamReader::nextElement()
+{
+    return nextInScope(']', Scope::Array);
+}
+
+int JsonStreamReader::readInt(int defaultValue)
+{
+    skipWhitespace();
+    if (m_pos < m_end && (*m_pos == '-' || (*m_pos >= '0' && *m_pos <= '9'))) {
+        double value = 0;
+        bool isIntegral = false;
+        qint64 integralValue = 0;
+        if (!scanNumber(value, isIntegral, integralValue))
+            return defaultValue;
+
+        if (isIntegral)
+            return int(qBound(qint64(INT_MIN), integralValue, qint64(INT_MAX)));
+
+        return qRound(qBound(double(INT_MIN), value, double(INT_MAX)));
+    }
+
+    skipValue();
+    return defaultValue;
+}
+
+double JsonStreamReader::readDouble(double defaultValue)
+{
+    skipWhitespace();
+    if (m_pos < m_end && (*m_pos == '-' || (*m_pos >= '0' && *m_pos <= '9'))) {
+        double value = 0;
+        bool isIntegral = false;
+        qint64 integralValue = 0;
+        return scanNumber(value, isIntegral, integralValue) ? value : defaultValue;
+    }
+
+    skipValue();
+    return defaultValue;
+}
+
+bool JsonStreamReader::readBool(bool defaultValue)
+{
+    skipWhitespace();
+    if (m_pos < m_end) {
+        switch (*m_pos) {
+        case 't':
+            return scanLiteral("true") || defaultValue;
+        case 'f':
+            return scanLiteral("false") ? false : defaultValue;
+        case '-':
+        case '0':
+        case '1':
+        case '2':
+        case '3':
+        case '4':
+        case '5':
+        case '6':
+        case '7':
+        case '8':
+        case '9':
+            return !qFuzzyIsNull(readDouble());
+        default:
+            break;
+        }
+    }
+
+    skipValue();
+    return defaultValue;
+}
+
+QString JsonStreamReader::readString()
+{
+    skipWhitespace();
+    if (m_pos < m_end && *m_pos == '"') {
+        const char *begin = nullptr;
+        const char *end = nullptr;
+        bool hasEscapes = false;
+        if (!scanString(begin, end, hasEscapes))
+            return {};
+
+        if (!hasEscapes)
+            return QString::fromUtf8(begin, int(end - begin));
+
+        if (!decodeEscapes(begin, end, m_buffer)) {
+            setError("Invalid escape sequence");
+            return {};
+        }
+
+        return QString::fromUtf8(m_buffer);
+    }
+
+    skipValue();
+    return {};
+}
+
+QStringList JsonStreamReader::readStringList()
+{
+    QStringList result;
+    if (beginArray()) {
+        while (nextElement())
+            result.push_back(readString());
+    }
+
+    return result;
+}
+
+QRect JsonStreamReader::readRect()
+{
+    int x = 0;
+    int y = 0;
+    int width = 0;
+    int height = 0;
+
+    if (beginObject()) {
+        while (nextKey()) {
+            switch (m_keyHash) {
+            case hashKey("x"):
+                x = readInt();
+                break;
+            case hashKey("y"):
+                y = readInt();
+                break;
+            case hashKey("width"):
+                width = readInt();
+                break;
+            case hashKey("height"):
+                height = readInt();
+                break;
+            default:
+                skipValue();
+            }
+        }
+    }
+
+    return QRect(x, y, width, height);
+}
+
+QSize JsonStreamReader::readSize()
+{
+    int width = 0;
+    int height = 0;
+
+    if (beginObject()) {
+        while (nextKey()) {
+            switch (m_keyHash) {
+            case hashKey("width"):
+                width = readInt();
+                break;
+            case hashKey("height"):
+                height = readInt();
+                break;
+            default:
+                skipValue();
+            }
+        }
+    }
+
+    return QSize(width, height);
+}
+
+void JsonStreamReader::skipValue()
+{
+    skipWhitespace();
+    if (m_pos == m_end) {
+        setError("Unexpected end of input");
+        return;
+    }
+
+    const char *begin = nullptr;
+    const char *end = nullptr;
+    bool hasEscapes = false;
+
+    switch (*m_pos) {
+    case '{':
+    case '[': {
+        // Nested values aren't parsed, we only make sure the brackets match
+        QVarLengthArray<char, 32> closings;
+        while (m_pos < m_end) {
+            const char c = *m_pos;
+            if (c == '"') {
+                if (!scanString(begin, end, hasEscapes))
+                    return;
+                continue;
+            }
+
+            if (c == '{') {
+                closings.append('}');
+            } else if (c == '[') {
+                closings.append(']');
+            } else if (c == '}' || c == ']') {
+                if (closings.isEmpty() || closings.last() != c) {
+                    setError("Unbalanced brackets");
+                    return;
+                }
+                closings.removeLast();
+                if (closings.isEmpty()) {
+                    ++m_pos;
+                    return;
+                }
+            }
+            ++m_pos;
+        }
+        setError("Unexpected end of input");
+        return;
+    }
+    case '"':
+        scanString(begin, end, hasEscapes);
+        return;
+    case 't':
+        scanLiteral("true");
+        return;
+    case 'f':
+        scanLiteral("false");
+        return;
+    case 'n':
+        scanLiteral("null");
+        return;
+    default:
+        if (*m_pos == '-' || (*m_pos >= '0' && *m_pos <= '9')) {
+            double value = 0;
+            bool isIntegral = false;
+            qint64 integralValue = 0;
+            scanNumber(value, isIntegral, integralValue);
+        } else {
+            setError("Unexpected character");
+        }
+    }
+}
+
+bool JsonStreamReader::atEnd()
+{
+    if (hasError())
+        return false;
+
+    skipWhitespace();
+    return m_pos == m_end;
+}
+
+void JsonStreamReader::skipWhitespace()
+{
+    while (m_pos < m_end && (*m_pos == ' ' || *m_pos == '\n' || *m_pos == '\r' || *m_pos == '\t'))
+        ++m_pos;
+}
+
+bool JsonStreamReader::expect(char c)
+{
+    if (m_pos < m_end && *m_pos == c) {
+        ++m_pos;
+        return true;
+    }
+
+    setError(c == ':' ? "Expected ':'" : "Unexpected character");
+    return false;
+}
+
+bool JsonStreamReader::beginScope(char opening, Scope scope)
+{
+    skipWhitespace();
+    if (m_pos < m_end && *m_pos == opening) {
+        ++m_pos;
+        ScopeState state;
+        state.scope = scope;
+        state.hasElements = false;
+        m_scopes.append(state);
+        return true;
+    }
+
+    skipValue();
+    return false;
+}
+
+bool JsonStreamReader::nextInScope(char closing, Scope scope)
+{
+    if (hasError())
+        return false;
+
+    if (m_scopes.isEmpty() || m_scopes.last().scope != scope) {
+        setError("Unbalanced scopes");
+        return false;
+    }
+
+    skipWhitespace();
+    if (m_pos == m_end) {
+        setError("Unexpected end of input");
+        return false;
+    }
+
+    ScopeState &state = m_scopes.last();
+    if (*m_pos == closing) {
+        ++m_pos;
+        m_scopes.removeLast();
+        return false;
+    }
+
+    if (state.hasElements) {
+        if (*m_pos != ',') {
+            setError("Expected ','");
+            return false;
+        }
+        ++m_pos;
+        skipWhitespace();
+    }
+
+    state.hasElements = true;
+    return true;
+}
+
+bool JsonStreamReader::scanString(const char *&begin, const char *&end, bool &hasEscapes)
+{
+    ++m_pos; // opening quote
+    begin = m_pos;
+    hasEscapes = false;
+
+    while (m_pos < m_end) {
+        const char c = *m_pos;
+        if (c == '"') {
+            end = m_pos;
+            ++m_pos;
+            return true;
+        } else if (c == '\\') {
+            hasEscapes = true;
+            if (m_end - m_pos < 2)
+                break;
+            m_pos += 2;
+        } else if (quint8(c) < 0x20) {
+            setError("Control character in string");
+            return false;
+        } else {
+            ++m_pos;
+        }
+    }
+
+    setError("Unterminated string");
+    return false;
+}
+
+bool JsonStreamReader::scanNumber(double &value, bool &isIntegral, qint64 &integralValue)
+{
+    const char *start = m_pos;
+    const bool negative = *m_pos == '-';
+    if (negative)
+        ++m_pos;
+
+    // Integers are the common case, parse them without going through QByteArray::toDouble()
+    qint64 accumulated = 0;
+    int numDigits = 0;
+    while (m_pos < m_end && *m_pos >= '0' && *m_pos <= '9') {
+        if (numDigits < 18)
+            accumulated = accumulated * 10 + (*m_pos - '0');
+        ++numDigits;
+        ++m_pos;
+    }
+
+    if (numDigits == 0) {
+        setError("Invalid number");
+        return false;
+    }
+
+    isIntegral = numDigits <= 18;
+    while (m_pos < m_end && (*m_pos == '.' || *m_pos == 'e' || *m_pos == 'E' || *m_pos == '+' || *m_pos == '-' || (*m_pos >= '0' && *m_pos <= '9'))) {
+        isIntegral = false;
+        ++m_pos;
+    }
+
+    if (isIntegral) {
+        integralValue = negative ? -accumulated : accumulated;
+        value = double(integralValue);
+        return true;
+    }
+
+    bool ok = false;
+    value = QByteArray::fromRawData(start, int(m_pos - start)).toDouble(&ok);
+    if (!ok) {
+        setError("Invalid number");
+        return false;
+    }
+
+    return true;
+}
+
+bool JsonStreamReader::scanLiteral(const char *literal)
+{
+    const auto length = std::strlen(literal);
+    if (size_t(m_end - m_pos) >= length && std::memcmp(m_pos, literal, length) == 0) {
+        m_pos += length;
+        return true;
+    }
+
+    setError("Invalid literal");
+    return false;
+}
+
+void JsonStreamReader::setError(const char *message)
+{
+    if (hasError())
+        return;
+
+    m_errorString = QStringLiteral("%1 at offset %2")
+                        .arg(QLatin1String(message))
+                        .arg(qlonglong(m_pos - m_data.constData()));
+
+    // Nothing else will be read
+    m_pos = m_end;
+    m_scopes.clear();
+}
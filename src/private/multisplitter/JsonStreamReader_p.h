@@ -0,0 +1,159 @@
+/*
+  This file is part of KDDockWidgets.
+
+  SPDX-FileCopyrightText: 2020-2022 Klarälvdalens Datakonsult AB, a KDAB Group company <info@kdab.com>
+  Author: Sérgio Martins <sergio.martins@kdab.com>
+
+  SPDX-License-Identifier: GPL-2.0-only OR GPL-3.0-only
+
+  Contact KDAB at <info@kdab.com> for commercial licensing options.
+*/
+
+#pragma once
+
+#include "kddockwidgets/docks_export.h"
+
+#include <QByteArray>
+#include <QRect>
+#include <QSize>
+#include <QString>
+#include <QStringList>
+#include <QVarLengthArray>
+
+namespace Layouting {
+
+/**
+ * @brief A forward-only JSON pull parser.
+ *
+ * Reads directly from the UTF-8 input, without building a QJsonDocument or QVariantMap first, so
+ * deserializers can fill their structs in a single pass.
+ *
+ * Object keys are hashed as they're read. Callers switch on keyHash() using case labels
+ * computed at compile time with hashKey(), so no QString is created for keys:
+ *
+ * @code
+ * if (reader.beginObject()) {
+ *     while (reader.nextKey()) {
+ *         switch (reader.keyHash()) {
+ *         case JsonStreamReader::hashKey("width"):
+ *             width = reader.readInt();
+ *             break;
+ *         default:
+ *             reader.skipValue();
+ *         }
+ *     }
+ * }
+ * @endcode
+ *
+ * After nextKey() or nextElement() return true, exactly one value must be consumed, with one of
+ * the read functions, beginObject(), beginArray() or skipValue().
+ *
+ * Errors are sticky: after a syntax error every function returns false or a default value, and
+ * hasError() returns true. Values which are skipped are only checked for balanced brackets.
+ */
+class DOCKS_EXPORT_FOR_UNIT_TESTS JsonStreamReader
+{
+public:
+    explicit JsonStreamReader(const QByteArray &data);
+
+    ///@brief Returns the 64-bit FNV-1a hash of @p key. constexpr, so it can be used in case labels
+    static constexpr quint64 hashKey(const char *key, quint64 hash = 14695981039346656037ULL)
+    {
+        return *key ? hashKey(key + 1, (hash ^ quint8(*key)) * 1099511628211ULL) : hash;
+    }
+
+    ///@brief Enters the object at the current position
+    /// Returns false, and skips the value, if it's not an object.
+    bool beginObject();
+
+    ///@brief Reads the next key of the current object
+    /// Returns false once the object ends, or on error.
+    bool nextKey();
+
+    ///@brief Returns the hash of the key read by the last nextKey()
+    quint64 keyHash() const
+    {
+        return m_keyHash;
+    }
+
+    ///@brief Returns the key read by the last nextKey()
+    /// Only needed for objects keyed by arbitrary strings, known keys should use keyHash()
+    QString key() const;
+
+    ///@brief Enters the array at the current position
+    /// Returns false, and skips the value, if it's not an array.
+    bool beginArray();
+
+    ///@brief Returns true if the current array has another element, false once it ends
+    bool nextElement();
+
+    ///@brief Reads a number, rounding it if it's not integral
+    /// Returns @p defaultValue if the value isn't a number.
+    int readInt(int defaultValue = 0);
+    double readDouble(double defaultValue = 0);
+
+    ///@brief Reads a boolean. Numbers are accepted too, like QVariant::toBool() does.
+    bool readBool(bool defaultValue = false);
+
+    ///@brief Reads a string. Returns a null string if the value isn't a string.
+    QString readString();
+
+    ///@brief Reads an array of strings
+    QStringList readStringList();
+
+    ///@brief Reads a rect, in the format written by Layouting::rectToMap()
+    QRect readRect();
+
+    ///@brief Reads a size, in the format written by Layouting::sizeToMap()
+    QSize readSize();
+
+    ///@brief Skips the value at the current position, whatever its type
+    void skipValue();
+
+    ///@brief Returns true if only whitespace is left in the input
+    bool atEnd();
+
+    bool hasError() const
+    {
+        return !m_errorString.isEmpty();
+    }
+
+    QString errorString() const
+    {
+        return m_errorString;
+    }
+
+private:
+    enum class Scope : quint8 {
+        Object,
+        Array
+    };
+
+    struct ScopeState
+    {
+        Scope scope;
+        bool hasElements;
+    };
+
+    void skipWhitespace();
+    bool expect(char c);
+    bool beginScope(char opening, Scope scope);
+    bool nextInScope(char closing, Scope scope);
+    bool scanString(const char *&begin, const char *&end, bool &hasEscapes);
+    bool scanNumber(double &value, bool &isIntegral, qint64 &integralValue);
+    bool scanLiteral(const char *literal);
+    void setError(const char *message);
+
+    const QByteArray m_data;
+    const char *m_pos = nullptr;
+    const char *m_end = nullptr;
+    QVarLengthArray<ScopeState, 16> m_scopes;
+    quint64 m_keyHash = 0;
+    const char *m_keyBegin = nullptr;
+    const char *m_keyEnd = nullptr;
+    bool m_keyHasEscapes = false;
+    QByteArray m_buffer; // reused for strings with escapes, to avoid allocations
+    QString m_errorString;
+};
+
+}
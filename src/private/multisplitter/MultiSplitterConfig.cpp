@@ -97,4 +97,14 @@ void Config::setFlags(Flags flags)
     m_flags = flags;
 }
 
+Config::GeometrySignals Config::geometrySignals() const
+{
+    return m_geometrySignals;
+}
+
+void Config::setGeometrySignals(GeometrySignals mode)
+{
+    m_geometrySignals = mode;
+}
+
 }
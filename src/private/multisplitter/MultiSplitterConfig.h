@@ -31,6 +31,13 @@ public:
     };
     Q_DECLARE_FLAGS(Flags, Flag);
 
+    ///@brief Controls when Item emits its per-property geometry signals (xChanged() etc.)
+    enum class GeometrySignals {
+        Always, ///< Always emit them
+        WhenConnected, ///< Only emit them when something is connected. The default.
+        QtQuickOnly ///< Only emit them in QtQuick builds, where QML binds to them
+    };
+
     ///@brief returns the singleton Config instance
     static Config &self();
 
@@ -60,6 +67,13 @@ public:
     ///@brief sets the flags. Set only before creating any Item
     void setFlags(Flags);
 
+    ///@brief returns when Item emits its geometry signals. Default is GeometrySignals::WhenConnected.
+    /// ItemGeometryObserver is notified regardless.
+    GeometrySignals geometrySignals() const;
+
+    ///@brief setter for @ref geometrySignals
+    void setGeometrySignals(GeometrySignals);
+
 private:
     friend class Item;
     friend class ItemBoxContainer;
@@ -71,6 +85,7 @@ private:
 
     SeparatorFactoryFunc m_separatorFactoryFunc = nullptr;
     Flags m_flags = Flag::None;
+    GeometrySignals m_geometrySignals = GeometrySignals::WhenConnected;
 
     Q_DISABLE_COPY(Config);
 };
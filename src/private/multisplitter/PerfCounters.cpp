@@ -0,0 +1,67 @@
+/*
+  This file is part of KDDockWidgets.
+
+  SPDX-FileCopyrightText: 2020-2022 Klarälvdalens Datakonsult AB, a KDAB Group company <info@kdab.com>
+  Author: Sérgio Martins <sergio.martins@kdab.com>
+
+  SPDX-License-Identifier: GPL-2.0-only OR GPL-3.0-only
+
+  Contact KDAB at <info@kdab.com> for commercial licensing options.
+*/
+
+#include "PerfCounters_p.h"
+
+using namespace Layouting;
+
+quint64 PerfCounters::s_values[PerfCounters::Counter_Count] = {};
+
+quint64 PerfCounters::value(Counter counter)
+{
+    return s_values[counter];
+}
+
+const char *PerfCounters::name(Counter counter)
+{
+    switch (counter) {
+    case Counter_LayoutPasses:
+        return "Layout passes";
+    case Counter_ItemSetGeometry:
+        return "Item::setGeometry";
+    case Counter_WidgetGeometryApplied:
+        return "Widget geometries applied";
+    case Counter_SeparatorsCreated:
+        return "Separators created";
+    case Counter_SeparatorsDestroyed:
+        return "Separators destroyed";
+    case Counter_FramesCreated:
+        return "Frames created";
+    case Counter_FramesDestroyed:
+        return "Frames destroyed";
+    case Counter_EventFilterInvocations:
+        return "Event filter invocations";
+    case Counter_Restores:
+        return "Layout restores";
+    case Counter_RestoreMSecs:
+        return "Restore duration (ms)";
+    case Counter_PlaceholdersPruned:
+        return "Placeholders pruned";
+    case Counter_TitleBarVisibilityUpdates:
+        return "Title bar visibility updates";
+    case Counter_GuestsHibernated:
+        return "Guests hibernated";
+    case Counter_GuestsWokenUp:
+        return "Guests woken up";
+    case Counter_FastPathRestores:
+        return "Fast path restores";
+    case Counter_Count:
+        break;
+    }
+
+    return "";
+}
+
+void PerfCounters::reset()
+{
+    for (quint64 &value : s_values)
+        value = 0;
+}
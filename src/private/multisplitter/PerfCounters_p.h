@@ -0,0 +1,66 @@
+/*
+  This file is part of KDDockWidgets.
+
+  SPDX-FileCopyrightText: 2020-2022 Klarälvdalens Datakonsult AB, a KDAB Group company <info@kdab.com>
+  Author: Sérgio Martins <sergio.martins@kdab.com>
+
+  SPDX-License-Identifier: GPL-2.0-only OR GPL-3.0-only
+
+  Contact KDAB at <info@kdab.com> for commercial licensing options.
+*/
+
+#pragma once
+
+#include "kddockwidgets/docks_export.h"
+
+#include <qglobal.h>
+
+namespace Layouting {
+
+/**
+ * @brief Process-wide counters used to diagnose layouting cost without a profiler.
+ *
+ * Incrementing is a plain integer add, so it's always enabled. Counters are only touched from the
+ * GUI thread. See the counters panel in DebugWindow.
+ */
+class DOCKS_EXPORT_FOR_UNIT_TESTS PerfCounters
+{
+public:
+    enum Counter {
+        Counter_LayoutPasses = 0, ///< ItemBoxContainer::positionItems() calls
+        Counter_ItemSetGeometry, ///< Item::setGeometry() calls which changed the geometry
+        Counter_WidgetGeometryApplied, ///< Geometries applied to the guest widgets
+        Counter_SeparatorsCreated,
+        Counter_SeparatorsDestroyed,
+        Counter_FramesCreated,
+        Counter_FramesDestroyed,
+        Counter_EventFilterInvocations, ///< Invocations of our application wide event filters
+        Counter_Restores, ///< Calls to LayoutSaver::restoreLayout()
+        Counter_RestoreMSecs, ///< Total time spent in LayoutSaver::restoreLayout()
+        Counter_PlaceholdersPruned, ///< Placeholders removed by DockRegistry::compactPlaceholders()
+        Counter_TitleBarVisibilityUpdates, ///< Frame::updateTitleBarVisibility() calls
+        Counter_GuestsHibernated, ///< Guest widgets deleted by DockRegistry::hibernateGuests()
+        Counter_GuestsWokenUp, ///< Hibernated guest widgets recreated
+        Counter_FastPathRestores, ///< Layouts restored with their saved geometries verbatim
+        Counter_Count
+    };
+
+    static void increment(Counter counter, quint64 amount = 1)
+    {
+        s_values[counter] += amount;
+    }
+
+    ///@brief Returns the value accumulated since startup or since the last reset()
+    static quint64 value(Counter);
+
+    ///@brief Returns a human readable name for @p counter
+    static const char *name(Counter);
+
+    ///@brief Resets all counters to 0
+    static void reset();
+
+private:
+    static quint64 s_values[Counter_Count];
+};
+
+}
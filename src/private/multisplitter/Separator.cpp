@@ -14,6 +14,7 @@
 #include "Logging_p.h"
 #include "Item_p.h"
 #include "MultiSplitterConfig.h"
+#include "PerfCounters_p.h"
 #include "Config.h"
 
 #include <QGuiApplication>
@@ -59,6 +60,7 @@ struct Separator::Private
     ItemBoxContainer *parentContainer = nullptr;
     Layouting::Side lastMoveDirection = Side1;
     const bool usesLazyResize = Config::self().flags() & Config::Flag::LazyResize;
+    bool isPooled = false;
     Widget *const m_hostWidget;
 };
 
@@ -66,11 +68,14 @@ Separator::Separator(Widget *hostWidget)
     : d(new Private(hostWidget))
 {
     s_numSeparators++;
+    PerfCounters::increment(PerfCounters::Counter_SeparatorsCreated);
 }
 
 Separator::~Separator()
 {
-    s_numSeparators--;
+    if (!d->isPooled)
+        s_numSeparators--;
+    PerfCounters::increment(PerfCounters::Counter_SeparatorsDestroyed);
     delete d;
     if (isBeingDragged())
         s_separatorBeingDragged = nullptr;
@@ -172,7 +177,8 @@ void Separator::onMouseReleased()
 {
     if (d->lazyResizeRubberBand) {
         d->lazyResizeRubberBand->hide();
-        d->parentContainer->requestSeparatorMove(this, d->lazyPosition - position());
+        if (d->parentContainer)
+            d->parentContainer->requestSeparatorMove(this, d->lazyPosition - position());
     }
 
     s_separatorBeingDragged = nullptr;
@@ -181,14 +187,22 @@ void Separator::onMouseReleased()
 void Separator::setGeometry(QRect r)
 {
     if (r != d->geometry) {
+        const QRect oldGeometry = d->geometry;
         d->geometry = r;
         if (auto w = asWidget()) {
             w->setGeometry(r);
             w->setVisible(true);
         }
+
+        onGeometryChanged(oldGeometry);
     }
 }
 
+QRect Separator::geometry() const
+{
+    return d->geometry;
+}
+
 int Separator::position() const
 {
     const QPoint topLeft = d->geometry.topLeft();
@@ -200,6 +214,11 @@ QObject *Separator::host() const
     return d->m_hostWidget ? d->m_hostWidget->asQObject() : nullptr;
 }
 
+Widget *Separator::hostWidget() const
+{
+    return d->m_hostWidget;
+}
+
 void Separator::init(ItemBoxContainer *parentContainer, Qt::Orientation orientation)
 {
     if (!parentContainer) {
@@ -207,11 +226,39 @@ void Separator::init(ItemBoxContainer *parentContainer, Qt::Orientation orientat
         return;
     }
 
+    if (d->isPooled) {
+        d->isPooled = false;
+        s_numSeparators++;
+    }
+
     d->parentContainer = parentContainer;
     d->orientation = orientation;
-    d->lazyResizeRubberBand = d->usesLazyResize ? createRubberBand(rubberBandIsTopLevel() ? nullptr : d->m_hostWidget)
-                                                : nullptr;
-    asWidget()->setVisible(true);
+    if (d->usesLazyResize && !d->lazyResizeRubberBand) // Reused separators already have one
+        d->lazyResizeRubberBand = createRubberBand(rubberBandIsTopLevel() ? nullptr : d->m_hostWidget);
+
+    if (auto w = asWidget()) // nullptr if the host paints the separators itself
+        w->setVisible(true);
+}
+
+void Separator::release()
+{
+    if (d->isPooled)
+        return;
+
+    if (isBeingDragged())
+        s_separatorBeingDragged = nullptr;
+
+    if (d->lazyResizeRubberBand)
+        d->lazyResizeRubberBand->hide();
+
+    const QRect oldGeometry = d->geometry;
+    d->isPooled = true;
+    d->parentContainer = nullptr;
+    d->geometry = QRect(); // So the next setGeometry() isn't a no-op
+    if (auto w = asWidget())
+        w->setVisible(false);
+    onGeometryChanged(oldGeometry);
+    s_numSeparators--;
 }
 
 ItemBoxContainer *Separator::parentContainer() const
@@ -250,7 +297,7 @@ void Separator::setLazyPosition(int pos)
     if (d->lazyPosition != pos) {
         d->lazyPosition = pos;
 
-        QRect geo = asWidget()->geometry();
+        QRect geo = d->geometry;
         if (isVertical()) {
             geo.moveTop(pos);
         } else {
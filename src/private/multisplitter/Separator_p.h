@@ -39,8 +39,18 @@ public:
     int position() const;
     QObject *host() const;
 
+    ///@brief Returns the geometry, in root item coordinates (which are the host's)
+    QRect geometry() const;
+
     void init(Layouting::ItemBoxContainer *, Qt::Orientation orientation);
 
+    ///@brief Hides the separator and detaches it from its container, so it can be reused later
+    /// by another container in the same host widget. See Widget::returnSeparatorToPool()
+    void release();
+
+    ///@brief Returns the widget hosting this separator
+    Widget *hostWidget() const;
+
     ItemBoxContainer *parentContainer() const;
 
     ///@brief Returns whether we're dragging a separator. Can be useful for the app to stop other work while we're not in the final size
@@ -48,7 +58,8 @@ public:
     virtual Widget *asWidget() = 0;
 
     /// @internal Just for the unit-tests.
-    /// Returns the total amount of Separator() instances currently alive.
+    /// Returns the total amount of Separator() instances currently alive and in use by a container.
+    /// Separators kept in a pool for reuse aren't counted.
     static int numSeparators();
 
 protected:
@@ -58,6 +69,13 @@ protected:
         Q_UNUSED(parent);
         return nullptr;
     }
+
+    ///@brief Called whenever the geometry changes. For separators not backed by a widget,
+    /// which need to tell their host to repaint.
+    virtual void onGeometryChanged(QRect oldGeometry)
+    {
+        Q_UNUSED(oldGeometry);
+    }
     void onMousePress();
     void onMouseReleased();
     void onMouseDoubleClick();
@@ -0,0 +1,203 @@
+/*
+  This file is part of KDDockWidgets.
+
+  SPDX-FileCopyrightText: 2020-2022 Klarälvdalens Datakonsult AB, a KDAB Group company <info@kdab.com>
+  Author: Sérgio Martins <sergio.martins@kdab.com>
+
+  SPDX-License-Identifier: GPL-2.0-only OR GPL-3.0-only
+
+  Contact KDAB at <info@kdab.com> for commercial licensing options.
+*/
+
+#include "VirtualSeparator_qwidget.h"
+#include "Separator_qwidget.h"
+#include "Item_p.h"
+#include "Logging_p.h"
+#include "Config.h"
+#include "kddockwidgets/Qt5Qt6Compat_p.h"
+
+#include <QPainter>
+#include <QStyleOption>
+#include <QMouseEvent>
+#include <QPaintEvent>
+#include <QWidget>
+
+using namespace Layouting;
+
+VirtualSeparator::VirtualSeparator(Layouting::Widget *parent)
+    : Separator(parent)
+    , m_host(VirtualSeparatorHost::forHost(parent->asQWidget()))
+{
+    m_host->registerSeparator(this);
+}
+
+VirtualSeparator::~VirtualSeparator()
+{
+    if (m_host)
+        m_host->unregisterSeparator(this);
+}
+
+Widget *VirtualSeparator::asWidget()
+{
+    return nullptr;
+}
+
+Widget *VirtualSeparator::createRubberBand(Widget *parent)
+{
+    return new Layouting::Widget_qwidget(new RubberBand(parent));
+}
+
+void VirtualSeparator::onGeometryChanged(QRect oldGeometry)
+{
+    if (m_host) {
+        m_host->m_hostWidget->update(oldGeometry);
+        m_host->m_hostWidget->update(geometry());
+    }
+}
+
+VirtualSeparatorHost::VirtualSeparatorHost(QWidget *host)
+    : QObject(host)
+    , m_hostWidget(host)
+{
+    setObjectName(QStringLiteral("VirtualSeparatorHost"));
+    host->setMouseTracking(true);
+    host->installEventFilter(this);
+}
+
+VirtualSeparatorHost *VirtualSeparatorHost::forHost(QWidget *host)
+{
+    if (auto existing = host->findChild<VirtualSeparatorHost *>(QString(), Qt::FindDirectChildrenOnly))
+        return existing;
+
+    return new VirtualSeparatorHost(host);
+}
+
+void VirtualSeparatorHost::registerSeparator(VirtualSeparator *separator)
+{
+    m_separators.push_back(separator);
+}
+
+void VirtualSeparatorHost::unregisterSeparator(VirtualSeparator *separator)
+{
+    m_separators.removeOne(separator);
+    if (m_draggedSeparator == separator)
+        m_draggedSeparator = nullptr;
+
+    m_hostWidget->update(separator->geometry());
+}
+
+VirtualSeparator *VirtualSeparatorHost::separatorAt(QPoint pos) const
+{
+    // Any separator in use leads us to the root container, from where we descend the tree
+    for (VirtualSeparator *separator : m_separators) {
+        if (ItemBoxContainer *container = separator->parentContainer()) {
+            ItemBoxContainer *root = container->root();
+            if (Separator *result = root->separatorAt_recursive(root->mapFromRoot(pos))) {
+                // All separators with our host are virtual ones, as they come from the same factory
+                return static_cast<VirtualSeparator *>(result);
+            }
+
+            return nullptr;
+        }
+    }
+
+    return nullptr;
+}
+
+void VirtualSeparatorHost::paintSeparators(QRect exposedRect)
+{
+    if (KDDockWidgets::Config::self().disabledPaintEvents() & KDDockWidgets::Config::CustomizableWidget_Separator)
+        return;
+
+    QPainter p(m_hostWidget);
+    QStyleOption opt;
+    opt.palette = m_hostWidget->palette();
+
+    for (VirtualSeparator *separator : qAsConst(m_separators)) {
+        const QRect geo = separator->geometry();
+        if (!separator->parentContainer() || !geo.intersects(exposedRect))
+            continue;
+
+        opt.rect = geo;
+        opt.state = QStyle::State_None;
+        if (!separator->isVertical())
+            opt.state |= QStyle::State_Horizontal;
+
+        if (m_hostWidget->isEnabled())
+            opt.state |= QStyle::State_Enabled;
+
+        m_hostWidget->style()->drawControl(QStyle::CE_Splitter, &opt, &p, m_hostWidget);
+    }
+}
+
+void VirtualSeparatorHost::updateCursor(QPoint pos)
+{
+    if (VirtualSeparator *separator = separatorAt(pos)) {
+        m_hostWidget->setCursor(separator->isVertical() ? Qt::SizeVerCursor : Qt::SizeHorCursor);
+        m_overridesCursor = true;
+    } else if (m_overridesCursor) {
+        m_hostWidget->unsetCursor();
+        m_overridesCursor = false;
+    }
+}
+
+bool VirtualSeparatorHost::eventFilter(QObject *watched, QEvent *event)
+{
+    if (watched != m_hostWidget)
+        return false;
+
+    switch (event->type()) {
+    case QEvent::Paint:
+        // The background was already painted. The host itself doesn't paint anything and
+        // separators don't overlap any child, so just paint on top.
+        paintSeparators(static_cast<QPaintEvent *>(event)->rect());
+        return false;
+    case QEvent::MouseButtonPress:
+    case QEvent::MouseButtonDblClick: {
+        auto me = static_cast<QMouseEvent *>(event);
+        if (me->button() != Qt::LeftButton)
+            return false;
+
+        const QPoint pos = m_hostWidget->mapFromGlobal(KDDockWidgets::Qt5Qt6Compat::eventGlobalPos(me));
+        VirtualSeparator *separator = separatorAt(pos);
+        if (!separator)
+            return false;
+
+        if (event->type() == QEvent::MouseButtonDblClick) {
+            separator->onMouseDoubleClick();
+        } else {
+            qCDebug(separators) << Q_FUNC_INFO << "Pressed virtual separator" << pos;
+            m_draggedSeparator = separator;
+            separator->onMousePress();
+        }
+        return true;
+    }
+    case QEvent::MouseMove: {
+        auto me = static_cast<QMouseEvent *>(event);
+        const QPoint pos = m_hostWidget->mapFromGlobal(KDDockWidgets::Qt5Qt6Compat::eventGlobalPos(me));
+        if (m_draggedSeparator) {
+            m_draggedSeparator->onMouseMove(pos);
+            return true;
+        }
+
+        updateCursor(pos);
+        return false;
+    }
+    case QEvent::MouseButtonRelease:
+        if (m_draggedSeparator) {
+            VirtualSeparator *separator = m_draggedSeparator;
+            m_draggedSeparator = nullptr;
+            separator->onMouseReleased();
+            return true;
+        }
+        return false;
+    case QEvent::Leave:
+        if (m_overridesCursor && !m_draggedSeparator) {
+            m_hostWidget->unsetCursor();
+            m_overridesCursor = false;
+        }
+        return false;
+    default:
+        return false;
+    }
+}
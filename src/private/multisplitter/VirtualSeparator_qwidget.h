@@ -0,0 +1,89 @@
+/*
+  This file is part of KDDockWidgets.
+
+  SPDX-FileCopyrightText: 2020-2022 Klarälvdalens Datakonsult AB, a KDAB Group company <info@kdab.com>
+  Author: Sérgio Martins <sergio.martins@kdab.com>
+
+  SPDX-License-Identifier: GPL-2.0-only OR GPL-3.0-only
+
+  Contact KDAB at <info@kdab.com> for commercial licensing options.
+*/
+
+#ifndef KD_MULTISPLITTER_VIRTUALSEPARATORQWIDGET_P_H
+#define KD_MULTISPLITTER_VIRTUALSEPARATORQWIDGET_P_H
+
+#include "kddockwidgets/docks_export.h"
+#include "Separator_p.h"
+
+#include <QObject>
+#include <QPointer>
+#include <QVector>
+
+QT_BEGIN_NAMESPACE
+class QWidget;
+QT_END_NAMESPACE
+
+namespace Layouting {
+
+class VirtualSeparatorHost;
+
+/**
+ * @brief A Separator which isn't backed by any widget.
+ *
+ * Painting, hover and mouse handling is done by the host widget, via VirtualSeparatorHost.
+ * Useful for layouts with very many separators, as each SeparatorWidget is a QWidget with
+ * mouse tracking and its own geometry events.
+ */
+class DOCKS_EXPORT VirtualSeparator : public Layouting::Separator
+{
+public:
+    explicit VirtualSeparator(Layouting::Widget *parent);
+    ~VirtualSeparator() override;
+
+    Widget *asWidget() override;
+
+protected:
+    Widget *createRubberBand(Widget *parent) override;
+    void onGeometryChanged(QRect oldGeometry) override;
+
+private:
+    friend class VirtualSeparatorHost;
+    QPointer<VirtualSeparatorHost> m_host;
+};
+
+/**
+ * @brief Paints and does hit-testing for all VirtualSeparator instances of a host widget.
+ *
+ * It's a child of the host widget and filters its events. Hit-testing goes through the
+ * container tree, see ItemBoxContainer::separatorAt_recursive().
+ */
+class DOCKS_EXPORT VirtualSeparatorHost : public QObject
+{
+    Q_OBJECT
+public:
+    ///@brief Returns the VirtualSeparatorHost for the specified widget, creating it if needed
+    static VirtualSeparatorHost *forHost(QWidget *host);
+
+    ///@brief Returns the separator under @p pos, which is in host coordinates. nullptr if none.
+    VirtualSeparator *separatorAt(QPoint pos) const;
+
+protected:
+    bool eventFilter(QObject *watched, QEvent *event) override;
+
+private:
+    friend class VirtualSeparator;
+    explicit VirtualSeparatorHost(QWidget *host);
+    void registerSeparator(VirtualSeparator *);
+    void unregisterSeparator(VirtualSeparator *);
+    void paintSeparators(QRect exposedRect);
+    void updateCursor(QPoint pos);
+
+    QWidget *const m_hostWidget;
+    QVector<VirtualSeparator *> m_separators;
+    VirtualSeparator *m_draggedSeparator = nullptr;
+    bool m_overridesCursor = false;
+};
+
+}
+
+#endif
@@ -11,6 +11,7 @@
 
 #include "Widget.h"
 #include "Item_p.h"
+#include "Separator_p.h"
 
 using namespace Layouting;
 
@@ -24,6 +25,8 @@ Widget::Widget(QObject *thisObj)
 
 Widget::~Widget()
 {
+    // Pooled separators are children of this widget, delete them while they're still ours
+    qDeleteAll(m_separatorPool);
 }
 
 QString Widget::id() const
@@ -31,6 +34,30 @@ QString Widget::id() const
     return m_id;
 }
 
+Separator *Widget::takeSeparatorFromPool(Qt::Orientation orientation)
+{
+    for (auto i = m_separatorPool.size() - 1; i >= 0; --i) {
+        Separator *separator = m_separatorPool.at(i);
+        if (separator->orientation() == orientation) {
+            m_separatorPool.remove(i);
+            return separator;
+        }
+    }
+
+    return nullptr;
+}
+
+void Widget::returnSeparatorToPool(Separator *separator)
+{
+    separator->release();
+    m_separatorPool.push_back(separator);
+}
+
+int Widget::numPooledSeparators() const
+{
+    return m_separatorPool.size();
+}
+
 QSize Widget::boundedMaxSize(QSize min, QSize max)
 {
     // Max should be bigger than min, but not bigger than the hardcoded max
@@ -20,6 +20,7 @@
 #include <QSize>
 #include <QDebug>
 #include <QObject>
+#include <QVector>
 #include <qglobal.h>
 
 #include <memory>
@@ -64,6 +65,7 @@ public:
 namespace Layouting {
 
 class Item;
+class Separator;
 
 /**
  * @brief An abstraction/wrapper around QWidget, QtQuickItem or anything else
@@ -146,6 +148,18 @@ public:
     ///@brief returns an id for corelation purposes for saving layouts
     QString id() const;
 
+    ///@brief Returns a hidden separator, previously used by a container hosted in this widget,
+    /// with the specified orientation. Returns nullptr if there's none.
+    /// This allows to reuse separators instead of deleting and recreating them whenever
+    /// the number of visible items changes.
+    Separator *takeSeparatorFromPool(Qt::Orientation);
+
+    ///@brief Hides @p separator and keeps it for reuse. See takeSeparatorFromPool()
+    void returnSeparatorToPool(Separator *);
+
+    ///@brief Returns the number of unused separators kept for reuse
+    int numPooledSeparators() const;
+
     static QSize hardcodedMinimumSize();
 
     template<typename T>
@@ -187,6 +201,7 @@ protected:
 private:
     const QString m_id;
     QObject *const m_thisObj;
+    QVector<Separator *> m_separatorPool;
     Q_DISABLE_COPY(Widget)
 };
 
@@ -11,8 +11,10 @@
 
 #include "Widget_quick.h"
 #include "Item_p.h"
+#include "../quick/QmlComponentCache_p.h"
 
 #include <QDebug>
+#include <QQmlComponent>
 #include <QQmlEngine>
 
 using namespace Layouting;
@@ -139,10 +141,13 @@ QQuickItem *Widget_quick::createQQuickItem(const QString &filename, QQuickItem *
         return nullptr;
     }
 
-    QQmlComponent component(engine, filename);
-    auto qquickitem = qobject_cast<QQuickItem *>(component.create());
+    QQmlComponent *component = KDDockWidgets::QmlComponentCache::component(engine, filename);
+    if (!component)
+        return nullptr;
+
+    auto qquickitem = qobject_cast<QQuickItem *>(component->create());
     if (!qquickitem) {
-        qWarning() << Q_FUNC_INFO << component.errorString();
+        qWarning() << Q_FUNC_INFO << component->errorString();
         return nullptr;
     }
 
@@ -21,13 +21,45 @@
 #include "FrameworkWidgetFactory.h"
 #include "TabWidgetQuick_p.h"
 #include "DockWidgetQuick.h"
+#include "QmlComponentCache_p.h"
 #include "../DockWidgetBase_p.h"
 #include "../WidgetResizeHandler_p.h"
 
 #include <QDebug>
+#include <QQmlComponent>
+#include <QQmlEngine>
+#include <QQmlIncubator>
 
 using namespace KDDockWidgets;
 
+namespace KDDockWidgets {
+
+/// @brief Incubates Frame.qml asynchronously and hands the result to the FrameQuick
+class FrameQuickIncubator : public QQmlIncubator
+{
+public:
+    explicit FrameQuickIncubator(FrameQuick *frame)
+        : QQmlIncubator(QQmlIncubator::Asynchronous)
+        , m_frame(frame)
+    {
+    }
+
+protected:
+    void statusChanged(Status status) override
+    {
+        if (status == QQmlIncubator::Ready) {
+            m_frame->setVisualItem(qobject_cast<QQuickItem *>(object()));
+        } else if (status == QQmlIncubator::Error) {
+            qWarning() << Q_FUNC_INFO << "Failed to create item" << errors();
+        }
+    }
+
+private:
+    FrameQuick *const m_frame;
+};
+
+}
+
 FrameQuick::FrameQuick(QWidgetAdapter *parent, FrameOptions options, int userType)
     : Frame(parent, options, userType)
 {
@@ -45,19 +77,24 @@ FrameQuick::FrameQuick(QWidgetAdapter *parent, FrameOptions options, int userTyp
         }
     });
 
-    QQmlComponent component(Config::self().qmlEngine(),
-                            Config::self().frameworkWidgetFactory()->frameFilename());
+    QQmlEngine *engine = Config::self().qmlEngine();
+    QQmlComponent *component = QmlComponentCache::component(
+        engine, Config::self().frameworkWidgetFactory()->frameFilename());
+    if (!component)
+        return;
 
-    m_visualItem = static_cast<QQuickItem *>(component.create());
+    if (Config::self().asyncFrameIncubation() && engine->incubationController()) {
+        m_incubator.reset(new FrameQuickIncubator(this));
+        component->create(*m_incubator);
+    } else {
+        auto item = qobject_cast<QQuickItem *>(component->create());
+        if (!item) {
+            qWarning() << Q_FUNC_INFO << "Failed to create item" << component->errorString();
+            return;
+        }
 
-    if (!m_visualItem) {
-        qWarning() << Q_FUNC_INFO << "Failed to create item" << component.errorString();
-        return;
+        setVisualItem(item);
     }
-
-    m_visualItem->setProperty("frameCpp", QVariant::fromValue(this));
-    m_visualItem->setParentItem(this);
-    m_visualItem->setParent(this);
 }
 
 FrameQuick::~FrameQuick()
@@ -65,16 +102,44 @@ FrameQuick::~FrameQuick()
     {
         const DockWidgetBase::List docks = dockWidgets();
 
-        // The QML item must be deleted with deleteLater(), has we might be currently with its mouse
-        // handler in the stack. QML doesn't support it being deleted in that case.
-        // So unparent it and deleteLater().
-        m_visualItem->setParent(nullptr);
-        m_visualItem->deleteLater();
+        // Abort any incubation still in progress
+        if (m_incubator)
+            m_incubator->clear();
+
+        if (m_visualItem) {
+            // The QML item must be deleted with deleteLater(), has we might be currently with its mouse
+            // handler in the stack. QML doesn't support it being deleted in that case.
+            // So unparent it and deleteLater().
+            m_visualItem->setParent(nullptr);
+            m_visualItem->deleteLater();
+        }
 
         qDeleteAll(docks);
     }
 }
 
+void FrameQuick::setVisualItem(QQuickItem *item)
+{
+    if (!item) {
+        qWarning() << Q_FUNC_INFO << "Frame.qml's root should be an Item";
+        return;
+    }
+
+    m_visualItem = item;
+    m_visualItem->setProperty("frameCpp", QVariant::fromValue(this));
+    m_visualItem->setParentItem(this);
+    m_visualItem->setParent(this);
+
+    if (m_incubator)
+        updateConstriants(); // The non-contents height is known now
+}
+
+void FrameQuick::completeVisualItem()
+{
+    if (m_incubator && m_incubator->isLoading())
+        m_incubator->forceCompletion();
+}
+
 void FrameQuick::updateConstriants()
 {
     onDockWidgetCountChanged();
@@ -117,10 +182,14 @@ void FrameQuick::insertDockWidget_impl(DockWidgetBase *dw, int index)
 {
     QPointer<Frame> oldFrame = dw->d->frame();
     if (m_tabWidget->insertDockWidget(index, dw, {}, {})) {
-        dw->setParent(m_stackLayout);
+        // While our QML is being incubated we hold the dock widget ourselves, see setStackLayout()
+        if (m_stackLayout)
+            dw->setParent(m_stackLayout);
+        else
+            dw->setParent(this);
 
         QMetaObject::Connection conn = connect(dw, &DockWidgetBase::parentChanged, this, [dw, this] {
-            if (dw->parent() != m_stackLayout)
+            if (dw->parent() != m_stackLayout && dw->parent() != this)
                 removeWidget_impl(dw);
         });
 
@@ -171,6 +240,13 @@ void FrameQuick::setStackLayout(QQuickItem *stackLayout)
     }
 
     m_stackLayout = stackLayout;
+
+    // Dock widgets added before the QML was incubated
+    const DockWidgetBase::List docks = dockWidgets();
+    for (DockWidgetBase *dw : docks) {
+        if (dw->parent() == this)
+            dw->setParent(m_stackLayout);
+    }
 }
 
 QSize FrameQuick::minimumSize() const
@@ -201,5 +277,8 @@ QQuickItem *FrameQuick::visualItem() const
 
 int FrameQuick::nonContentsHeight() const
 {
+    if (!m_visualItem)
+        return 0; // Still incubating
+
     return m_visualItem->property("nonContentsHeight").toInt();
 }
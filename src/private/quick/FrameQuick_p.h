@@ -17,11 +17,14 @@
 #include "DockWidgetBase.h"
 #include "TabWidgetQuick_p.h"
 
+#include <memory>
+
 class QQuickItem;
 
 namespace KDDockWidgets {
 
 class DockWidgetModel;
+class FrameQuickIncubator;
 
 /**
  * @brief The GUI counterpart of Frame.
@@ -49,8 +52,12 @@ public:
     TabWidget *tabWidget() const;
 
     /// @brief Returns the QQuickItem which represents this frame on the screen
+    /// Can be nullptr while it's being incubated. @sa Config::setAsyncFrameIncubation()
     QQuickItem *visualItem() const;
 
+    /// @brief Finishes the asynchronous incubation of the visual item right away, if any
+    void completeVisualItem();
+
 protected:
     void removeWidget_impl(DockWidgetBase *) override;
     int indexOfDockWidget_impl(const DockWidgetBase *) override;
@@ -74,8 +81,12 @@ public Q_SLOTS:
     void updateConstriants();
 
 private:
+    friend class FrameQuickIncubator;
+    void setVisualItem(QQuickItem *);
+
     QQuickItem *m_stackLayout = nullptr;
     QQuickItem *m_visualItem = nullptr;
+    std::unique_ptr<FrameQuickIncubator> m_incubator;
     QHash<DockWidgetBase *, QMetaObject::Connection> m_connections; // To make it easy to disconnect from lambdas
 };
 
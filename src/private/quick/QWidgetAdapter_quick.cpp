@@ -25,6 +25,8 @@
 #include "../Utils_p.h"
 #include "../FloatingWindow_p.h"
 #include "../multisplitter/Item_p.h"
+#include "../multisplitter/PerfCounters_p.h"
+#include "QmlComponentCache_p.h"
 
 #include <QResizeEvent>
 #include <QMouseEvent>
@@ -32,6 +34,7 @@
 #include <QQuickItem>
 #include <QQmlEngine>
 #include <QQuickView>
+#include <QPointer>
 #include <QScopedValueRollback>
 
 #include <qpa/qplatformwindow.h>
@@ -105,6 +108,118 @@ MouseEventRedirector::~MouseEventRedirector()
     s_mouseEventRedirectors.remove(m_eventSource);
 }
 
+/**
+ * @brief Application wide event filter which forwards window events to the QWidgetAdapters in that window.
+ * A single filter, instead of one per QWidgetAdapter, as with hundreds of adapters every event
+ * in the application would cross hundreds of filters.
+ */
+class WindowEventDispatcher : public QObject
+{
+    Q_OBJECT
+public:
+    static WindowEventDispatcher *self()
+    {
+        QPointer<WindowEventDispatcher> &dispatcher = instancePointer();
+        if (!dispatcher)
+            dispatcher = new WindowEventDispatcher(qApp);
+
+        return dispatcher;
+    }
+
+    ///@brief Returns the dispatcher, without creating it. nullptr if it doesn't exist yet or
+    /// was already destroyed along with qApp.
+    static WindowEventDispatcher *existingInstance()
+    {
+        return instancePointer();
+    }
+
+    void setWindow(QWidgetAdapter *adapter, QWindow *window)
+    {
+        removeAdapter(adapter);
+        if (window) {
+            m_windowByAdapter.insert(adapter, window);
+            m_adaptersByWindow[window].push_back(adapter);
+        }
+    }
+
+    void removeAdapter(QWidgetAdapter *adapter)
+    {
+        auto it = m_windowByAdapter.find(adapter);
+        if (it == m_windowByAdapter.end())
+            return;
+
+        auto windowIt = m_adaptersByWindow.find(it.value());
+        if (windowIt != m_adaptersByWindow.end()) {
+            windowIt->removeOne(adapter);
+            if (windowIt->isEmpty())
+                m_adaptersByWindow.erase(windowIt);
+        }
+
+        m_windowByAdapter.erase(it);
+    }
+
+    int numAdapters() const
+    {
+        return m_windowByAdapter.size();
+    }
+
+    bool eventFilter(QObject *watched, QEvent *ev) override
+    {
+        Layouting::PerfCounters::increment(Layouting::PerfCounters::Counter_EventFilterInvocations);
+
+        switch (ev->type()) {
+        case QEvent::MouseMove:
+        case QEvent::MouseButtonPress:
+        case QEvent::MouseButtonRelease:
+        case QEvent::Resize:
+        case QEvent::Move:
+            break;
+        default:
+            return false;
+        }
+
+        auto window = qobject_cast<QWindow *>(watched);
+        if (!window)
+            return false;
+
+        auto it = m_adaptersByWindow.constFind(window);
+        if (it == m_adaptersByWindow.constEnd())
+            return false;
+
+        // Copy, as adapters might get created or destroyed while handling the event
+        QVector<QPointer<QWidgetAdapter>> adapters;
+        adapters.reserve(it->size());
+        for (QWidgetAdapter *adapter : *it)
+            adapters.push_back(adapter);
+
+        // Newest first, same order as if each adapter had installed its own filter
+        for (auto adapterIt = adapters.crbegin(); adapterIt != adapters.crend(); ++adapterIt) {
+            if (QWidgetAdapter *adapter = adapterIt->data()) {
+                if (adapter->eventFilter(watched, ev))
+                    return true;
+            }
+        }
+
+        return false;
+    }
+
+private:
+    explicit WindowEventDispatcher(QObject *parent)
+        : QObject(parent)
+    {
+        qApp->installEventFilter(this);
+    }
+
+    static QPointer<WindowEventDispatcher> &instancePointer()
+    {
+        static QPointer<WindowEventDispatcher> s_dispatcher;
+        return s_dispatcher;
+    }
+
+    QHash<QWidgetAdapter *, QWindow *> m_windowByAdapter;
+    QHash<QWindow *, QVector<QWidgetAdapter *>> m_adaptersByWindow;
+};
+
 }
 
 static bool flagsAreTopLevelFlags(Qt::WindowFlags flags)
@@ -141,13 +256,27 @@ QWidgetAdapter::QWidgetAdapter(QQuickItem *parent, Qt::WindowFlags flags)
         }
     });
 
-    qApp->installEventFilter(this);
+    // Instead of each adapter filtering every application event we get our window's events from
+    // a shared dispatcher
+    WindowEventDispatcher::self()->setWindow(this, QQuickItem::window());
+    connect(this, &QQuickItem::windowChanged, this, [this](QQuickWindow *window) {
+        WindowEventDispatcher::self()->setWindow(this, window);
+    });
 
     setSize(QSize(800, 800));
 }
 
 QWidgetAdapter::~QWidgetAdapter()
 {
+    // Don't recreate the dispatcher if it's gone already, at shutdown
+    if (auto dispatcher = WindowEventDispatcher::existingInstance())
+        dispatcher->removeAdapter(this);
+}
+
+int QWidgetAdapter::numAdaptersWithWindowEvents()
+{
+    auto dispatcher = WindowEventDispatcher::existingInstance();
+    return dispatcher ? dispatcher->numAdapters() : 0;
 }
 
 void QWidgetAdapter::raiseAndActivate()
@@ -685,10 +814,13 @@ Qt::WindowFlags QWidgetAdapter::windowFlags() const
 /** static */
 QQuickItem *QWidgetAdapter::createItem(QQmlEngine *engine, const QString &filename)
 {
-    QQmlComponent component(engine, filename);
-    QObject *obj = component.create();
+    QQmlComponent *component = QmlComponentCache::component(engine, filename);
+    if (!component)
+        return nullptr;
+
+    QObject *obj = component->create();
     if (!obj) {
-        qWarning() << Q_FUNC_INFO << component.errorString();
+        qWarning() << Q_FUNC_INFO << component->errorString();
         return nullptr;
     }
 
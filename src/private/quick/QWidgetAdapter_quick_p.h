@@ -39,6 +39,7 @@ QT_END_NAMESPACE
 namespace KDDockWidgets {
 
 class MouseEventRedirector;
+class WindowEventDispatcher;
 
 namespace Private {
 
@@ -235,6 +236,9 @@ public:
 
     static QQuickItem *createItem(QQmlEngine *, const QString &filename);
     static void makeItemFillParent(QQuickItem *item);
+
+    ///@brief Returns how many adapters are registered for receiving their window's events. For tests.
+    static int numAdaptersWithWindowEvents();
 Q_SIGNALS:
     void geometryUpdated(); // similar to QLayout stuff, when size constraints change
     void itemGeometryChanged(); // emitted when the geometry changes. QQuickItem::geometryChanged()
@@ -257,6 +261,7 @@ protected:
     void itemChange(QQuickItem::ItemChange, const QQuickItem::ItemChangeData &) override;
 
 private:
+    friend class WindowEventDispatcher;
     void updateNormalGeometry();
 
     QSize m_sizeHint;
@@ -0,0 +1,69 @@
+/*
+  This file is part of KDDockWidgets.
+
+  SPDX-FileCopyrightText: 2020-2022 Klarälvdalens Datakonsult AB, a KDAB Group company <info@kdab.com>
+  Author: Sérgio Martins <sergio.martins@kdab.com>
+
+  SPDX-License-Identifier: GPL-2.0-only OR GPL-3.0-only
+
+  Contact KDAB at <info@kdab.com> for commercial licensing options.
+*/
+
+#include "QmlComponentCache_p.h"
+
+#include <QDebug>
+#include <QHash>
+#include <QQmlComponent>
+#include <QQmlEngine>
+
+using namespace KDDockWidgets;
+
+namespace {
+typedef QHash<QString, QQmlComponent *> ComponentsByUrl;
+
+QHash<QQmlEngine *, ComponentsByUrl> &cache()
+{
+    static QHash<QQmlEngine *, ComponentsByUrl> s_cache;
+    return s_cache;
+}
+}
+
+QQmlComponent *QmlComponentCache::component(QQmlEngine *engine, const QString &filename)
+{
+    if (!engine) {
+        qWarning() << Q_FUNC_INFO << "Null engine";
+        return nullptr;
+    }
+
+    auto engineIt = cache().find(engine);
+    if (engineIt == cache().end()) {
+        // The components are children of the engine, so only the cache entry needs cleanup
+        QObject::connect(engine, &QObject::destroyed, engine, [engine] {
+            cache().remove(engine);
+        });
+        engineIt = cache().insert(engine, {});
+    }
+
+    ComponentsByUrl &components = *engineIt;
+    if (QQmlComponent *component = components.value(filename))
+        return component;
+
+    auto component = new QQmlComponent(engine, filename, engine);
+    if (component->isError()) {
+        qWarning() << Q_FUNC_INFO << component->errorString();
+        delete component;
+        return nullptr;
+    }
+
+    components.insert(filename, component);
+    return component;
+}
+
+int QmlComponentCache::count()
+{
+    int total = 0;
+    for (const ComponentsByUrl &components : qAsConst(cache()))
+        total += components.size();
+
+    return total;
+}
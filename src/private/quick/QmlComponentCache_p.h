@@ -0,0 +1,43 @@
+/*
+  This file is part of KDDockWidgets.
+
+  SPDX-FileCopyrightText: 2020-2022 Klarälvdalens Datakonsult AB, a KDAB Group company <info@kdab.com>
+  Author: Sérgio Martins <sergio.martins@kdab.com>
+
+  SPDX-License-Identifier: GPL-2.0-only OR GPL-3.0-only
+
+  Contact KDAB at <info@kdab.com> for commercial licensing options.
+*/
+
+#ifndef KD_QTQUICK_QMLCOMPONENTCACHE_P_H
+#define KD_QTQUICK_QMLCOMPONENTCACHE_P_H
+
+#include "kddockwidgets/docks_export.h"
+
+#include <QString>
+
+class QQmlComponent;
+class QQmlEngine;
+
+namespace KDDockWidgets {
+
+/**
+ * @brief Caches the compiled QQmlComponent of each of our QML files.
+ *
+ * Instantiating a QQmlComponent for each Frame, TitleBar, etc. means parsing and compiling the
+ * QML each time. Components are keyed by engine and URL, and are owned by their engine.
+ */
+class DOCKS_EXPORT_FOR_UNIT_TESTS QmlComponentCache
+{
+public:
+    ///@brief Returns the component for @p filename, loading it on first use.
+    /// Returns nullptr and warns if the component has errors. Errors aren't cached.
+    static QQmlComponent *component(QQmlEngine *, const QString &filename);
+
+    ///@brief Returns the number of cached components, for all engines
+    static int count();
+};
+
+}
+
+#endif
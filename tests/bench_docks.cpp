@@ -0,0 +1,128 @@
+/*
+  This file is part of KDDockWidgets.
+
+  SPDX-FileCopyrightText: 2020-2022 Klarälvdalens Datakonsult AB, a KDAB Group company <info@kdab.com>
+  Author: Sérgio Martins <sergio.martins@kdab.com>
+
+  SPDX-License-Identifier: GPL-2.0-only OR GPL-3.0-only
+
+  Contact KDAB at <info@kdab.com> for commercial licensing options.
+*/
+
+// Benchmarks for operations involving the whole framework, not just the layouting engine.
+// Run with -tickcounter or -callgrind for more precise results.
+
+#include "Config.h"
+#include "private/multisplitter/PerfCounters_p.h"
+
+#include <QtTest/QtTest>
+
+#ifdef KDDOCKWIDGETS_QTWIDGETS
+#include "DockWidget.h"
+#include "MainWindow.h"
+
+#include <QWidget>
+#else
+#include "private/quick/QWidgetAdapter_quick_p.h"
+
+#include <QQuickView>
+
+#include <memory>
+#include <vector>
+#endif
+
+using namespace KDDockWidgets;
+using Layouting::PerfCounters;
+
+class BenchDocks : public QObject
+{
+    Q_OBJECT
+private Q_SLOTS:
+#ifdef KDDOCKWIDGETS_QTWIDGETS
+    void initTestCase();
+    void bench_sideBarOverlayToggle();
+#else
+    void bench_eventDispatch_data();
+    void bench_eventDispatch();
+#endif
+};
+
+#ifdef KDDOCKWIDGETS_QTWIDGETS
+void BenchDocks::initTestCase()
+{
+    Config::self().setFlags(Config::Flag_AutoHideSupport);
+}
+
+void BenchDocks::bench_sideBarOverlayToggle()
+{
+    // Measures showing and hiding overlays of auto-hidden dock widgets, as when the user clicks
+    // the side bar buttons
+
+    MainWindow mainWindow(QStringLiteral("bench_mainWindow"), MainWindowOption_None);
+    mainWindow.resize(1000, 1000);
+    mainWindow.show();
+
+    auto dock1 = new DockWidget(QStringLiteral("bench_dock1"));
+    dock1->setWidget(new QWidget());
+    auto dock2 = new DockWidget(QStringLiteral("bench_dock2"));
+    dock2->setWidget(new QWidget());
+
+    mainWindow.addDockWidget(dock1, Location_OnLeft);
+    mainWindow.addDockWidget(dock2, Location_OnRight);
+    mainWindow.moveToSideBar(dock1);
+    mainWindow.moveToSideBar(dock2);
+
+    const quint64 framesCreated = PerfCounters::value(PerfCounters::Counter_FramesCreated);
+
+    QBENCHMARK {
+        mainWindow.overlayOnSideBar(dock1);
+        mainWindow.overlayOnSideBar(dock2);
+        mainWindow.clearSideBarOverlay();
+    }
+
+    // The overlay frame is reused, so only the first overlay creates one
+    QVERIFY(PerfCounters::value(PerfCounters::Counter_FramesCreated) - framesCreated <= 1);
+
+    delete dock1;
+    delete dock2;
+}
+#else
+void BenchDocks::bench_eventDispatch_data()
+{
+    QTest::addColumn<int>("numAdapters");
+
+    QTest::newRow("10 adapters") << 10;
+    QTest::newRow("100 adapters") << 100;
+    QTest::newRow("1000 adapters") << 1000;
+}
+
+void BenchDocks::bench_eventDispatch()
+{
+    // Measures the cost of delivering an application event as the number of QWidgetAdapters grows.
+    // Half the adapters are in a window, the other half aren't in any.
+
+    QFETCH(int, numAdapters);
+
+    QQuickView view;
+    view.resize(800, 800);
+
+    std::vector<std::unique_ptr<QWidgetAdapter>> adapters;
+    adapters.reserve(size_t(numAdapters));
+    for (int i = 0; i < numAdapters; ++i)
+        adapters.emplace_back(new QWidgetAdapter(i % 2 ? view.contentItem() : nullptr));
+
+    QObject receiver;
+    QBENCHMARK {
+        // An event which isn't for us at all, and one for a window with adapters
+        QEvent userEvent(QEvent::User);
+        qApp->sendEvent(&receiver, &userEvent);
+
+        QMoveEvent moveEvent(QPoint(10, 10), QPoint(0, 0));
+        qApp->sendEvent(&view, &moveEvent);
+    }
+}
+#endif
+
+QTEST_MAIN(BenchDocks)
+
+#include "bench_docks.moc"
@@ -0,0 +1,437 @@
+/*
+  This file is part of KDDockWidgets.
+
+  SPDX-FileCopyrightText: 2020-2022 Klarälvdalens Datakonsult AB, a KDAB Group company <info@kdab.com>
+  Author: Sérgio Martins <sergio.martins@kdab.com>
+
+  SPDX-License-Identifier: GPL-2.0-only OR GPL-3.0-only
+
+  Contact KDAB at <info@kdab.com> for commercial licensing options.
+*/
+
+// Benchmarks for the layouting engine. Run with -tickcounter or -callgrind for more precise results.
+
+#include "private/multisplitter/Item_p.h"
+#include "private/multisplitter/FlatItemTree_p.h"
+#include "private/multisplitter/JsonStreamReader_p.h"
+#include "private/multisplitter/Separator_p.h"
+#include "private/multisplitter/Widget_qwidget.h"
+#include "private/multisplitter/MultiSplitterConfig.h"
+#include "private/multisplitter/Separator_qwidget.h"
+
+#include <QtTest/QtTest>
+#include <QJsonDocument>
+#include <QUuid>
+#include <QWidget>
+
+#include <memory>
+
+using namespace Layouting;
+using namespace KDDockWidgets;
+
+class BenchHostWidget : public QWidget, public Layouting::Widget_qwidget
+{
+public:
+    BenchHostWidget()
+        : QWidget()
+        , Widget_qwidget(this)
+    {
+    }
+};
+
+class BenchGuestWidget : public QWidget, public Layouting::Widget_qwidget
+{
+public:
+    BenchGuestWidget()
+        : QWidget()
+        , Widget_qwidget(this)
+    {
+    }
+
+    void setLayoutItem(Item *) override
+    {
+    }
+
+    QSize minimumSizeHint() const override
+    {
+        return QSize(10, 10);
+    }
+};
+
+class BenchMultiSplitter : public QObject
+{
+    Q_OBJECT
+public Q_SLOTS:
+    void initTestCase()
+    {
+        Config::self().setSeparatorFactoryFunc([](Layouting::Widget *parent) {
+            return static_cast<Separator *>(new SeparatorWidget(parent));
+        });
+    }
+
+private Q_SLOTS:
+    void bench_itemAt_recursive_data();
+    void bench_itemAt_recursive();
+    void bench_separatorAt_recursive_data();
+    void bench_separatorAt_recursive();
+    void bench_flatItemTree_build_data();
+    void bench_flatItemTree_build();
+    void bench_containerMinSizes();
+    void bench_itemRecordFromJson_data();
+    void bench_itemRecordFromJson();
+
+private:
+    /// Creates a layout with @p numColumns columns, each having @p numRows items
+    void createGridLayout(int numColumns, int numRows);
+    QVector<QPoint> samplePoints() const;
+
+    std::unique_ptr<BenchHostWidget> m_host;
+    std::unique_ptr<ItemBoxContainer> m_root;
+};
+
+void BenchMultiSplitter::createGridLayout(int numColumns, int numRows)
+{
+    m_root.reset();
+    m_host.reset(new BenchHostWidget());
+    m_root.reset(new ItemBoxContainer(m_host.get()));
+    m_root->setSize({ 4000, 4000 });
+
+    auto createItem = [this] {
+        auto item = new Item(m_host.get());
+        item->setGuestWidget(new BenchGuestWidget());
+        return item;
+    };
+
+    for (int column = 0; column < numColumns; ++column) {
+        Item *last = createItem();
+        m_root->insertItem(last, Location_OnRight);
+        for (int row = 1; row < numRows; ++row) {
+            Item *item = createItem();
+            ItemBoxContainer::insertItemRelativeTo(item, last, Location_OnBottom);
+            last = item;
+        }
+    }
+}
+
+QVector<QPoint> BenchMultiSplitter::samplePoints() const
+{
+    QVector<QPoint> points;
+    const QSize size = m_root->size();
+    for (int x = 0; x < size.width(); x += 13) {
+        for (int y = 0; y < size.height(); y += 17)
+            points.push_back({ x, y });
+    }
+
+    return points;
+}
+
+// itemAt_recursive() and separatorAt_recursive() as they were before the spatial index, which
+// scanned every child of every level. Kept here so the benchmarks compare both on the same layout.
+
+static Item *linearItemAt_recursive(const ItemBoxContainer *container, QPoint p)
+{
+    for (Item *item : container->childItems()) {
+        if (item->isVisible() && item->geometry().contains(p)) {
+            if (auto c = qobject_cast<ItemBoxContainer *>(item))
+                return linearItemAt_recursive(c, c->mapFromParent(p));
+            return item;
+        }
+    }
+
+    return nullptr;
+}
+
+static Separator *linearSeparatorAt_recursive(const ItemBoxContainer *container, QPoint p)
+{
+    const QPoint rootPos = container->mapToRoot(p);
+    for (Separator *separator : container->separators()) {
+        if (separator->geometry().contains(rootPos))
+            return separator;
+    }
+
+    for (Item *item : container->childItems()) {
+        if (item->isVisible() && item->geometry().contains(p)) {
+            if (auto c = qobject_cast<ItemBoxContainer *>(item))
+                return linearSeparatorAt_recursive(c, c->mapFromParent(p));
+            return nullptr;
+        }
+    }
+
+    return nullptr;
+}
+
+void BenchMultiSplitter::bench_itemAt_recursive_data()
+{
+    QTest::addColumn<bool>("indexed");
+
+    QTest::newRow("spatial index") << true;
+    QTest::newRow("linear scan") << false;
+}
+
+void BenchMultiSplitter::bench_itemAt_recursive()
+{
+    QFETCH(bool, indexed);
+
+    createGridLayout(20, 20);
+    const QVector<QPoint> points = samplePoints();
+
+    // Both code paths must agree before their timings mean anything
+    for (QPoint p : points)
+        QCOMPARE(m_root->itemAt_recursive(p), linearItemAt_recursive(m_root.get(), p));
+
+    int found = 0;
+    QBENCHMARK {
+        if (indexed) {
+            for (QPoint p : points)
+                found += m_root->itemAt_recursive(p) ? 1 : 0;
+        } else {
+            for (QPoint p : points)
+                found += linearItemAt_recursive(m_root.get(), p) ? 1 : 0;
+        }
+    }
+    QVERIFY(found > 0);
+}
+
+void BenchMultiSplitter::bench_separatorAt_recursive_data()
+{
+    QTest::addColumn<bool>("indexed");
+
+    QTest::newRow("spatial index") << true;
+    QTest::newRow("linear scan") << false;
+}
+
+void BenchMultiSplitter::bench_separatorAt_recursive()
+{
+    QFETCH(bool, indexed);
+
+    createGridLayout(20, 20);
+    const QVector<QPoint> points = samplePoints();
+
+    for (QPoint p : points)
+        QCOMPARE(m_root->separatorAt_recursive(p), linearSeparatorAt_recursive(m_root.get(), p));
+
+    int found = 0;
+    QBENCHMARK {
+        if (indexed) {
+            for (QPoint p : points)
+                found += m_root->separatorAt_recursive(p) ? 1 : 0;
+        } else {
+            for (QPoint p : points)
+                found += linearSeparatorAt_recursive(m_root.get(), p) ? 1 : 0;
+        }
+    }
+    QVERIFY(found > 0);
+}
+
+// ItemBoxContainer::minSize() and maxSizeHint() as they were before FlatItemTree, recursing into
+// each child container on every query. Nothing is being inserted in these layouts, so checking
+// isVisible() is enough.
+
+static QSize recursiveMinSize(const ItemBoxContainer *container)
+{
+    int minW = 0;
+    int minH = 0;
+    int numVisible = 0;
+    const Item::List children = container->childItems();
+    for (Item *item : children) {
+        if (!item->isVisible())
+            continue;
+        numVisible++;
+        auto childContainer = qobject_cast<ItemBoxContainer *>(item);
+        // Called twice per child, like the old code did
+        if (container->isVertical()) {
+            minW = qMax(minW, childContainer ? recursiveMinSize(childContainer).width() : item->minSize().width());
+            minH += childContainer ? recursiveMinSize(childContainer).height() : item->minSize().height();
+        } else {
+            minH = qMax(minH, childContainer ? recursiveMinSize(childContainer).height() : item->minSize().height());
+            minW += childContainer ? recursiveMinSize(childContainer).width() : item->minSize().width();
+        }
+    }
+
+    const int separatorWaste = qMax(0, (numVisible - 1) * Item::separatorThickness);
+    if (container->isVertical())
+        minH += separatorWaste;
+    else
+        minW += separatorWaste;
+
+    return QSize(minW, minH);
+}
+
+static QSize recursiveMaxSizeHint(const ItemBoxContainer *container)
+{
+    const QSize hardcodedMaximumSize = Item::hardcodedMaximumSize;
+    const bool isVertical = container->isVertical();
+    int maxW = isVertical ? hardcodedMaximumSize.width() : 0;
+    int maxH = isVertical ? 0 : hardcodedMaximumSize.height();
+
+    const Item::List visibleChildren = container->visibleChildren();
+    if (!visibleChildren.isEmpty()) {
+        for (Item *item : visibleChildren) {
+            auto childContainer = qobject_cast<ItemBoxContainer *>(item);
+            const QSize itemMaxSz = childContainer ? recursiveMaxSizeHint(childContainer) : item->maxSizeHint();
+            if (isVertical) {
+                maxW = qMin(maxW, itemMaxSz.width());
+                maxH = qMin(maxH + itemMaxSz.height(), hardcodedMaximumSize.height());
+            } else {
+                maxH = qMin(maxH, itemMaxSz.height());
+                maxW = qMin(maxW + itemMaxSz.width(), hardcodedMaximumSize.width());
+            }
+        }
+
+        const int separatorWaste = int(visibleChildren.size() - 1) * Item::separatorThickness;
+        if (isVertical)
+            maxH = qMin(maxH + separatorWaste, hardcodedMaximumSize.height());
+        else
+            maxW = qMin(maxW + separatorWaste, hardcodedMaximumSize.width());
+    }
+
+    if (maxW == 0)
+        maxW = hardcodedMaximumSize.width();
+
+    if (maxH == 0)
+        maxH = hardcodedMaximumSize.height();
+
+    return QSize(maxW, maxH).expandedTo(recursiveMinSize(container));
+}
+
+void BenchMultiSplitter::bench_flatItemTree_build_data()
+{
+    QTest::addColumn<bool>("flat");
+
+    QTest::newRow("FlatItemTree") << true;
+    QTest::newRow("recursive traversal") << false;
+}
+
+void BenchMultiSplitter::bench_flatItemTree_build()
+{
+    // The min and max sizes of every container, either from a freshly built FlatItemTree or by
+    // recursing into the pointer tree like before it existed
+    QFETCH(bool, flat);
+
+    createGridLayout(40, 30); // 1200 items
+    QVector<const ItemBoxContainer *> containers = { m_root.get() };
+    for (Item *item : m_root->childItems()) {
+        if (auto container = qobject_cast<ItemBoxContainer *>(item))
+            containers << container;
+    }
+
+    FlatItemTree tree;
+    tree.build(m_root.get());
+    QCOMPARE(tree.leaves(0).size(), 1200);
+    for (const ItemBoxContainer *container : qAsConst(containers)) {
+        const int index = tree.indexOf(container);
+        QCOMPARE(tree.minSize(index), recursiveMinSize(container));
+        QCOMPARE(tree.maxSizeHint(index), recursiveMaxSizeHint(container));
+    }
+
+    qint64 total = 0;
+    QBENCHMARK {
+        if (flat) {
+            tree.build(m_root.get());
+            for (const ItemBoxContainer *container : qAsConst(containers)) {
+                const int index = tree.indexOf(container);
+                total += tree.minSize(index).width() + tree.maxSizeHint(index).width();
+            }
+        } else {
+            for (const ItemBoxContainer *container : qAsConst(containers))
+                total += recursiveMinSize(container).width() + recursiveMaxSizeHint(container).width();
+        }
+    }
+    QVERIFY(total > 0);
+}
+
+void BenchMultiSplitter::bench_containerMinSizes()
+{
+    // Every iteration invalidates the layout, like a resize does, then queries the min and max
+    // sizes of all containers. The root rebuilds its FlatItemTree once, the rest read from it.
+    createGridLayout(40, 30);
+    Item::List containers;
+    for (Item *item : m_root->childItems())
+        containers << item;
+
+    QSize size = m_root->size();
+    qint64 total = 0;
+    QBENCHMARK {
+        size.rwidth() += 1;
+        m_root->setSize_recursive(size);
+        total += m_root->minSize().width() + m_root->maxSizeHint().width();
+        for (Item *container : qAsConst(containers))
+            total += container->minSize().width() + container->maxSizeHint().width();
+    }
+    QVERIFY(total > 0);
+}
+
+/// Returns the same structure as createGridLayout() creates, without creating any Item
+static ItemRecord createGridRecord(int numColumns, int numRows)
+{
+    const int size = 4000;
+    const int columnWidth = size / numColumns;
+    const int rowHeight = size / numRows;
+
+    ItemRecord root;
+    root.isNull = false;
+    root.isContainer = true;
+    root.isVisible = true;
+    root.orientation = Qt::Horizontal;
+    root.sizingInfo.geometry = QRect(0, 0, size, size);
+
+    for (int column = 0; column < numColumns; ++column) {
+        ItemRecord container;
+        container.isNull = false;
+        container.isContainer = true;
+        container.isVisible = true;
+        container.orientation = Qt::Vertical;
+        container.sizingInfo.geometry = QRect(column * columnWidth, 0, columnWidth, size);
+
+        for (int row = 0; row < numRows; ++row) {
+            ItemRecord item;
+            item.isNull = false;
+            item.isVisible = true;
+            item.objectName = QStringLiteral("%1-%2").arg(column).arg(row);
+            item.guestId = QUuid::createUuid().toString();
+            item.sizingInfo.geometry = QRect(0, row * rowHeight, columnWidth, rowHeight);
+            item.sizingInfo.minSize = QSize(10, 10);
+            item.sizingInfo.maxSizeHint = QSize(16777215, 16777215);
+            container.children.push_back(item);
+        }
+
+        root.children.push_back(container);
+    }
+
+    return root;
+}
+
+void BenchMultiSplitter::bench_itemRecordFromJson_data()
+{
+    QTest::addColumn<bool>("streaming");
+
+    QTest::newRow("JsonStreamReader") << true;
+    QTest::newRow("QJsonDocument and QVariantMap") << false;
+}
+
+void BenchMultiSplitter::bench_itemRecordFromJson()
+{
+    // Reads a layout of more than 1 MB. Either in a single pass, or like LayoutSaver used to, by
+    // parsing into a QJsonDocument, converting it to a QVariantMap and then reading that.
+    QFETCH(bool, streaming);
+
+    const QByteArray json = QJsonDocument::fromVariant(createGridRecord(40, 40).toVariantMap()).toJson();
+    QVERIFY(json.size() > 1024 * 1024);
+
+    ItemRecord record;
+    QBENCHMARK {
+        if (streaming) {
+            JsonStreamReader reader(json);
+            record.fromJsonStream(reader);
+        } else {
+            record.fromVariantMap(QJsonDocument::fromJson(json).toVariant().toMap());
+        }
+    }
+
+    QCOMPARE(record.children.size(), 40);
+    QCOMPARE(record.children.constFirst().children.size(), 40);
+}
+
+QTEST_MAIN(BenchMultiSplitter)
+
+#include "bench_multisplitter.moc"
@@ -18,6 +18,7 @@
 #include "DockWidgetBase_p.h"
 #include "DropAreaWithCentralFrame_p.h"
 #include "Frame_p.h"
+#include "LayoutHistory.h"
 #include "LayoutSaver_p.h"
 #include "MDILayoutWidget_p.h"
 #include "MainWindowMDI.h"
@@ -29,9 +30,14 @@
 #include "MDIArea.h"
 #include "multisplitter/Separator_p.h"
 #include "multisplitter/Item_p.h"
+#include "multisplitter/PerfCounters_p.h"
+#include "private/AffinitySet_p.h"
+#include "private/LayoutLibrary_p.h"
 #include "private/MultiSplitter_p.h"
 
 #include <QAction>
+#include <QExposeEvent>
+#include <QFile>
 
 #ifdef Q_OS_WIN
 #include <windows.h>
@@ -1006,6 +1012,55 @@ void TestDocks::tst_hoverShowsDropIndicators()
 
     QCOMPARE(dock0->dptr()->frame()->dockWidgetCount(), 2);
 }
+
+void TestDocks::tst_asyncFrameIncubation()
+{
+    EnsureTopLevelsDeleted e;
+
+    // A controller which never incubates by itself, so we control when the QML is ready
+    QQmlIncubationController controller;
+    QQmlEngine *engine = Config::self().qmlEngine();
+    engine->setIncubationController(&controller);
+    Config::self().setAsyncFrameIncubation(true);
+
+    auto dock1 = createDockWidget("dock1", new MyWidget2(QSize(400, 400)));
+    auto frame = qobject_cast<FrameQuick *>(dock1->dptr()->frame());
+    QVERIFY(frame);
+    QVERIFY(!frame->visualItem());
+    QCOMPARE(frame->dockWidgetCount(), 1);
+    QVERIFY(dock1->parentItem() == frame);
+
+    frame->completeVisualItem();
+    QVERIFY(frame->visualItem());
+    QVERIFY(dock1->parentItem() != frame);
+    QCOMPARE(frame->dockWidgetCount(), 1);
+
+    Config::self().setAsyncFrameIncubation(false);
+    engine->setIncubationController(nullptr);
+
+    delete dock1->window();
+}
+
+void TestDocks::tst_adapterReceivesItsWindowEvents()
+{
+    // Tests that QWidgetAdapter follows its window, as it no longer filters all app events
+    EnsureTopLevelsDeleted e;
+
+    const int originalCount = QWidgetAdapter::numAdaptersWithWindowEvents();
+    QQuickView view;
+    auto adapter = new QWidgetAdapter();
+    QCOMPARE(QWidgetAdapter::numAdaptersWithWindowEvents(), originalCount);
+
+    adapter->setParentItem(view.contentItem());
+    QCOMPARE(QWidgetAdapter::numAdaptersWithWindowEvents(), originalCount + 1);
+
+    adapter->setParentItem(nullptr);
+    QCOMPARE(QWidgetAdapter::numAdaptersWithWindowEvents(), originalCount);
+
+    adapter->setParentItem(view.contentItem());
+    delete adapter;
+    QCOMPARE(QWidgetAdapter::numAdaptersWithWindowEvents(), originalCount);
+}
 #endif
 
 void TestDocks::tst_28NestedWidgets_data()
@@ -2797,6 +2852,47 @@ void TestDocks::tst_isFocused()
     delete dock2->window();
 }
 
+void TestDocks::tst_focusChangeOnlyNotifiesAffectedScopes()
+{
+    EnsureTopLevelsDeleted e;
+    auto m = createMainWindow(QSize(800, 500), MainWindowOption_None);
+    auto dock1 = createDockWidget(QStringLiteral("dock1"), new FocusableWidget());
+    auto dock2 = createDockWidget(QStringLiteral("dock2"), new FocusableWidget());
+    auto dock3 = createDockWidget(QStringLiteral("dock3"), new FocusableWidget());
+    m->addDockWidget(dock1, Location_OnLeft);
+    m->addDockWidget(dock2, Location_OnRight);
+    m->addDockWidget(dock3, Location_OnBottom);
+
+    Frame *frame1 = dock1->dptr()->frame();
+    Frame *frame2 = dock2->dptr()->frame();
+    Frame *frame3 = dock3->dptr()->frame();
+
+    dock1->raiseAndActivate();
+    if (!m->windowHandle()->isActive())
+        Testing::waitForEvent(m->windowHandle(), QEvent::WindowActivate);
+
+    dock1->widget()->setFocus(Qt::OtherFocusReason);
+    Testing::waitForEvent(dock1->widget(), QEvent::FocusIn);
+    QVERIFY(frame1->isFocused());
+    QVERIFY(!frame2->isFocused());
+    QVERIFY(!frame3->isFocused());
+
+    QSignalSpy spy1(frame1, &Frame::isFocusedChanged);
+    QSignalSpy spy2(frame2, &Frame::isFocusedChanged);
+    QSignalSpy spy3(frame3, &Frame::isFocusedChanged);
+
+    // Focus moves from frame1 to frame2. frame3 isn't involved, so isn't notified
+    dock2->widget()->setFocus(Qt::OtherFocusReason);
+    Testing::waitForEvent(dock2->widget(), QEvent::FocusIn);
+    QVERIFY(!frame1->isFocused());
+    QVERIFY(frame2->isFocused());
+    QVERIFY(!frame3->isFocused());
+    QCOMPARE(spy1.count(), 1);
+    QCOMPARE(spy2.count(), 1);
+    QCOMPARE(spy3.count(), 0);
+    QVERIFY(dock2->isFocused());
+}
+
 void TestDocks::tst_setWidget()
 {
     EnsureTopLevelsDeleted e;
@@ -5718,6 +5814,47 @@ void TestDocks::tst_overlayCrash()
     pressOn(tb->mapToGlobal(QPoint(5, 5)), tb);
 }
 
+void TestDocks::tst_overlayFrameIsReused()
+{
+    EnsureTopLevelsDeleted e;
+    KDDockWidgets::Config::self().setFlags(KDDockWidgets::Config::Flag_AutoHideSupport);
+
+    auto m1 = createMainWindow(QSize(1000, 1000), MainWindowOption_None, "MW1");
+    auto dw1 = new DockWidgetType(QStringLiteral("1"));
+    auto dw2 = new DockWidgetType(QStringLiteral("2"));
+    m1->addDockWidget(dw1, Location_OnBottom);
+    m1->addDockWidget(dw2, Location_OnTop);
+
+    m1->moveToSideBar(dw1, SideBarLocation::South);
+    m1->moveToSideBar(dw2, SideBarLocation::North);
+
+    m1->overlayOnSideBar(dw1);
+    QPointer<Frame> frame = dw1->dptr()->frame();
+    QVERIFY(frame->isOverlayed());
+
+    m1->overlayOnSideBar(dw2);
+    QVERIFY(!dw1->isOverlayed());
+    QVERIFY(dw2->isOverlayed());
+    QCOMPARE(dw2->dptr()->frame(), frame.data());
+    QCOMPARE(frame->dockWidgetCount(), 1);
+
+    m1->clearSideBarOverlay();
+    QVERIFY(!dw2->isOverlayed());
+    QVERIFY(frame);
+    QVERIFY(!frame->isVisible());
+
+    // Floating it hands the frame over, so the next overlay gets a new one
+    m1->overlayOnSideBar(dw1);
+    QCOMPARE(dw1->dptr()->frame(), frame.data());
+    dw1->setFloating(true);
+    QVERIFY(!frame->isOverlayed());
+    m1->overlayOnSideBar(dw2);
+    QVERIFY(dw2->dptr()->frame() != frame.data());
+
+    delete dw1;
+    delete dw2;
+}
+
 void TestDocks::tst_embeddedMainWindow()
 {
     EnsureTopLevelsDeleted e;
@@ -7852,3 +7989,653 @@ void TestDocks::tst_persistentCentralWidget()
 
     QVERIFY(saver.restoreLayout(saved));
 }
+
+void TestDocks::tst_placeholderCompaction()
+{
+    EnsureTopLevelsDeleted e;
+    auto m = createMainWindow(QSize(800, 500), MainWindowOption_None);
+    auto layout = m->multiSplitter();
+    auto dock1 = createDockWidget("dock1", new MyWidget("dock1"));
+    auto dock2 = createDockWidget("dock2", new MyWidget("dock2"));
+    auto dock3 = createDockWidget("dock3", new MyWidget("dock3"));
+    m->addDockWidget(dock1, Location_OnLeft);
+    m->addDockWidget(dock2, Location_OnRight);
+    m->addDockWidget(dock3, Location_OnBottom, dock2);
+
+    auto f1 = dock1->dptr()->frame();
+    auto f3 = dock3->dptr()->frame();
+    dock1->close();
+    dock3->close();
+    QVERIFY(Testing::waitForDeleted(f1));
+    QVERIFY(Testing::waitForDeleted(f3));
+    QCOMPARE(layout->placeholderCount(), 2);
+
+    // Without a policy nothing is pruned
+    QCOMPARE(DockRegistry::self()->compactPlaceholders(), 0);
+    QCOMPARE(layout->placeholderCount(), 2);
+
+    Config::self().setPlaceholderCompactionPolicy(0, 1);
+    QTest::qWait(50);
+
+    // Only the closed dock widgets lose their placeholders
+    QCOMPARE(DockRegistry::self()->compactPlaceholders(), 2);
+    QCOMPARE(layout->placeholderCount(), 0);
+    QCOMPARE(layout->count(), 1);
+    QVERIFY(layout->checkSanity());
+    QVERIFY(!dock1->dptr()->lastPosition()->isValid());
+    QVERIFY(dock2->dptr()->lastPosition()->isValid());
+    QVERIFY(dock2->isOpen());
+
+    // With a maximum count, the least recently occupied placeholders go first, even if they
+    // were added later
+    Config::self().setPlaceholderCompactionPolicy(0, 0);
+    m->addDockWidget(dock1, Location_OnLeft);
+    Layouting::Item *mainWindowItem = dock1->dptr()->frame()->layoutItem();
+    QVERIFY(mainWindowItem);
+
+    QTest::qWait(10);
+    dock1->setFloating(true);
+    auto dock4 = createDockWidget("dock4", new MyWidget("dock4"));
+    dock1->addDockWidgetToContainingWindow(dock4, Location_OnRight);
+    Layouting::Item *floatingItem = dock1->dptr()->frame()->layoutItem();
+    QVERIFY(floatingItem);
+    QVERIFY(floatingItem != mainWindowItem);
+
+    QTest::qWait(10);
+    dock1->setFloating(false);
+    QCOMPARE(dock1->dptr()->frame()->layoutItem(), mainWindowItem);
+    QTest::qWait(10);
+    dock1->close();
+
+    Position::Ptr pos = dock1->dptr()->lastPosition();
+    QVERIFY(pos->containsPlaceholder(mainWindowItem));
+    QVERIFY(pos->containsPlaceholder(floatingItem));
+
+    Config::self().setPlaceholderCompactionPolicy(1, 0);
+    QCOMPARE(DockRegistry::self()->compactPlaceholders(), 1);
+    QVERIFY(pos->containsPlaceholder(mainWindowItem));
+    QVERIFY(!pos->containsPlaceholder(floatingItem));
+    QVERIFY(layout->checkSanity());
+
+    Config::self().setPlaceholderCompactionPolicy(0, 0);
+    delete dock1;
+    delete dock3;
+}
+
+void TestDocks::tst_chromeUpdatesAreCoalesced()
+{
+    EnsureTopLevelsDeleted e;
+    using Layouting::PerfCounters;
+
+    auto addTabs = [](const QString &prefix, bool batched, quint64 &numUpdates, quint64 &numUpdatesInsideBatch) {
+        auto dock1 = createDockWidget(prefix + QStringLiteral("1"), new MyWidget(prefix));
+        const quint64 before = PerfCounters::value(PerfCounters::Counter_TitleBarVisibilityUpdates);
+        {
+            QScopedPointer<ChromeUpdateBatch> batch(batched ? new ChromeUpdateBatch() : nullptr);
+            for (int i = 2; i <= 5; ++i) {
+                const QString name = prefix + QString::number(i);
+                dock1->addDockWidgetAsTab(createDockWidget(name, new MyWidget(name)));
+            }
+
+            numUpdatesInsideBatch = PerfCounters::value(PerfCounters::Counter_TitleBarVisibilityUpdates) - before;
+        }
+        numUpdates = PerfCounters::value(PerfCounters::Counter_TitleBarVisibilityUpdates) - before;
+        return dock1;
+    };
+
+    quint64 unbatchedUpdates = 0;
+    quint64 batchedUpdates = 0;
+    quint64 updatesInsideBatch = 0;
+    DockWidgetBase *unbatched = addTabs(QStringLiteral("unbatched"), false, unbatchedUpdates, updatesInsideBatch);
+    QVERIFY(updatesInsideBatch > 0);
+    DockWidgetBase *batched = addTabs(QStringLiteral("batched"), true, batchedUpdates, updatesInsideBatch);
+    QVERIFY(batchedUpdates < unbatchedUpdates);
+
+    // Nothing is updated until the batch ends
+    QCOMPARE(updatesInsideBatch, quint64(0));
+    QVERIFY(batchedUpdates > 0);
+
+    // The end result is the same
+    Frame *unbatchedFrame = unbatched->dptr()->frame();
+    Frame *batchedFrame = batched->dptr()->frame();
+    QCOMPARE(batchedFrame->dockWidgetCount(), 5);
+    QCOMPARE(batchedFrame->titleBar()->isVisible(), unbatchedFrame->titleBar()->isVisible());
+    QCOMPARE(batchedFrame->floatingWindow()->titleBar()->isVisible(), unbatchedFrame->floatingWindow()->titleBar()->isVisible());
+    QCOMPARE(batched->floatAction()->isChecked(), unbatched->floatAction()->isChecked());
+
+    // Tabbing a whole floating window into a frame batches internally. Otherwise each of the 5
+    // dock widgets moved would update both frames, 9 updates at least.
+    const quint64 beforeDrop = PerfCounters::value(PerfCounters::Counter_TitleBarVisibilityUpdates);
+    unbatchedFrame->addWidget(batchedFrame->floatingWindow());
+    QCOMPARE(unbatchedFrame->dockWidgetCount(), 10);
+    QVERIFY(PerfCounters::value(PerfCounters::Counter_TitleBarVisibilityUpdates) - beforeDrop < 5);
+    QVERIFY(Testing::waitForDeleted(batchedFrame));
+    batchedFrame = unbatchedFrame;
+
+    // Updates queued by hand are resolved by a synchronous flush, even inside a batch. The frame
+    // queues its floating window while flushing, which must not be queued again.
+    QVERIFY(batchedFrame->floatingWindow());
+    DockRegistry::self()->beginChromeUpdateBatch();
+    DockRegistry::self()->scheduleChromeUpdate(batchedFrame);
+    DockRegistry::self()->scheduleChromeUpdate(batchedFrame->floatingWindow());
+    const quint64 before = PerfCounters::value(PerfCounters::Counter_TitleBarVisibilityUpdates);
+    DockRegistry::self()->flushChromeUpdates(); // Returns, even with the batch still open
+    const quint64 afterFlush = PerfCounters::value(PerfCounters::Counter_TitleBarVisibilityUpdates);
+    QVERIFY(afterFlush > before);
+
+    // Nothing was left pending for the end of the batch
+    DockRegistry::self()->endChromeUpdateBatch();
+    QCOMPARE(PerfCounters::value(PerfCounters::Counter_TitleBarVisibilityUpdates), afterFlush);
+
+    for (auto dw : DockRegistry::self()->dockwidgets())
+        delete dw;
+}
+
+void TestDocks::tst_isSaneTracksNames()
+{
+    EnsureTopLevelsDeleted e;
+    DockRegistry *registry = DockRegistry::self();
+    auto dock1 = createDockWidget("dup", new MyWidget("dup"));
+    QVERIFY(registry->isSane());
+
+    DockWidgetBase *dock2 = nullptr;
+    {
+        SetExpectedWarning sew("already exists");
+        dock2 = new DockWidgetType(QStringLiteral("dup"));
+    }
+
+    {
+        SetExpectedWarning sew("duplicate names");
+        QVERIFY(!registry->isSane());
+    }
+
+    // Lookups keep returning the first one registered
+    QVERIFY(registry->dockByName(QStringLiteral("dup")) == dock1);
+
+    // Until it's gone, then the duplicate takes its place
+    delete dock1;
+    QVERIFY(registry->isSane());
+    QVERIFY(registry->dockByName(QStringLiteral("dup")) == dock2);
+    delete dock2;
+}
+
+void TestDocks::tst_affinitySet()
+{
+    // AffinitySet must match exactly like DockRegistry::affinitiesMatch()
+    QVector<QStringList> lists = { {},
+                                   { QStringLiteral("a") },
+                                   { QStringLiteral("b") },
+                                   { QStringLiteral("a"), QStringLiteral("b") },
+                                   { QStringLiteral("c"), QString() },
+                                   { QString() } };
+
+    // Also exercise ids beyond the 64 bit mask
+    QStringList many;
+    for (int i = 0; i < 70; ++i)
+        many << QStringLiteral("affinity%1").arg(i);
+    lists << many << QStringList { many.last() } << QStringList { many.last(), QStringLiteral("b") }
+          << QStringList { many.at(68) };
+
+    for (const QStringList &l1 : qAsConst(lists)) {
+        for (const QStringList &l2 : qAsConst(lists)) {
+            QCOMPARE(AffinitySet(l1).matches(AffinitySet(l2)), DockRegistry::self()->affinitiesMatch(l1, l2));
+        }
+    }
+
+    QVERIFY(AffinitySet(QStringList { QStringLiteral("a"), QStringLiteral("b") }) == AffinitySet(QStringList { QStringLiteral("b"), QStringLiteral("a") }));
+
+    // Objects keep their set in sync with the string list
+    EnsureTopLevelsDeleted e;
+    auto m = createMainWindow(QSize(500, 500), MainWindowOption_None, QStringLiteral("mainWindowAffinitySet"));
+    m->setAffinities({ QStringLiteral("a") });
+    auto dock1 = createDockWidget("dockAffinitySet1", new MyWidget("dock1"));
+    dock1->setAffinities({ QStringLiteral("b") });
+    auto dock2 = createDockWidget("dockAffinitySet2", new MyWidget("dock2"));
+    dock2->setAffinities({ QStringLiteral("a") });
+
+    QVERIFY(DockRegistry::self()->mainWindowsWithAffinity({ QStringLiteral("a") }).contains(m.get()));
+    QVERIFY(DockRegistry::self()->mainWindowsWithAffinity({ QStringLiteral("b") }).isEmpty());
+
+    m->addDockWidget(dock2, Location_OnLeft);
+    QVERIFY(dock2->dptr()->frame()->affinitySet() == AffinitySet(QStringList { QStringLiteral("a") }));
+
+    {
+        SetExpectedWarning sew("Refusing to dock widget with incompatible affinity");
+        m->addDockWidget(dock1, Location_OnRight);
+    }
+    QVERIFY(dock1->isFloating());
+
+    delete dock1;
+    delete dock2;
+}
+
+void TestDocks::tst_renderVisibility()
+{
+    EnsureTopLevelsDeleted e;
+    using RenderVisibility = DockWidgetBase::RenderVisibility;
+
+    auto dock1 = createDockWidget("dock1", new MyWidget("dock1"));
+    QCOMPARE(dock1->renderVisibility(), RenderVisibility::Visible);
+
+    QSignalSpy spy(dock1, &DockWidgetBase::renderVisibilityChanged);
+    auto dock2 = createDockWidget("dock2", new MyWidget("dock2"), {}, {}, /*show=*/false);
+    QCOMPARE(dock2->renderVisibility(), RenderVisibility::Closed);
+
+    dock1->addDockWidgetAsTab(dock2);
+    QCOMPARE(dock2->renderVisibility(), RenderVisibility::Visible);
+    QCOMPARE(dock1->renderVisibility(), RenderVisibility::TabHidden);
+    QVERIFY(spy.count() >= 1);
+
+    dock1->setAsCurrentTab();
+    QCOMPARE(dock1->renderVisibility(), RenderVisibility::Visible);
+    QCOMPARE(dock2->renderVisibility(), RenderVisibility::TabHidden);
+
+    dock1->close();
+    QCOMPARE(dock1->renderVisibility(), RenderVisibility::Closed);
+    QCOMPARE(dock2->renderVisibility(), RenderVisibility::Visible);
+
+    delete dock1;
+    delete dock2;
+}
+
+void TestDocks::tst_guestHibernation()
+{
+    EnsureTopLevelsDeleted e;
+
+    auto dock1 = createDockWidget("dock1", new MyWidget("dock1"));
+    auto dock2 = createDockWidget("dock2", new MyWidget("dock2"), {}, {}, /*show=*/false);
+    dock1->addDockWidgetAsTab(dock2);
+
+    // Without functions to serialize and recreate the guest, nothing happens
+    Config::self().setGuestHibernationPolicy(0, 1);
+    QCOMPARE(DockRegistry::self()->hibernateGuests(), 0);
+
+    Config::self().setGuestHibernationFuncs(
+        [](DockWidgetBase *dw) {
+            return QVariant(dw->uniqueName());
+        },
+        [](DockWidgetBase *dw, const QVariant &state) {
+            dw->setWidget(new MyWidget(state.toString()));
+        });
+
+    // dock1 is in a background tab, so it's the one hibernated
+    QCOMPARE(DockRegistry::self()->hibernateGuests(), 1);
+    QVERIFY(dock1->isHibernated());
+    QVERIFY(!dock1->widget());
+    QVERIFY(!dock2->isHibernated());
+    QVERIFY(dock2->widget());
+    QCOMPARE(dock1->dptr()->frame(), dock2->dptr()->frame());
+
+    // Within budget now
+    QCOMPARE(DockRegistry::self()->hibernateGuests(), 0);
+
+    // Becoming current recreates it
+    dock1->setAsCurrentTab();
+    QVERIFY(!dock1->isHibernated());
+    QVERIFY(dock1->widget());
+
+    // Without a budget, only guests hidden for long enough are hibernated, by the periodic pass
+    Config::self().setGuestHibernationPolicy(500, 0);
+    QCOMPARE(DockRegistry::self()->hibernateGuests(), 0);
+    QVERIFY(!dock2->isHibernated());
+    QTRY_VERIFY(dock2->isHibernated());
+    QVERIFY(!dock1->isHibernated());
+    QVERIFY(dock1->widget());
+
+    Config::self().setGuestHibernationFuncs(nullptr, nullptr);
+    Config::self().setGuestHibernationPolicy(0, 0);
+    delete dock1;
+    delete dock2;
+}
+
+void TestDocks::tst_floatingWindowZOrder()
+{
+    EnsureTopLevelsDeleted e;
+    auto registry = DockRegistry::self();
+
+    auto dock1 = createDockWidget("dock1", new MyWidget("dock1"));
+    auto dock2 = createDockWidget("dock2", new MyWidget("dock2"));
+    auto dock3 = createDockWidget("dock3", new MyWidget("dock3"));
+    FloatingWindow *fw1 = dock1->floatingWindow();
+    FloatingWindow *fw2 = dock2->floatingWindow();
+    FloatingWindow *fw3 = dock3->floatingWindow();
+
+    QCOMPARE(registry->floatingWindowForHandle(fw1->windowHandle()), fw1);
+    QCOMPARE(registry->floatingWindowForHandle(fw3->windowHandle()), fw3);
+    QVERIFY(!registry->floatingWindowForHandle(static_cast<QWindow *>(nullptr)));
+
+    for (FloatingWindow *fw : { fw1, fw2, fw3 })
+        QVERIFY(registry->floatingWindowsBoundingRect().contains(fw->windowHandle()->geometry()));
+
+    // An exposed window goes on top
+    QExposeEvent ev(QRegion(QRect(QPoint(0, 0), fw1->windowHandle()->size())));
+    qApp->sendEvent(fw1->windowHandle(), &ev);
+    QCOMPARE(registry->floatingWindows().last(), fw1);
+    QCOMPARE(registry->floatingWindows().size(), 3);
+
+    // Moving a window updates the cached bounding rect
+    const QRect newGeometry(QPoint(5000, 5000), fw2->windowHandle()->size());
+    fw2->windowHandle()->setGeometry(newGeometry);
+    QTRY_VERIFY(registry->floatingWindowsBoundingRect().contains(newGeometry));
+
+    // While dragging, the window being dragged is left out, as it's always under the cursor
+    const QRect othersRect = registry->floatingWindowsBoundingRect(fw2);
+    QVERIFY(!othersRect.intersects(newGeometry));
+    QVERIFY(othersRect.contains(fw1->windowHandle()->geometry()));
+    QVERIFY(othersRect.contains(fw3->windowHandle()->geometry()));
+    fw2->windowHandle()->setGeometry(newGeometry.translated(100, 100));
+    QTRY_VERIFY(registry->floatingWindowsBoundingRect().contains(newGeometry.translated(100, 100)));
+    QCOMPARE(registry->floatingWindowsBoundingRect(fw2), othersRect);
+
+    delete fw1;
+    QCOMPARE(registry->floatingWindows().size(), 2);
+    QVERIFY(!registry->floatingWindows().contains(fw1));
+    delete fw2;
+    delete fw3;
+}
+
+void TestDocks::tst_coalescedLayoutResize()
+{
+    EnsureTopLevelsDeleted e;
+    auto m = createMainWindow(QSize(800, 500), MainWindowOption_None);
+    auto layout = m->multiSplitter();
+    auto dock1 = createDockWidget("dock1", new MyWidget("dock1"));
+    auto dock2 = createDockWidget("dock2", new MyWidget("dock2"));
+    m->addDockWidget(dock1, Location_OnLeft);
+    m->addDockWidget(dock2, Location_OnRight);
+    QCOMPARE(layout->QWidgetAdapter::size(), layout->size());
+
+    Config::self().setCoalescedLayoutResize(true, /*guestTolerance=*/5);
+    QVERIFY(Config::self().coalescedLayoutResize());
+    QCOMPARE(Config::self().coalescedLayoutResizeTolerance(), 5);
+
+    // A burst of resizes only relayouts once it gets to the event loop
+    const QSize oldLayoutSize = layout->size();
+    for (int i = 1; i <= 10; ++i)
+        m->resize(m->size() + QSize(1, 0));
+    QCOMPARE(layout->size(), oldLayoutSize);
+    QTRY_COMPARE(layout->size(), layout->QWidgetAdapter::size());
+
+    // Once it settles the guests have their exact geometry
+    auto frame2 = dock2->dptr()->frame();
+    auto item2 = layout->itemForFrame(frame2);
+    QTRY_COMPARE(frame2->QWidgetAdapter::geometry(), item2->mapToRoot(item2->rect()));
+    QVERIFY(layout->checkSanity());
+
+    // Setting the layout size explicitly applies any pending resize first
+    m->resize(m->size() + QSize(10, 10));
+    QVERIFY(layout->size() != layout->QWidgetAdapter::size());
+    layout->flushCoalescedResize();
+    QCOMPARE(layout->size(), layout->QWidgetAdapter::size());
+    QCOMPARE(frame2->QWidgetAdapter::geometry(), item2->mapToRoot(item2->rect()));
+
+    Config::self().setCoalescedLayoutResize(false);
+}
+
+void TestDocks::tst_mdiZOrder()
+{
+    EnsureTopLevelsDeleted e;
+    auto m = createMainWindow(QSize(800, 500), MainWindowOption_MDI);
+    auto layout = qobject_cast<MDILayoutWidget *>(m->layoutWidget());
+    auto dock1 = createDockWidget("dock1", new MyWidget2(QSize(200, 200)));
+    auto dock2 = createDockWidget("dock2", new MyWidget2(QSize(200, 200)));
+    auto dock3 = createDockWidget("dock3", new MyWidget2(QSize(200, 200)));
+    layout->addDockWidget(dock1, QPoint(0, 0));
+    layout->addDockWidget(dock2, QPoint(50, 50));
+    layout->addDockWidget(dock3, QPoint(400, 0));
+
+    Frame *frame1 = dock1->d->frame();
+    Frame *frame2 = dock2->d->frame();
+    Frame *frame3 = dock3->d->frame();
+    QCOMPARE(layout->itemForFrame(frame2), frame2->layoutItem());
+
+    // Newest on top
+    QCOMPARE(layout->framesInZOrder(), QList<Frame *>({ frame1, frame2, frame3 }));
+    QCOMPARE(layout->frameAt(QPoint(60, 60)), frame2);
+    QCOMPARE(layout->frameAt(QPoint(10, 10)), frame1);
+    QCOMPARE(layout->frameAt(QPoint(450, 10)), frame3);
+    QVERIFY(!layout->frameAt(QPoint(10, 450)));
+
+    dock1->raise();
+    QCOMPARE(layout->framesInZOrder(), QList<Frame *>({ frame2, frame3, frame1 }));
+    QCOMPARE(layout->frameAt(QPoint(60, 60)), frame1);
+
+    // Moving a frame updates the hit-testing
+    layout->moveDockWidget(frame3, QPoint(0, 300));
+    QCOMPARE(layout->frameAt(QPoint(10, 310)), frame3);
+    QVERIFY(!layout->frameAt(QPoint(450, 10)));
+
+    // Frames can be dragged partially outside, to negative positions
+    layout->moveDockWidget(frame3, QPoint(-300, -100));
+    QCOMPARE(layout->frameAt(QPoint(-290, -90)), frame3);
+    QVERIFY(!layout->frameAt(QPoint(-310, -90)));
+    QVERIFY(!layout->frameAt(QPoint(-290, -110)));
+    layout->moveDockWidget(frame3, QPoint(0, 300));
+
+    // A margin catches the cursor just outside a frame, for resizing
+    const QRect geo3 = layout->itemForFrame(frame3)->geometry();
+    const QPoint nearFrame3(geo3.left() - 2, geo3.center().y());
+    QVERIFY(!layout->frameAt(nearFrame3));
+    QCOMPARE(layout->frameAt(nearFrame3, 4), frame3);
+    QVERIFY(!layout->frameAt(nearFrame3 - QPoint(5, 0), 4));
+
+    // The layout is saved bottom to top
+    const LayoutSaver::MultiSplitter serialized = layout->serialize();
+    QStringList savedIds;
+    for (const Layouting::ItemRecord &child : serialized.layout.children)
+        savedIds << child.guestId;
+    QCOMPARE(savedIds, QStringList({ frame2->id(), frame3->id(), frame1->id() }));
+
+    // Restoring brings back the z-order and the geometries
+    const QVector<DockWidgetBase *> docks = { dock1, dock2, dock3 };
+    QVector<QRect> geometries;
+    for (DockWidgetBase *dock : docks)
+        geometries << layout->itemForFrame(MDILayoutWidget::frameForDockWidget(dock))->geometry();
+
+    LayoutSaver saver;
+    const QByteArray saved = saver.serializeLayout();
+    dock2->raise();
+    layout->moveDockWidget(frame1, QPoint(100, 100));
+    QVERIFY(saver.restoreLayout(saved));
+
+    QCOMPARE(layout->framesInZOrder(), QList<Frame *>({ MDILayoutWidget::frameForDockWidget(dock2),
+                                                         MDILayoutWidget::frameForDockWidget(dock3),
+                                                         MDILayoutWidget::frameForDockWidget(dock1) }));
+    for (int i = 0; i < docks.size(); ++i) {
+        Frame *frame = MDILayoutWidget::frameForDockWidget(docks.at(i));
+        QCOMPARE(layout->itemForFrame(frame)->geometry(), geometries.at(i));
+        QCOMPARE(frame->QWidgetAdapter::geometry(), geometries.at(i));
+    }
+    QCOMPARE(layout->frameAt(QPoint(60, 60)), MDILayoutWidget::frameForDockWidget(dock1));
+
+    QVERIFY(!DockRegistry::self()->frameInMDIResize());
+}
+
+void TestDocks::tst_mdiBatchedGeometries()
+{
+    EnsureTopLevelsDeleted e;
+    auto m = createMainWindow(QSize(800, 500), MainWindowOption_MDI);
+    auto layout = qobject_cast<MDILayoutWidget *>(m->layoutWidget());
+    QVector<Frame *> frames;
+    for (int i = 0; i < 5; ++i) {
+        auto dock = createDockWidget(QStringLiteral("dock%1").arg(i), new MyWidget2(QSize(100, 100)));
+        layout->addDockWidget(dock, QPoint(i * 10, i * 10));
+        frames << MDILayoutWidget::frameForDockWidget(dock);
+    }
+
+    const QRect rect0(300, 10, 300, 250);
+    const QRect rect1(10, 200, 250, 250);
+    layout->setDockWidgetGeometries({ { frames.at(0), rect0, 1 },
+                                      { frames.at(1), rect1, 0 },
+                                      { frames.at(2), QRect(20, 20, 1, 1), -1 } });
+    QCOMPARE(layout->itemForFrame(frames.at(0))->geometry(), rect0);
+    QCOMPARE(frames.at(0)->QWidgetAdapter::geometry(), rect0);
+    QCOMPARE(layout->itemForFrame(frames.at(1))->geometry(), rect1);
+    // Min size is honoured
+    QCOMPARE(frames.at(2)->QWidgetAdapter::size(), frames.at(2)->minimumSize());
+    // Highest z ends on top
+    QCOMPARE(layout->framesInZOrder().mid(3), QList<Frame *>({ frames.at(1), frames.at(0) }));
+
+    // Tiling covers the area without overlaps
+    layout->tileDockWidgets();
+    QRegion covered;
+    for (Frame *frame : qAsConst(frames)) {
+        const QRect geo = layout->itemForFrame(frame)->geometry();
+        QVERIFY(!covered.intersects(geo));
+        covered += geo;
+    }
+    QCOMPARE(covered, QRegion(QRect(QPoint(0, 0), layout->size())));
+
+    // Cascading keeps the stacking, the topmost frame is the furthest from the origin
+    const QList<Frame *> zOrder = layout->framesInZOrder();
+    layout->cascadeDockWidgets();
+    QCOMPARE(layout->framesInZOrder(), zOrder);
+    for (int i = 1; i < zOrder.size(); ++i) {
+        const QRect below = layout->itemForFrame(zOrder.at(i - 1))->geometry();
+        const QRect above = layout->itemForFrame(zOrder.at(i))->geometry();
+        QVERIFY(above.topLeft().x() > below.topLeft().x());
+        QCOMPARE(above.size(), below.size());
+    }
+}
+
+void TestDocks::tst_layoutLibrary()
+{
+    EnsureTopLevelsDeleted e;
+    const QString filename = QStringLiteral("layout_tst_layoutLibrary.kddwlib");
+    QFile::remove(filename);
+
+    auto m = createMainWindow(QSize(800, 500), MainWindowOption_None);
+    auto dock1 = createDockWidget("dock1", new MyWidget2(QSize(100, 100)));
+    auto dock2 = createDockWidget("dock2", new MyWidget2(QSize(100, 100)));
+    m->addDockWidget(dock1, Location_OnTop);
+    m->addDockWidget(dock2, Location_OnBottom);
+
+    LayoutSaver saver;
+    QVERIFY(saver.saveToLibrary(filename, QStringLiteral("docked")));
+    dock2->setFloating(true);
+    QVERIFY(saver.saveToLibrary(filename, QStringLiteral("floating")));
+    const QStringList names = { QStringLiteral("docked"), QStringLiteral("floating") };
+    QCOMPARE(LayoutSaver::libraryLayoutNames(filename), names);
+
+    // Replacing a layout keeps its position in the index
+    dock2->setFloating(false);
+    dock1->close();
+    QVERIFY(saver.saveToLibrary(filename, QStringLiteral("docked")));
+    QCOMPARE(LayoutSaver::libraryLayoutNames(filename), names);
+
+    QVERIFY(saver.restoreFromLibrary(filename, QStringLiteral("floating")));
+    QVERIFY(dock1->isOpen());
+    QVERIFY(dock2->isFloating());
+    QVERIFY(saver.restoreFromLibrary(filename, QStringLiteral("docked")));
+    QVERIFY(!dock1->isOpen());
+    QVERIFY(!dock2->isFloating());
+
+    QVERIFY(LayoutSaver::removeFromLibrary(filename, QStringLiteral("floating")));
+    QCOMPARE(LayoutSaver::libraryLayoutNames(filename), QStringList(QStringLiteral("docked")));
+
+    quint64 offset = 0;
+    {
+        LayoutLibrary library(filename);
+        QVERIFY(library.open());
+        QVERIFY(library.validate());
+        QCOMPARE(library.entries().size(), 1);
+        QCOMPARE(library.entries().at(0).formatVersion, KDDOCKWIDGETS_SERIALIZATION_VERSION);
+
+        // Layouts outlive the mapping, which insert() replaces
+        const QByteArray docked = library.layout(QStringLiteral("docked"));
+        QVERIFY(!docked.isEmpty());
+        const QByteArray dockedCopy(docked.constData(), docked.size());
+        QVERIFY(library.insert(QStringLiteral("copy"), docked, KDDOCKWIDGETS_SERIALIZATION_VERSION));
+        QCOMPARE(docked, dockedCopy);
+        QCOMPARE(library.layout(QStringLiteral("copy")), docked);
+        QVERIFY(library.remove(QStringLiteral("copy")));
+        QCOMPARE(docked, dockedCopy);
+
+        offset = library.entries().at(0).offset;
+    }
+
+    // Corrupt one byte of the layout, the checksum catches it
+    {
+        QFile f(filename);
+        QVERIFY(f.open(QIODevice::ReadWrite));
+        QVERIFY(f.seek(qint64(offset) + 10));
+        QCOMPARE(f.write("#", 1), qint64(1));
+    }
+
+    LayoutLibrary library(filename);
+    QVERIFY(library.open());
+    QVERIFY(!library.validate());
+    QVERIFY(library.layout(QStringLiteral("docked")).isEmpty());
+    library.close();
+
+    QFile::remove(filename);
+}
+
+void TestDocks::tst_layoutHistory()
+{
+    EnsureTopLevelsDeleted e;
+    auto m = createMainWindow(QSize(800, 500), MainWindowOption_None);
+    auto dock1 = createDockWidget("dock1", new MyWidget2(QSize(100, 100)));
+    auto dock2 = createDockWidget("dock2", new MyWidget2(QSize(100, 100)));
+    auto dock3 = createDockWidget("dock3", new MyWidget2(QSize(100, 100)));
+    m->addDockWidget(dock1, Location_OnTop);
+    m->addDockWidget(dock2, Location_OnBottom);
+    QPointer<FloatingWindow> fw3 = dock3->floatingWindow();
+    QVERIFY(fw3);
+
+    LayoutHistory history;
+    history.snapshot();
+    history.snapshot(); // Nothing changed, no new step
+    QCOMPARE(history.count(), 1);
+    QVERIFY(!history.canUndo());
+
+    // "Accidentally" drag dock2 out
+    dock2->setFloating(true);
+    history.snapshot();
+    QCOMPARE(history.count(), 2);
+    QVERIFY(history.canUndo());
+
+    // Only the main window and dock2 are restored, dock3's floating window is left alone
+    QVERIFY(history.undo());
+    QVERIFY(!dock2->isFloating());
+    QVERIFY(dock2->isOpen());
+    QCOMPARE(dock3->floatingWindow(), fw3.data());
+    QVERIFY(m->layoutWidget()->checkSanity());
+    QVERIFY(history.canRedo());
+
+    QVERIFY(history.redo());
+    QVERIFY(dock2->isFloating());
+    QCOMPARE(dock3->floatingWindow(), fw3.data());
+    QVERIFY(!history.canRedo());
+
+    // A snapshot right after undoing doesn't discard what can be redone
+    QVERIFY(history.undo());
+    history.snapshot();
+    QVERIFY(history.canRedo());
+
+    // Changes made without calling snapshot() aren't lost when undoing, they're the step to redo
+    dock1->setFloating(true);
+    QVERIFY(history.undo());
+    QVERIFY(!dock1->isFloating());
+    QVERIFY(history.canRedo());
+    QVERIFY(history.redo());
+    QVERIFY(dock1->isFloating());
+    QCOMPARE(history.count(), 2);
+
+    // Changes made after undoing replace what could be redone, redo() doesn't overwrite them
+    QVERIFY(history.undo());
+    QVERIFY(history.canRedo());
+    dock2->close();
+    QVERIFY(!history.redo());
+    QVERIFY(!history.canRedo());
+    QVERIFY(!dock2->isOpen());
+    QVERIFY(!dock1->isFloating());
+    QCOMPARE(history.count(), 2);
+    QVERIFY(history.canUndo());
+
+    QVERIFY(history.memoryUsage() > 0);
+    history.setMemoryBudget(0);
+    QCOMPARE(history.count(), 1);
+    QVERIFY(!history.canUndo());
+    QVERIFY(!history.canRedo());
+}
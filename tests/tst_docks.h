@@ -24,9 +24,11 @@
 
 #ifdef KDDOCKWIDGETS_QTQUICK
 #include "DockWidgetQuick.h"
+#include "quick/FrameQuick_p.h"
 #include "quick/MainWindowQuick_p.h"
 
 #include <QQmlEngine>
+#include <QQmlIncubator>
 #include <QQuickStyle>
 #include <QQmlApplicationEngine>
 #else
@@ -171,6 +173,7 @@ private Q_SLOTS:
     void tst_dockWidgetGetsFocusWhenDocked();
     void tst_setWidget();
     void tst_isFocused();
+    void tst_focusChangeOnlyNotifiesAffectedScopes();
     void tst_floatingLastPosAfterDoubleClose();
     void tst_registry();
     void tst_honourGeometryOfHiddenWindow();
@@ -246,6 +249,18 @@ private Q_SLOTS:
     void tst_addMDIDockWidget();
     void tst_redockToMDIRestoresPosition();
     void tst_persistentCentralWidget();
+    void tst_placeholderCompaction();
+    void tst_chromeUpdatesAreCoalesced();
+    void tst_isSaneTracksNames();
+    void tst_affinitySet();
+    void tst_renderVisibility();
+    void tst_guestHibernation();
+    void tst_floatingWindowZOrder();
+    void tst_coalescedLayoutResize();
+    void tst_mdiZOrder();
+    void tst_mdiBatchedGeometries();
+    void tst_layoutLibrary();
+    void tst_layoutHistory();
 
 #ifdef KDDOCKWIDGETS_QTWIDGETS
     // TODO: Port these to QtQuick
@@ -273,6 +288,7 @@ private Q_SLOTS:
     void tst_floatRemovesFromSideBar();
     void tst_overlayedGeometryIsSaved();
     void tst_overlayCrash();
+    void tst_overlayFrameIsReused();
 
     // And fix these
     void tst_floatingWindowDeleted();
@@ -292,5 +308,7 @@ private Q_SLOTS:
     void tst_restoreFloatingMaximizedState();
 #else
     void tst_hoverShowsDropIndicators();
+    void tst_asyncFrameIncubation();
+    void tst_adapterReceivesItsWindowEvents();
 #endif
 };
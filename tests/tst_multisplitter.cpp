@@ -10,15 +10,23 @@
 */
 
 #include "private/multisplitter/Item_p.h"
+#include "private/multisplitter/FlatItemTree_p.h"
+#include "private/multisplitter/JsonStreamReader_p.h"
 #include "private/multisplitter/Separator_p.h"
 #include "private/multisplitter/Widget_qwidget.h"
 #include "private/multisplitter/MultiSplitterConfig.h"
 #include "private/multisplitter/Separator_qwidget.h"
+#include "private/multisplitter/PerfCounters_p.h"
+#include "private/multisplitter/VirtualSeparator_qwidget.h"
 
+#include <QJsonDocument>
+#include <QMouseEvent>
 #include <QPainter>
+#include <QRubberBand>
 #include <QtTest/QtTest>
 
 #include <memory.h>
+#include <functional>
 
 
 // TODO: namespace
@@ -198,6 +206,16 @@ private Q_SLOTS:
     void tst_simplify();
     void tst_adjacentLayoutBorders();
     void tst_numSideBySide_recursive();
+    void tst_perfCounters();
+    void tst_separatorPool();
+    void tst_virtualSeparators();
+    void tst_virtualSeparatorsLazyResize();
+    void tst_itemAtMatchesLinearScan();
+    void tst_calculateSqueezes();
+    void tst_flatItemTree();
+    void tst_geometryObserver();
+    void tst_fastPathRestore();
+    void tst_jsonStreamReader();
 };
 
 class MyHostWidget : public QWidget, public Layouting::Widget_qwidget
@@ -1928,6 +1946,625 @@ void TestMultiSplitter::tst_numSideBySide_recursive()
     QCOMPARE(root->numSideBySide_recursive(Qt::Horizontal), 2);
 }
 
+void TestMultiSplitter::tst_perfCounters()
+{
+    PerfCounters::reset();
+    for (int i = 0; i < PerfCounters::Counter_Count; ++i)
+        QCOMPARE(PerfCounters::value(PerfCounters::Counter(i)), quint64(0));
+
+    auto root = createRoot();
+    Item *item1 = createItem();
+    Item *item2 = createItem();
+    root->insertItem(item1, Location_OnLeft);
+    root->insertItem(item2, Location_OnLeft);
+
+    QVERIFY(PerfCounters::value(PerfCounters::Counter_LayoutPasses) > 0);
+    QVERIFY(PerfCounters::value(PerfCounters::Counter_ItemSetGeometry) > 0);
+    QVERIFY(PerfCounters::value(PerfCounters::Counter_WidgetGeometryApplied) > 0);
+    QCOMPARE(PerfCounters::value(PerfCounters::Counter_SeparatorsCreated), quint64(1));
+
+    root->removeItem(item2);
+    QCOMPARE(PerfCounters::value(PerfCounters::Counter_SeparatorsDestroyed), quint64(0));
+
+    PerfCounters::reset();
+    QCOMPARE(PerfCounters::value(PerfCounters::Counter_LayoutPasses), quint64(0));
+}
+
+void TestMultiSplitter::tst_separatorPool()
+{
+    // Tests that separators are hidden and reused instead of being deleted and recreated
+    auto root = createRoot();
+    Item *item1 = createItem();
+    Item *item2 = createItem();
+    Item *item3 = createItem();
+    root->insertItem(item1, Location_OnLeft);
+    root->insertItem(item2, Location_OnLeft);
+    QCOMPARE(root->separators_recursive().size(), 1);
+    QCOMPARE(root->hostWidget()->numPooledSeparators(), 0);
+    Separator *separator = root->separators_recursive().constFirst();
+    const int numSeparators = Separator::numSeparators();
+
+    root->removeItem(item2);
+    QCOMPARE(root->separators_recursive().size(), 0);
+    QCOMPARE(root->hostWidget()->numPooledSeparators(), 1);
+    QCOMPARE(Separator::numSeparators(), numSeparators - 1);
+    QVERIFY(!separator->asWidget()->isVisible());
+
+    root->insertItem(item3, Location_OnRight);
+    QCOMPARE(root->separators_recursive().size(), 1);
+    QCOMPARE(root->separators_recursive().constFirst(), separator);
+    QCOMPARE(root->hostWidget()->numPooledSeparators(), 0);
+    QCOMPARE(Separator::numSeparators(), numSeparators);
+    QVERIFY(separator->asWidget()->isVisible());
+    QVERIFY(root->checkSanity());
+}
+
+namespace {
+struct VirtualSeparatorFactoryGuard
+{
+    VirtualSeparatorFactoryGuard()
+    {
+        Config::self().setSeparatorFactoryFunc([](Layouting::Widget *parent) {
+            return static_cast<Separator *>(new VirtualSeparator(parent));
+        });
+    }
+
+    ~VirtualSeparatorFactoryGuard()
+    {
+        Config::self().setSeparatorFactoryFunc([](Layouting::Widget *parent) {
+            return static_cast<Separator *>(new SeparatorWidget(parent));
+        });
+    }
+};
+
+struct LazyResizeGuard
+{
+    LazyResizeGuard()
+        : m_originalFlags(Config::self().flags())
+    {
+        Config::self().setFlags(Config::Flag::LazyResize);
+    }
+
+    ~LazyResizeGuard()
+    {
+        Config::self().setFlags(m_originalFlags);
+    }
+
+    const Config::Flags m_originalFlags;
+};
+}
+
+void TestMultiSplitter::tst_virtualSeparators()
+{
+    VirtualSeparatorFactoryGuard guard;
+    auto root = createRoot();
+    Item *item1 = createItem();
+    Item *item2 = createItem();
+    Item *item3 = createItem();
+    root->insertItem(item1, Location_OnLeft);
+    root->insertItem(item2, Location_OnRight);
+    ItemBoxContainer::insertItemRelativeTo(item3, item2, Location_OnBottom);
+    QVERIFY(root->checkSanity());
+
+    const Separator::List separators = root->separators_recursive();
+    QCOMPARE(separators.size(), 2);
+
+    QWidget *host = root->hostWidget()->asQWidget();
+    QVERIFY(host->findChildren<SeparatorWidget *>().isEmpty());
+    VirtualSeparatorHost *separatorHost = VirtualSeparatorHost::forHost(host);
+
+    for (Separator *separator : separators) {
+        QVERIFY(!separator->asWidget());
+        const QPoint center = separator->geometry().center();
+        QCOMPARE(root->separatorAt_recursive(center), separator);
+        QCOMPARE(static_cast<Separator *>(separatorHost->separatorAt(center)), separator);
+    }
+
+    QVERIFY(!root->separatorAt_recursive(item1->geometry().center()));
+    QVERIFY(!separatorHost->separatorAt(item1->geometry().center()));
+}
+
+void TestMultiSplitter::tst_virtualSeparatorsLazyResize()
+{
+    // Virtual separators have no widget, so everything must go through Separator::geometry()
+
+    VirtualSeparatorFactoryGuard factoryGuard;
+    LazyResizeGuard lazyResizeGuard;
+
+    auto root = createRoot();
+    Item *item1 = createItem();
+    Item *item2 = createItem();
+    Item *item3 = createItem();
+    root->insertItem(item1, Location_OnLeft);
+    root->insertItem(item2, Location_OnRight);
+    ItemBoxContainer::insertItemRelativeTo(item3, item2, Location_OnBottom);
+    QVERIFY(root->checkSanity());
+    root->dumpLayout();
+
+    QWidget *host = root->hostWidget()->asQWidget();
+    const QList<QRubberBand *> rubberBands = host->findChildren<QRubberBand *>();
+    QCOMPARE(rubberBands.size(), 2);
+
+    Separator *separator = root->separators().constFirst();
+    QVERIFY(!separator->asWidget());
+    const QPoint center = separator->geometry().center();
+    const QPoint globalCenter = host->mapToGlobal(center);
+
+    QMouseEvent press(QEvent::MouseButtonPress, center, globalCenter, Qt::LeftButton, Qt::LeftButton, Qt::NoModifier);
+    QApplication::sendEvent(host, &press);
+
+    QRubberBand *rubberBand = nullptr;
+    for (QRubberBand *candidate : rubberBands) {
+        if (!candidate->isHidden())
+            rubberBand = candidate;
+    }
+
+    QVERIFY(rubberBand);
+    QCOMPARE(rubberBand->geometry(), separator->geometry());
+
+    QMouseEvent release(QEvent::MouseButtonRelease, center, globalCenter, Qt::LeftButton, Qt::NoButton, Qt::NoModifier);
+    QApplication::sendEvent(host, &release);
+    QVERIFY(rubberBand->isHidden());
+    QVERIFY(root->checkSanity());
+}
+
+void TestMultiSplitter::tst_itemAtMatchesLinearScan()
+{
+    // Tests that the spatial index gives the same results as scanning every item
+
+    auto root = createRoot();
+    Item::List items;
+    for (int i = 0; i < 4; ++i) {
+        Item *columnItem = createItem();
+        root->insertItem(columnItem, Location_OnRight);
+        items << columnItem;
+        for (int j = 0; j < 3; ++j) {
+            Item *item = createItem();
+            ItemBoxContainer::insertItemRelativeTo(item, items.constLast(), Location_OnBottom);
+            items << item;
+        }
+    }
+
+    auto check = [&root] {
+        const Item::List leaves = root->items_recursive();
+        for (int x = 0; x < root->width(); x += 7) {
+            for (int y = 0; y < root->height(); y += 11) {
+                const QPoint p(x, y);
+                Item *expected = nullptr;
+                for (Item *item : leaves) {
+                    if (item->isVisible() && item->mapToRoot(item->rect()).contains(p)) {
+                        expected = item;
+                        break;
+                    }
+                }
+
+                if (root->itemAt_recursive(p) != expected)
+                    return false;
+            }
+        }
+        return true;
+    };
+
+    QVERIFY(root->checkSanity());
+    QVERIFY(check());
+
+    items.at(5)->turnIntoPlaceholder();
+    QVERIFY(check());
+
+    root->setSize_recursive(QSize(1500, 1200));
+    QVERIFY(check());
+
+    root->removeItem(items.at(0));
+    QVERIFY(check());
+}
+
+void TestMultiSplitter::tst_calculateSqueezes()
+{
+    // Tests that the closed-form distribution matches the iterative one it replaced, bit for bit
+
+    auto iterativeSqueezes = [](QVector<int> availabilities, int needed) {
+        QVector<int> squeezes(availabilities.size(), 0);
+        int missing = needed;
+        while (missing > 0) {
+            const auto numDonors = std::count_if(availabilities.cbegin(), availabilities.cend(), [](int num) {
+                return num > 0;
+            });
+
+            int toTake = missing / int(numDonors);
+            if (toTake == 0)
+                toTake = missing;
+
+            for (int i = 0; i < availabilities.size(); ++i) {
+                const int available = availabilities.at(i);
+                if (available == 0)
+                    continue;
+                const int took = qMin(missing, qMin(toTake, available));
+                availabilities[i] -= took;
+                missing -= took;
+                squeezes[i] += took;
+                if (missing == 0)
+                    break;
+            }
+        }
+        return squeezes;
+    };
+
+    auto root = createRoot();
+    const Qt::Orientation o = root->orientation();
+    quint32 seed = 1;
+    auto random = [&seed](int max) {
+        seed = seed * 1103515245 + 12345;
+        return int((seed >> 16) % quint32(max + 1));
+    };
+
+    for (int iteration = 0; iteration < 2000; ++iteration) {
+        const int count = 1 + random(10);
+        const int maxAvailable = random(1) ? 5 : 500;
+        SizingInfo::List sizes;
+        QVector<int> availabilities;
+        int total = 0;
+        for (int i = 0; i < count; ++i) {
+            SizingInfo info;
+            const int available = random(2) == 0 ? 0 : random(maxAvailable);
+            info.minSize = QSize(100, 100);
+            info.setLength(100 + available, o);
+            sizes << info;
+            availabilities << available;
+            total += available;
+        }
+
+        const int needed = random(total);
+        QVector<int> squeezes(count);
+        root->calculateSqueezes(sizes.cbegin(), sizes.cend(), needed,
+                                NeighbourSqueezeStrategy::AllNeighbours, squeezes.data());
+        QCOMPARE(squeezes, iterativeSqueezes(availabilities, needed));
+    }
+}
+
+void TestMultiSplitter::tst_flatItemTree()
+{
+    auto root = createRoot();
+    Item *item1 = createItem(QSize(200, 100));
+    Item *item2 = createItem();
+    Item *item3 = createItem(QSize(150, 300));
+    Item *item4 = createItem();
+    root->insertItem(item1, Location_OnLeft);
+    root->insertItem(item2, Location_OnRight);
+    ItemBoxContainer::insertItemRelativeTo(item3, item2, Location_OnBottom);
+    ItemBoxContainer::insertItemRelativeTo(item4, item3, Location_OnRight);
+    item1->turnIntoPlaceholder();
+    QVERIFY(root->checkSanity());
+
+    item2->setMaxSizeHint(QSize(5000, 5000));
+
+    // Containers' minSize() and maxSizeHint() read from the root's snapshot too, so the expected
+    // values are computed here from the leaves, following the rules of ItemBoxContainer
+    std::function<QSize(Item *)> expectedMinSize = [&expectedMinSize](Item *item) {
+        ItemBoxContainer *container = item->asBoxContainer();
+        if (!container)
+            return item->minSize();
+
+        int minW = 0;
+        int minH = 0;
+        int numVisible = 0;
+        for (Item *child : container->childItems()) {
+            if (!(child->isVisible() || child->isBeingInserted()))
+                continue;
+            numVisible++;
+            const QSize childMin = expectedMinSize(child);
+            if (container->isVertical()) {
+                minW = qMax(minW, childMin.width());
+                minH += childMin.height();
+            } else {
+                minH = qMax(minH, childMin.height());
+                minW += childMin.width();
+            }
+        }
+
+        const int separatorWaste = qMax(0, (numVisible - 1) * st);
+        return container->isVertical() ? QSize(minW, minH + separatorWaste) : QSize(minW + separatorWaste, minH);
+    };
+
+    std::function<QSize(Item *)> expectedMaxSize = [&expectedMaxSize, &expectedMinSize](Item *item) {
+        ItemBoxContainer *container = item->asBoxContainer();
+        if (!container)
+            return item->maxSizeHint();
+
+        const QSize hardcodedMax = Item::hardcodedMaximumSize;
+        int maxW = container->isVertical() ? hardcodedMax.width() : 0;
+        int maxH = container->isVertical() ? 0 : hardcodedMax.height();
+        const Item::List visibleChildren = container->visibleChildren(/*includeBeingInserted=*/false);
+        for (Item *child : visibleChildren) {
+            if (child->isBeingInserted())
+                continue;
+            const QSize childMax = expectedMaxSize(child);
+            if (container->isVertical()) {
+                maxW = qMin(maxW, childMax.width());
+                maxH = qMin(maxH + childMax.height(), hardcodedMax.height());
+            } else {
+                maxH = qMin(maxH, childMax.height());
+                maxW = qMin(maxW + childMax.width(), hardcodedMax.width());
+            }
+        }
+
+        if (!visibleChildren.isEmpty()) {
+            const int separatorWaste = int(visibleChildren.size() - 1) * st;
+            if (container->isVertical())
+                maxH = qMin(maxH + separatorWaste, hardcodedMax.height());
+            else
+                maxW = qMin(maxW + separatorWaste, hardcodedMax.width());
+        }
+
+        if (maxW == 0)
+            maxW = hardcodedMax.width();
+        if (maxH == 0)
+            maxH = hardcodedMax.height();
+
+        // Nothing is being inserted, so the visible children's min size is the container's
+        return QSize(maxW, maxH).expandedTo(expectedMinSize(container));
+    };
+
+    const Item::List leaves = root->items_recursive();
+    QVector<QSize> expectedMinSizes;
+    QVector<QSize> expectedMaxSizes;
+    QVector<QRect> expectedGeometries;
+    auto containers = [&root] {
+        Item::List result;
+        for (Item *item : root->items_recursive()) {
+            for (auto p = item->parentContainer(); p && !p->isRoot(); p = p->parentContainer()) {
+                if (!result.contains(p))
+                    result << p;
+            }
+        }
+        return result;
+    }();
+    QVERIFY(!containers.isEmpty());
+    for (Item *container : containers) {
+        expectedMinSizes << expectedMinSize(container);
+        expectedMaxSizes << expectedMaxSize(container);
+        expectedGeometries << container->mapToRoot(container->rect());
+        QCOMPARE(container->minSize(), expectedMinSizes.constLast());
+        QCOMPARE(container->maxSizeHint(), expectedMaxSizes.constLast());
+    }
+
+    FlatItemTree tree;
+    tree.build(root.get());
+    QVERIFY(tree.isUpToDate());
+    QCOMPARE(tree.size(), int(1 + leaves.size() + containers.size()));
+    QCOMPARE(tree.indexOf(root.get()), 0);
+    QCOMPARE(tree.parent(0), -1);
+    QCOMPARE(tree.subtreeEnd(0), tree.size());
+    QCOMPARE(tree.leaves(0), leaves);
+    QCOMPARE(tree.minSize(0), root->minSize());
+    QCOMPARE(tree.maxSizeHint(0), root->maxSizeHint());
+
+    for (int i = 0; i < containers.size(); ++i) {
+        const int index = tree.indexOf(containers.at(i));
+        QVERIFY(index > 0);
+        QVERIFY(tree.testFlag(index, FlatItemTree::Flag_IsContainer));
+        QCOMPARE(tree.minSize(index), expectedMinSizes.at(i));
+        QCOMPARE(tree.maxSizeHint(index), expectedMaxSizes.at(i));
+        QCOMPARE(tree.geometry(index), expectedGeometries.at(i));
+    }
+
+    for (Item *leaf : leaves) {
+        const int index = tree.indexOf(leaf);
+        QCOMPARE(tree.item(index), leaf);
+        QCOMPARE(tree.item(tree.parent(index)), leaf->parentContainer());
+        QCOMPARE(tree.subtreeEnd(index), index + 1);
+        QCOMPARE(tree.testFlag(index, FlatItemTree::Flag_IsVisible), leaf->isVisible());
+        QCOMPARE(tree.geometry(index), leaf->mapToRoot(leaf->rect()));
+    }
+
+    // Geometry changes only make the geometries stale, not the size constraints
+    root->setSize_recursive(root->size() + QSize(100, 100));
+    QVERIFY(!tree.isUpToDate());
+    QVERIFY(tree.constraintsAreUpToDate());
+
+    // Any change to the constraints makes it stale
+    item3->setMinSize(QSize(160, 300));
+    QVERIFY(!tree.isUpToDate());
+    QVERIFY(!tree.constraintsAreUpToDate());
+}
+
+void TestMultiSplitter::tst_geometryObserver()
+{
+    struct Observer : public ItemGeometryObserver
+    {
+        void itemGeometriesChanged(const QVector<Item *> &items) override
+        {
+            batches << items;
+        }
+        QVector<QVector<Item *>> batches;
+    };
+
+    auto root = createRoot();
+    Item *item1 = createItem();
+    Item *item2 = createItem();
+    Item *item3 = createItem();
+    root->insertItem(item1, Location_OnLeft);
+    root->insertItem(item2, Location_OnRight);
+    ItemBoxContainer::insertItemRelativeTo(item3, item2, Location_OnBottom);
+    auto nested = item2->parentBoxContainer();
+    QVERIFY(nested != root.get());
+
+    Observer observer;
+    s_expectedWarning = QStringLiteral("only supported on root containers");
+    nested->setGeometryObserver(&observer);
+    QVERIFY(!nested->geometryObserver());
+    s_expectedWarning.clear();
+    root->setGeometryObserver(&observer);
+    QCOMPARE(root->geometryObserver(), &observer);
+
+    // A resize is one transaction, and each item is reported once
+    root->setSize_recursive(root->size() + QSize(100, 50));
+    QCOMPARE(observer.batches.size(), 1);
+    const QVector<Item *> changed = observer.batches.constFirst();
+    QCOMPARE(changed.constFirst(), root.get());
+    for (Item *item : { static_cast<Item *>(root.get()), item1, item2, item3, static_cast<Item *>(nested) })
+        QCOMPARE(changed.count(item), 1);
+
+    // Outside of a transaction it's reported immediately
+    observer.batches.clear();
+    item1->setGeometry(item1->geometry().adjusted(0, 0, -1, 0));
+    QCOMPARE(observer.batches.size(), 1);
+    QCOMPARE(observer.batches.constFirst(), QVector<Item *>({ item1 }));
+
+    // Qt signals still work when connected, regardless of the observer
+    QSignalSpy widthSpy(item1, &Item::widthChanged);
+    QSignalSpy xSpy(item2, &Item::xChanged);
+    item1->setGeometry(item1->geometry().adjusted(0, 0, 2, 0));
+    QCOMPARE(widthSpy.count(), 1);
+    nested->setGeometry(nested->geometry().translated(3, 0)); // children get xChanged() too
+    QCOMPARE(xSpy.count(), 1);
+
+    // Nested transactions flush at the outermost one, skipping deleted items
+    observer.batches.clear();
+    {
+        ItemContainer::GeometryTransaction outer(item1);
+        {
+            ItemContainer::GeometryTransaction inner(item3);
+            item1->setGeometry(item1->geometry().adjusted(0, 0, 1, 0));
+            item3->setGeometry(item3->geometry().adjusted(0, 0, 0, -1));
+        }
+        QVERIFY(observer.batches.isEmpty());
+        root->removeItem(item3); // deletes it
+    }
+    QCOMPARE(observer.batches.size(), 1);
+    QCOMPARE(observer.batches.constFirst().constFirst(), item1);
+    QCOMPARE(observer.batches.constFirst().count(item1), 1);
+    QVERIFY(observer.batches.constFirst().contains(item2)); // took item3's space
+
+    root->setGeometryObserver(nullptr);
+    observer.batches.clear();
+    item1->setGeometry(item1->geometry().adjusted(0, 0, -2, 0));
+    QVERIFY(observer.batches.isEmpty());
+}
+
+void TestMultiSplitter::tst_fastPathRestore()
+{
+    auto root = createRoot();
+    Item *item1 = createItem();
+    Item *item2 = createItem();
+    Item *item3 = createItem();
+    root->insertItem(item1, Location_OnLeft);
+    root->insertItem(item2, Location_OnRight);
+    ItemBoxContainer::insertItemRelativeTo(item3, item2, Location_OnBottom);
+
+    QHash<QString, Widget *> widgets;
+    for (Item *item : root->items_recursive())
+        if (auto w = static_cast<MyGuestWidget *>(item->guestAsQObject()))
+            widgets.insert(w->id(), w);
+
+    // An untouched layout is restored verbatim
+    QVariantMap serialized = root->toVariantMap();
+    const quint64 fastPathRestores = PerfCounters::value(PerfCounters::Counter_FastPathRestores);
+    {
+        ItemBoxContainer root2(root->hostWidget());
+        root2.fillFromVariantMap(serialized, widgets);
+        QCOMPARE(PerfCounters::value(PerfCounters::Counter_FastPathRestores), fastPathRestores + 1);
+        QVERIFY(root2.checkSanity());
+        const Item::List items = root2.items_recursive();
+        QCOMPARE(items.size(), 3);
+        QCOMPARE(items.at(0)->geometry(), item1->geometry());
+        QCOMPARE(items.at(2)->mapToRoot(items.at(2)->rect()), item3->mapToRoot(item3->rect()));
+    }
+
+    // Overlapping children aren't valid, the full relayout runs and fixes them
+    QVariantList children = serialized.value(QStringLiteral("children")).toList();
+    QVariantMap child = children.at(0).toMap();
+    QVariantMap sizingInfo = child.value(QStringLiteral("sizingInfo")).toMap();
+    sizingInfo[QStringLiteral("geometry")] = rectToMap(item1->geometry().adjusted(0, 0, 50, 0));
+    child[QStringLiteral("sizingInfo")] = sizingInfo;
+    children[0] = child;
+    serialized[QStringLiteral("children")] = children;
+    {
+        ItemBoxContainer root2(root->hostWidget());
+        root2.fillFromVariantMap(serialized, widgets);
+        QCOMPARE(PerfCounters::value(PerfCounters::Counter_FastPathRestores), fastPathRestores + 1);
+        QVERIFY(root2.checkSanity());
+    }
+}
+
+void TestMultiSplitter::tst_jsonStreamReader()
+{
+    {
+        // Unknown keys are skipped, whatever they contain
+        JsonStreamReader reader(R"({ "skip": {"a": [1, {"b": "}]\""}], "c": null},
+                                     "int": 42, "double": -2.5e1, "bool": true,
+                                     "string": "a\"\u00e9\ud83d\ude00\n", "list": ["x", "y"],
+                                     "esc\u0061ped": 1 })");
+        int intValue = 0;
+        double doubleValue = 0;
+        bool boolValue = false;
+        QString stringValue;
+        QStringList listValue;
+        QString escapedKey;
+        QVERIFY(reader.beginObject());
+        while (reader.nextKey()) {
+            switch (reader.keyHash()) {
+            case JsonStreamReader::hashKey("int"):
+                intValue = reader.readInt();
+                break;
+            case JsonStreamReader::hashKey("double"):
+                doubleValue = reader.readDouble();
+                break;
+            case JsonStreamReader::hashKey("bool"):
+                boolValue = reader.readBool();
+                break;
+            case JsonStreamReader::hashKey("string"):
+                stringValue = reader.readString();
+                break;
+            case JsonStreamReader::hashKey("list"):
+                listValue = reader.readStringList();
+                break;
+            case JsonStreamReader::hashKey("escaped"):
+                escapedKey = reader.key();
+                reader.skipValue();
+                break;
+            default:
+                reader.skipValue();
+            }
+        }
+        QVERIFY(!reader.hasError());
+        QVERIFY(reader.atEnd());
+        QCOMPARE(intValue, 42);
+        QCOMPARE(doubleValue, -25.0);
+        QVERIFY(boolValue);
+        QCOMPARE(stringValue, QString::fromUtf8("a\"\xC3\xA9\xF0\x9F\x98\x80\n"));
+        QCOMPARE(listValue, QStringList({ "x", "y" }));
+        QCOMPARE(escapedKey, QStringLiteral("escaped"));
+    }
+
+    // Malformed input
+    for (const char *json : { R"({"a": 1)", R"({"a": 1,})", R"({"a" 1})", R"({"a": [1}})", R"({} x)", R"({"a": tru})" }) {
+        JsonStreamReader reader(json);
+        if (reader.beginObject()) {
+            while (reader.nextKey())
+                reader.skipValue();
+        }
+        QVERIFY2(!reader.atEnd(), json);
+    }
+
+    // A layout read from JSON is the same as the one which was saved
+    auto root = createRoot();
+    Item *item1 = createItem();
+    Item *item2 = createItem();
+    Item *item3 = createItem();
+    root->insertItem(item1, Location_OnLeft);
+    root->insertItem(item2, Location_OnRight);
+    ItemBoxContainer::insertItemRelativeTo(item3, item2, Location_OnBottom);
+    item3->turnIntoPlaceholder();
+
+    const QVariantMap serialized = root->toVariantMap();
+    JsonStreamReader reader(QJsonDocument::fromVariant(serialized).toJson());
+    ItemRecord record;
+    record.fromJsonStream(reader);
+    QVERIFY(reader.atEnd());
+    QVERIFY(!record.isNull);
+    QCOMPARE(record.toVariantMap(), serialized);
+}
+
 int main(int argc, char *argv[])
 {
     bool qpaPassed = false;